@@ -59,19 +59,21 @@ public:
 
 	void write(const std::string& mesg)
 	{
+		// Reserve the header in front, it is encoded in place.
 		NetBuffer buff;
+		buff.reserve_prependable(Codec::kPrependSize);
 		buff.append(mesg.data(), mesg.size());
 
 		AutoLock locked(lock_);
 		if (connection_) {
-			codec_->send(connection_, &buff);
+			codec_->send_take(connection_, &buff);
 		}
 	}
 
 private:
 	void on_connect(const TcpConnectionPtr& conn);
 	void on_close(const TcpConnectionPtr& conn);
-	void on_message(const TcpConnectionPtr& conn, NetBuffer* mesg, TimeStamp);
+	void on_message(const TcpConnectionPtr& conn, const StringPiece& mesg, TimeStamp);
 
 private:
 	TcpClientPtr client_;
@@ -101,9 +103,9 @@ void ChatClient::on_close(const TcpConnectionPtr& conn)
 	connection_.reset();
 }
 
-void ChatClient::on_message(const TcpConnectionPtr& conn, NetBuffer* mesg, TimeStamp)
+void ChatClient::on_message(const TcpConnectionPtr& conn, const StringPiece& mesg, TimeStamp)
 {
-	::printf("<<< %s\n", mesg->to_string().c_str());
+	::printf("<<< %s\n", mesg.as_string().c_str());
 }
 
 int main(int argc, char* argv[])
@@ -55,7 +55,7 @@ public:
 private:
 	void on_connect(const TcpConnectionPtr& conn);
 	void on_close(const TcpConnectionPtr& conn);
-	void on_message(const TcpConnectionPtr& conn, NetBuffer* mesg, TimeStamp);
+	void on_message(const TcpConnectionPtr& conn, const StringPiece& mesg, TimeStamp);
 
 private:
 	TcpServerPtr server_;
@@ -85,7 +85,7 @@ void ChatServer::on_close(const annety::TcpConnectionPtr& conn)
 	connections_.erase(conn);
 }
 
-void ChatServer::on_message(const TcpConnectionPtr& conn, NetBuffer* mesg, TimeStamp)
+void ChatServer::on_message(const TcpConnectionPtr& conn, const StringPiece& mesg, TimeStamp)
 {
 	// broadcast
 	AutoLock locked(lock_);
@@ -57,7 +57,7 @@ public:
 private:
 	void on_connect(const TcpConnectionPtr& conn);
 	void on_close(const TcpConnectionPtr& conn);
-	void on_message(const TcpConnectionPtr& conn, NetBuffer* mesg, TimeStamp);
+	void on_message(const TcpConnectionPtr& conn, const StringPiece& mesg, TimeStamp);
 
 private:
 	TcpServerPtr server_;
@@ -99,7 +99,7 @@ void ChatServer::on_close(const annety::TcpConnectionPtr& conn)
 	connections_->erase(conn);
 }
 
-void ChatServer::on_message(const TcpConnectionPtr& conn, NetBuffer* mesg, TimeStamp)
+void ChatServer::on_message(const TcpConnectionPtr& conn, const StringPiece& mesg, TimeStamp)
 {
 	ConnectionListPtr connections;
 	{
@@ -107,10 +107,21 @@ void ChatServer::on_message(const TcpConnectionPtr& conn, NetBuffer* mesg, TimeS
 		connections = connections_;
 	}
 
+	// Encode once, all connections share the same bytes.
+	NetBuffer buff(ByteBuffer::kUnLimitSize, Codec::kPrependSize + mesg.size() + sizeof(uint32_t));
+	buff.reserve_prependable(Codec::kPrependSize);
+	buff.append(mesg);
+	if (codec_->encode(&buff) != 1) {
+		LOG(ERROR) << "ChatServer - encode message failed";
+		return;
+	}
+	std::shared_ptr<const NetBuffer> message = 
+		std::make_shared<const NetBuffer>(std::move(buff));
+
 	// broadcast. no lock
 	ConnectionList::iterator it = connections->begin();
 	for (; it != connections->end(); ++it) {
-		codec_->send(*it, mesg);
+		(*it)->send(message);
 	}
 }
 
@@ -0,0 +1,114 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#ifndef ANT_ASYNC_LOGGING_H_
+#define ANT_ASYNC_LOGGING_H_
+
+#include "Macros.h"
+#include "TimeStamp.h"
+#include "ByteBuffer.h"
+#include "files/FilePath.h"
+#include "strings/StringPiece.h"
+#include "synchronization/MutexLock.h"
+#include "synchronization/ConditionVariable.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <stdint.h>		// int64_t
+#include <sys/types.h>	// size_t,off_t
+
+namespace annety
+{
+// Example:
+// // AsyncLogging
+// std::unique_ptr<AsyncLogging> g_async_log;
+//
+// void output_func(const char* msg, int len)
+// {
+// 	g_async_log->append(msg, len);
+// }
+//
+// g_async_log.reset(new AsyncLogging(FilePath("logging"), 100*1024*1024));
+// g_async_log->start();
+// set_log_output_handler(output_func);
+//
+// LOG(INFO) << "Hello AsyncLogging";
+// ...
+// g_async_log->stop();
+// ...
+
+class Thread;
+
+// The asynchronous logging backend of LogFile (double buffering).
+//
+// The front-end threads append messages into the current buffer, the full
+// buffers are handed over to a backend thread, which calls LogFile::append()
+// in bulk. The backend writes the current buffer every |flush_interval_s|
+// even if it is not full.
+//
+// There are at most |max_buffer_size| full buffers waiting for writing, the
+// messages are dropped (and counted) when the disk is falling behind. The
+// messages longer than kBufferSize are truncated (and counted as dropped).
+class AsyncLogging
+{
+public:
+	static const size_t kBufferSize = 4*1024*1024;
+
+	AsyncLogging(const FilePath& path /*basename*/,
+				 off_t rotate_size_b = 100*1024*1024,
+				 double flush_interval_s = 3.0,
+				 size_t max_buffer_size = 16);
+
+	~AsyncLogging();
+
+	void start();
+	void stop();
+
+	// *Thread safe*
+	void append(const StringPiece& message);
+	void append(const char* message, int len);
+
+	// *Thread safe*
+	// Wake up the backend to write the current buffer.
+	void flush();
+
+	// The number of messages has been dropped (or truncated).
+	int64_t dropped_count() const
+	{
+		return dropped_total_.load(std::memory_order_relaxed);
+	}
+
+private:
+	using Buffer = ByteBuffer;
+	using BufferPtr = std::unique_ptr<Buffer>;
+	using BufferVector = std::vector<BufferPtr>;
+
+	void thread_func();
+
+	// *Thread safe*
+	void count_dropped();
+
+private:
+	const FilePath path_;
+	const off_t rotate_size_b_;
+	const TimeDelta flush_interval_;
+	const size_t max_buffer_size_;
+
+	std::atomic<bool> running_{false};
+	std::atomic<int64_t> dropped_{0};
+	std::atomic<int64_t> dropped_total_{0};
+	std::unique_ptr<Thread> thread_;
+
+	MutexLock lock_;
+	ConditionVariable cond_;
+	BufferPtr current_;
+	BufferPtr next_;
+	BufferVector buffers_;
+
+	DISALLOW_COPY_AND_ASSIGN(AsyncLogging);
+};
+
+}	// namespace annety
+
+#endif	// ANT_ASYNC_LOGGING_H_
@@ -0,0 +1,286 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#ifndef ANT_BINARY_LOGGING_H_
+#define ANT_BINARY_LOGGING_H_
+
+#include "Macros.h"
+#include "Logging.h"
+#include "TimeStamp.h"
+#include "files/FilePath.h"
+#include "strings/StringPiece.h"
+#include "synchronization/MutexLock.h"
+#include "synchronization/ConditionVariable.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>		// int64_t,uint32_t
+#include <string.h>		// ::memcpy
+#include <sys/types.h>	// size_t,off_t,ssize_t
+
+namespace annety
+{
+// Example:
+// // BinaryLogging
+// BinaryLogging blog(FilePath("tracing"));
+// blog.start();
+//
+// BLOG(DEBUG, "recv {} bytes from {} at {}", n, conn->name(), TimeStamp::now());
+// ...
+// blog.stop();
+//
+// // Renders the binary logs to text offline.
+// $ binlog_decoder tracing.20261017-101010.host.1234.log ...
+// ...
+
+// The format site of a BLOG(), it is registered once (the static of the
+// site), then the records only carry its id. The "{}" in |format| are the
+// placeholders of arguments.
+class BinaryLogSite
+{
+public:
+	BinaryLogSite(const char* format, const LogMessage::Filename& file,
+				  int line, LogSeverity severity);
+
+	const char* format() const { return format_;}
+	StringPiece file() const { return StringPiece(file_.basename_, file_.size_);}
+	int line() const { return line_;}
+	LogSeverity severity() const { return severity_;}
+	uint32_t id() const { return id_;}
+
+private:
+	const char* format_;
+	LogMessage::Filename file_;
+	int line_;
+	LogSeverity severity_;
+	uint32_t id_;
+
+	DISALLOW_COPY_AND_ASSIGN(BinaryLogSite);
+};
+
+namespace internal
+{
+// The type tags of the arguments of a record.
+enum BinaryLogArg : uint8_t
+{
+	kArgInt = 1,	// int64_t
+	kArgUInt,		// uint64_t
+	kArgDouble,		// double
+	kArgBool,		// uint8_t
+	kArgChar,		// char
+	kArgString,		// uint32_t length + bytes
+	kArgPointer,	// uint64_t
+	kArgTimeStamp,	// int64_t microseconds
+	kArgFloat,		// float
+};
+
+// Copies the raw bytes of arguments into a record (no formatting), the
+// string is truncated when the record is full.
+class BinaryLogEncoder
+{
+public:
+	BinaryLogEncoder(char* buff, size_t size)
+		: begin_(buff), curr_(buff), end_(buff + size) {}
+
+	size_t size() const { return curr_ - begin_;}
+
+	void put(bool v) { put_raw<uint8_t>(kArgBool, v? 1: 0);}
+	void put(char v) { put_raw<char>(kArgChar, v);}
+
+	void put(int v) { put_raw<int64_t>(kArgInt, v);}
+	void put(long v) { put_raw<int64_t>(kArgInt, v);}
+	void put(long long v) { put_raw<int64_t>(kArgInt, v);}
+	void put(unsigned int v) { put_raw<uint64_t>(kArgUInt, v);}
+	void put(unsigned long v) { put_raw<uint64_t>(kArgUInt, v);}
+	void put(unsigned long long v) { put_raw<uint64_t>(kArgUInt, v);}
+
+	void put(float v) { put_raw<float>(kArgFloat, v);}
+	void put(double v) { put_raw<double>(kArgDouble, v);}
+
+	void put(const TimeStamp& v)
+	{
+		put_raw<int64_t>(kArgTimeStamp, (v - TimeStamp()).in_microseconds());
+	}
+
+	void put(const void* v)
+	{
+		put_raw<uint64_t>(kArgPointer, reinterpret_cast<uintptr_t>(v));
+	}
+	template <typename T>
+	void put(const T* v)
+	{
+		put(static_cast<const void*>(v));
+	}
+
+	void put(const char* v) { put(v? StringPiece(v): StringPiece("(*null*)"));}
+	void put(char* v) { put(static_cast<const char*>(v));}
+	void put(const std::string& v) { put(StringPiece(v));}
+	void put(const StringPiece& v);
+
+private:
+	template <typename T>
+	void put_raw(BinaryLogArg tag, T v)
+	{
+		if (curr_ + 1 + sizeof(T) <= end_) {
+			*curr_++ = static_cast<char>(tag);
+			::memcpy(curr_, &v, sizeof(T));
+			curr_ += sizeof(T);
+		}
+	}
+
+private:
+	char* begin_;
+	char* curr_;
+	char* end_;
+};
+
+inline void encode_args(BinaryLogEncoder*) {}
+
+template <typename T, typename... Args>
+void encode_args(BinaryLogEncoder* enc, const T& first, const Args&... rest)
+{
+	enc->put(first);
+	encode_args(enc, rest...);
+}
+
+// The record: uint32_t size | uint32_t site id | int64_t microseconds | args
+const size_t kBinaryLogHeaderSize = 16;
+const size_t kBinaryLogMaxRecordSize = 4096;
+
+// Fills the header of |record|, then pushes it into the ring of thread. It
+// is rendered as a LOG() instead, if the BinaryLogging is not running.
+void binary_log_record(const BinaryLogSite& site, char* record, size_t args_size);
+
+}	// namespace internal
+
+// Records the site id and the raw bytes of |args|, the text is formatted
+// later by the decoder.
+template <typename... Args>
+void binary_log(const BinaryLogSite& site, const Args&... args)
+{
+	char record[internal::kBinaryLogMaxRecordSize];
+	internal::BinaryLogEncoder enc(record + internal::kBinaryLogHeaderSize,
+		sizeof(record) - internal::kBinaryLogHeaderSize);
+	internal::encode_args(&enc, args...);
+	internal::binary_log_record(site, record, enc.size());
+}
+
+#define BLOG(severity, format, ...)										\
+	do {																\
+		if (LOG_IS_ON(severity)) {										\
+			static const annety::BinaryLogSite ant_blog_site(format,	\
+				__FILE__, __LINE__, annety::LOG_ ## severity);			\
+			annety::binary_log(ant_blog_site, ##__VA_ARGS__);			\
+		}																\
+	} while (false)
+
+class Thread;
+class BinaryLogDecoder;
+
+// The backend of BLOG(). The records are pushed into the ring of each thread
+// (no lock, and no formatting), the backend thread drains the rings every
+// |poll_interval_s|, then writes them by LogFile. The new format sites are
+// written before their records, so the binary logs are decoded offline (by
+// binlog_decoder), or they are rendered to text by the backend.
+//
+// The records are dropped (and counted) when the ring of thread is full,
+// and so are the records that are pushed by the other threads while stop()
+// is running (after the last drain).
+// The FATAL records are always logged by LOG() (then abort).
+class BinaryLogging
+{
+public:
+	static const size_t kDefaultRingSize = 1024*1024;
+
+	BinaryLogging(const FilePath& path /*basename*/,
+				  off_t rotate_size_b = 100*1024*1024,
+				  double poll_interval_s = 0.01,
+				  double flush_interval_s = 3.0,
+				  size_t ring_size_b = kDefaultRingSize);
+
+	~BinaryLogging();
+
+	// Renders the records to text in the backend, rather than the binary.
+	// *Not thread safe*, but usually be called before start().
+	void set_text_output(bool on)
+	{
+		text_output_ = on;
+	}
+
+	// Only one BinaryLogging is running in the process.
+	void start();
+	void stop();
+
+	// The number of records has been dropped.
+	// *Thread safe*
+	static int64_t dropped_count();
+
+private:
+	void thread_func();
+
+	// Drains the rings into |blocks|, the blocks of the new sites are in
+	// front of the records.
+	void collect(std::string* blocks);
+
+private:
+	const FilePath path_;
+	const off_t rotate_size_b_;
+	const TimeDelta poll_interval_;
+	const TimeDelta flush_interval_;
+	const size_t ring_size_b_;
+	bool text_output_{false};
+
+	std::atomic<bool> running_{false};
+	std::unique_ptr<Thread> thread_;
+	size_t written_sites_{0};
+
+	MutexLock lock_;
+	ConditionVariable cond_;
+
+	DISALLOW_COPY_AND_ASSIGN(BinaryLogging);
+};
+
+// Renders the binary logs to text lines, as the lines of LOG().
+//
+// NOTE: The records of a drain are written as one block per thread, so the
+// lines are in time order within a thread, but not across the threads (the
+// lines of a drain are interleaved within |poll_interval_s|). Sort them by
+// the time stamp if the global order matters.
+// *Not thread safe*
+class BinaryLogDecoder
+{
+public:
+	BinaryLogDecoder() = default;
+
+	// Decodes the blocks of |data|, the lines are appended to |text|.
+	// Returns the number of bytes decoded, the rest (an incomplete block)
+	// should be decoded again with the following data. Returns -1 if
+	// |data| is corrupted.
+	ssize_t decode(const char* data, size_t len, std::string* text);
+
+private:
+	struct Site
+	{
+		LogSeverity severity;
+		int line;
+		std::string file;
+		std::string format;
+	};
+
+	bool decode_site(const char* data, size_t len);
+	bool decode_records(const char* data, size_t len, std::string* text);
+
+private:
+	std::unordered_map<uint32_t, Site> sites_;
+
+	int64_t last_second_{-1};
+	std::string format_ymdhis_;
+
+	DISALLOW_COPY_AND_ASSIGN(BinaryLogDecoder);
+};
+
+}	// namespace annety
+
+#endif	// ANT_BINARY_LOGGING_H_
@@ -51,7 +51,7 @@ namespace annety
 // @coding
 // +-------------------+------------------+------------------+
 // |  has read bytes   |  readable bytes  |  writable bytes  |
-// |                   |     (CONTENT)    |                  |
+// |  (prependable)    |     (CONTENT)    |                  |
 // +-------------------+------------------+------------------+
 // |                   |                  |                  |
 // 0      <=      readerIndex   <=   writerIndex    <=     size
@@ -72,26 +72,28 @@ public:
 	~ByteBuffer() = default;
 	
 	// move method
-	ByteBuffer(ByteBuffer&& rhs) 
+	ByteBuffer(ByteBuffer&& rhs) noexcept
 		: max_size_(rhs.max_size_)
 		, reader_index_(rhs.reader_index_)
 		, writer_index_(rhs.writer_index_)
+		, scanned_bytes_(rhs.scanned_bytes_)
 		, buffer_(std::move(rhs.buffer_))
 	{
 		rhs.reset();
 	}
-	ByteBuffer& operator=(ByteBuffer&& rhs)
+	ByteBuffer& operator=(ByteBuffer&& rhs) noexcept
 	{
 		swap(rhs);
 		rhs.reset();
 		return *this;
 	}
 
-	void swap(ByteBuffer& rhs)
+	void swap(ByteBuffer& rhs) noexcept
 	{
 		std::swap(max_size_, rhs.max_size_);
 		std::swap(reader_index_, rhs.reader_index_);
 		std::swap(writer_index_, rhs.writer_index_);
+		std::swap(scanned_bytes_, rhs.scanned_bytes_);
 		buffer_.swap(rhs.buffer_);
 	}
 	
@@ -99,8 +101,12 @@ public:
 	{
 		reader_index_ = 0;
 		writer_index_ = 0;
+		scanned_bytes_ = 0;
 	}
 
+	// kUnLimitSize means the buffer can grow automatically.
+	ssize_t max_size() const { return max_size_;}
+
 	size_t readable_bytes() const
 	{
 		assert(writer_index_ >= reader_index_);
@@ -121,6 +127,25 @@ public:
 		return vbytes - writer_index_; 
 	}
 
+	// The has read bytes in front of the readable bytes, a header can be
+	// prepended into them without moving the readable bytes.
+	size_t prependable_bytes() const
+	{
+		return reader_index_;
+	}
+
+	// Reserves |len| prependable bytes of the empty buffer, the following 
+	// append() is written after them.
+	void reserve_prependable(size_t len)
+	{
+		assert(readable_bytes() == 0);
+		reset();
+		ensure_writable_bytes(len);
+		if (writable_bytes() >= len) {
+			reader_index_ = writer_index_ = len;
+		}
+	}
+
 	char *begin_read()
 	{
 		assert(reader_index_ <= writer_index_);
@@ -153,6 +178,7 @@ public:
 	{
 		if (len < readable_bytes()) {
 			reader_index_ += len;
+			scanned_bytes_ = scanned_bytes_ > len? scanned_bytes_ - len: 0;
 		} else {
 			reset();
 		}
@@ -163,6 +189,20 @@ public:
 		reset();
 	}
 
+	// The leading readable bytes that have been scanned by a decoder without
+	// finding its delimiter, so the next scan (after more bytes are written)
+	// can start from them. It follows the read index, and is cleared when the
+	// buffer is reset or bytes are prepended.
+	size_t scanned_bytes() const
+	{
+		return std::min(scanned_bytes_, readable_bytes());
+	}
+	void set_scanned_bytes(size_t len)
+	{
+		assert(len <= readable_bytes());
+		scanned_bytes_ = len;
+	}
+
 	std::string to_string() const
 	{
 		return std::string(begin_read(), readable_bytes());
@@ -206,6 +246,15 @@ public:
 		return false;
 	}
 	
+	// Prepend |data| in front of the readable bytes, into the prependable 
+	// bytes if it is enough, otherwise the readable bytes are moved back.
+	// buffer_ memory may be reallocated or migrated
+	bool prepend(const void* data, size_t len)
+	{
+		return prepend(static_cast<const char*>(data), len);
+	}
+	bool prepend(const char* data, size_t len);
+
 	// buffer_ memory may be reallocated or migrated
 	void ensure_writable_bytes(size_t len)
 	{
@@ -235,6 +284,7 @@ private:
 	ssize_t max_size_{kUnLimitSize};
 	size_t reader_index_{0};
 	size_t writer_index_{0};
+	size_t scanned_bytes_{0};
 	std::vector<char> buffer_;
 };
 
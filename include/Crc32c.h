@@ -18,10 +18,47 @@ extern uint32_t crc32_table16[];
 extern uint32_t crc32_table256[];
 }	// namespace anonymous
 
-// The code is based on the algorithm described at core/ngx_crc32.h
+// The crc32_short()/crc32_long()/crc32_update() are the CRC32 of IEEE 
+// polynomial (0xEDB88320), the code is based on the algorithm described at 
+// core/ngx_crc32.h
+//
+// The crc32c() is the CRC32C of Castagnoli polynomial (0x82F63B78). It runs
+// the SSE4.2 crc32 instruction (three streams are interleaved for the long
+// buffer) if the cpu supports it, otherwise the slicing-by-8 tables.
 class Crc32c
 {
 public:
+	// The polynomial of the checksum of frame, both peers must be the same.
+	enum POLYNOMIAL
+	{
+		kCrc32Ieee = 0,		// 0xEDB88320, crc32_short()/crc32_long()
+		kCrc32Castagnoli,	// 0x82F63B78, crc32c()
+	};
+
+	// The checksum of |polynomial|.
+	static uint32_t checksum(POLYNOMIAL polynomial, const char *buff, size_t len)
+	{
+		if (polynomial == kCrc32Castagnoli) {
+			return crc32c(buff, len);
+		}
+		return crc32_ieee(buff, len);
+	}
+
+	// crc32c, the runtime dispatched implementation.
+	static uint32_t crc32c(const char *buff, size_t len)
+	{
+		return crc32c_extend(0, buff, len);
+	}
+
+	// Extend the |crc| of the previous bytes with |buff|.
+	static uint32_t crc32c_extend(uint32_t crc, const char *buff, size_t len);
+
+	// crc32 by the slicing-by-8 tables, the same value of crc32_long().
+	static uint32_t crc32_ieee(const char *buff, size_t len);
+
+	// Returns true if crc32c() runs the SSE4.2 crc32 instruction.
+	static bool is_hardware_accelerated();
+
 	static uint32_t crc32_short(const StringPiece& buff)
 	{
 		return crc32_short(buff.data(), buff.size());
@@ -10,6 +10,8 @@
 #include "CallbackForward.h"
 #include "threading/ThreadForward.h"
 #include "synchronization/MutexLock.h"
+#include "containers/MpscQueue.h"
+#include "containers/InlineFunction.h"
 
 #include <vector>
 #include <atomic>
@@ -37,8 +39,32 @@ public:
 	using Functor = std::function<void()>;
 
 	static const int kPollTimeoutMs = 30*1000; // -1
-
-	EventLoop();
+	static const size_t kSpillBufferSize = 64*1024;
+
+	// IO Multiplexing backend of the loop.
+	// kPollerDefault is resolved by the `ANNETY_POLLER` environment variable 
+	// ("poll", "epoll" or "epoll-et"), otherwise it is epoll(4) on Linux and 
+	// poll(2) on the other platforms.
+	enum PollerType
+	{
+		kPollerDefault,
+		kPollerPoll,
+		kPollerEPoll,
+		kPollerEPollET,
+	};
+
+	// Timer pool backend of the loop.
+	// kTimerDefault is resolved by the `ANNETY_TIMER` environment variable 
+	// ("tree" or "wheel"), otherwise it is the balanced tree.
+	enum TimerType
+	{
+		kTimerDefault,
+		kTimerTree,
+		kTimerWheel,
+	};
+
+	explicit EventLoop(PollerType type = kPollerDefault, 
+					   TimerType timer_type = kTimerDefault);
 	
 	~EventLoop();
 	
@@ -54,7 +80,11 @@ public:
 
 	// Timers method ---------------------------------
 
-	// Runs callback at time seconds.
+	// The timers run on the monotonic clock (TimeStamp::now_monotonic()),
+	// so they are not misfired by the adjustment of the system clock.
+
+	// Runs callback at time seconds (UTC). It is converted to the monotonic
+	// time when it is added.
 	// *Thread safe*
 	TimerId run_at(double time_s, TimerCallback cb);
 	TimerId run_at(TimeStamp time, TimerCallback cb);
@@ -101,6 +131,39 @@ public:
 	void check_in_own_loop() const;
 	bool is_in_own_loop() const;
 
+	// The loop of the calling thread, or nullptr.
+	// *Thread safe*
+	static EventLoop* get_current_loop();
+
+	// Whether the connection channels of this loop are registered with 
+	// edge-triggered events. When it is true, the read/write handlers must 
+	// drain the file descriptor until EAGAIN.
+	// *Thread safe*
+	PollerType poller_type() const { return poller_type_;}
+	bool is_edge_triggered() const { return poller_type_ == kPollerEPollET;}
+
+	// *Thread safe*
+	TimerType timer_type() const { return timer_type_;}
+
+	// The cached UTC time of the loop, it is refreshed once per iteration
+	// (when the poller returns), which is the receive time of the events.
+	// It is stale in a long callback, use TimeStamp::now() if it matters.
+	// *Not thread safe*, but run in own loop thread.
+	TimeStamp loop_time() const { return poll_active_ms_;}
+
+	// The cached monotonic time of the loop, it is refreshed once per 
+	// iteration as loop_time(). The in-loop timers are added and reset on it.
+	// It is TimeStamp::now_monotonic() out of the loop (the other threads, 
+	// or before loop()).
+	// *Thread safe*
+	TimeStamp loop_monotonic_time() const;
+
+	// The spill buffer (kSpillBufferSize bytes) shared by all connections 
+	// of the loop, the bytes exceed the input buffer of a connection are 
+	// read into it. It is allocated at the first call.
+	// *Not thread safe*, but run in own loop thread.
+	char* spill_buffer();
+
 private:
 	// wakeup the own loop thread.
 	// *Thread safe*
@@ -127,22 +190,33 @@ private:
 	std::unique_ptr<ThreadRef> owning_thread_ref_;
 
 	// IO Multiplexing.
+	const PollerType poller_type_;
 	std::unique_ptr<Poller> poller_;
 	
 	// Timer pool.
+	const TimerType timer_type_;
 	std::unique_ptr<TimerPool> timers_;
 
 	// client active channel.
-	TimeStamp poll_active_ms_;
+	TimeStamp poll_active_ms_{TimeStamp::now()};
+	TimeStamp poll_active_monotonic_;
 	ChannelList active_channels_;
 
+	// The spill buffer of NetBuffer::read_fd().
+	std::unique_ptr<char[]> spill_buffer_;
+
 	// wakeup socket/channel.
 	SelectableFDPtr wakeup_socket_;
 	std::unique_ptr<Channel> wakeup_channel_;
 
 	// wakeup task function.
-	MutexLock lock_;
-	std::vector<Functor> wakeup_functors_;
+	// Lock-free MPSC queue, the own loop thread is the only consumer.
+	// The `wakeup_socket_` is written once until the loop consumes the 
+	// queue (wakeup coalescing).
+	// The Functor is moved into the inline storage of the queue node, the
+	// node is the only allocation of the queue.
+	containers::MpscQueue<containers::InlineFunction<void(), 96>> wakeup_functors_;
+	std::atomic<bool> wakeup_pending_{false};
 
 	DISALLOW_COPY_AND_ASSIGN(EventLoop);
 };
@@ -27,9 +27,31 @@ namespace annety
 // logf.append("789", strlen("789"));
 // logf.flush();
 // ...
+//
+// // keeps 10 files (or 1GB) of the gzip segments, rotates every hour
+// logf.set_rotate_interval(TimeDelta::from_hours(1));
+// logf.set_max_files(10);
+// logf.set_max_total_size(1024*1024*1024);
+// logf.set_compress(true);
+// ...
 
 class File;
+class ThreadPool;
 
+// The log file of the basename |path|, it is rotated when the size exceeds
+// |rotate_size_b|, at the UTC midnight, or every rotate interval. The
+// file is named "path.Ymd-HMS.hostname.pid.log" ("path.Ymd-HMS-index..."
+// if it is rotated again in the same second).
+//
+// The next file ("path.next.hostname.pid") is pre-opened by a helper thread,
+// so the rotation is a swap of the file pointer in the thread of append().
+// The rotated file is closed, compressed and the oldest files are removed
+// (the retention policy) by the helper thread too. If the next file is not
+// ready (the helper is behind), it is opened synchronously. The helper is
+// started at the first rotation, and it removes the next files left by the
+// dead processes of this host.
+//
+// *Not thread safe*, the append() and rotate() are called by one thread.
 class LogFile
 {
 public:
@@ -45,21 +67,92 @@ public:
 	void flush();
 	void rotate(bool force = false);
 
+	// The rotation and retention policy.
+	// *Not thread safe*, but usually be called before append().
+
+	// Rotates every |interval| as well, it is null (never) by default.
+	void set_rotate_interval(TimeDelta interval)
+	{
+		rotate_interval_ = interval;
+	}
+
+	// Keeps at most |max_files| log files of the basename (the current one
+	// included), the oldest ones are removed. 0 is unlimited.
+	// The log files are "path.Ymd-HMS[-index].hostname.pid.log[.gz]", they are
+	// counted for all the processes, but the newest (current) file of each
+	// process and the next files are never removed.
+	void set_max_files(int max_files)
+	{
+		max_files_ = max_files;
+	}
+
+	// Keeps at most |max_total_size_b| bytes of the log files of the basename
+	// (the current one included), the oldest ones are removed. 0 is unlimited.
+	void set_max_total_size(int64_t max_total_size_b)
+	{
+		max_total_size_b_ = max_total_size_b;
+	}
+
+	// Compresses the rotated files into gzip (".gz"). It is ignored if it
+	// is built without zlib.
+	void set_compress(bool on);
+
+	// The name of the current log file.
+	// *Not thread safe*
+	FilePath filename() const
+	{
+		return filename_;
+	}
+
 private:
 	void append_unlocked(const char* message, int len);
 
+	// Opens the next file (at the temporary name), in the helper thread.
+	void prepare_next_file();
+
+	// Renames the next file to |filename| if it is |swapped| in, closes and
+	// compresses the rotated |file| (named |rotated|), then removes the oldest
+	// files and opens the next file, in the helper thread.
+	void finish_rotated_file(std::shared_ptr<File> file, const FilePath& rotated,
+							 const FilePath& filename, bool swapped);
+
+	// Removes the next files of the dead processes of this host, in the helper thread.
+	void remove_stale_next_files();
+
+	// Removes the oldest log files over the retention limits, in the helper thread.
+	void remove_expired_files(const FilePath& current);
+
 private:
 	const FilePath path_;
 	const off_t rotate_size_b_;
 	const int check_every_n_;
 	const TimeDelta flush_interval_s_;
 
+	// The temporary name of the pre-opened next file.
+	const FilePath next_path_;
+
+	TimeDelta rotate_interval_;
+	int max_files_{0};
+	int64_t max_total_size_b_{0};
+	bool compress_{false};
+
 	std::atomic<int> count_{0};
 	std::atomic<off_t> written_{0};
 
-	MutexLock lock_;
 	std::unique_ptr<File> file_;
+	FilePath filename_;
 	TimeStamp last_rotate_;
+	int64_t rotate_second_{0};
+	int rotate_index_{0};
+
+	MutexLock lock_;
+	// The next file, which is opened by the helper.
+	std::unique_ptr<File> next_file_;
+	// The next file is swapped in, but it is not renamed by the helper yet.
+	bool next_taken_{false};
+
+	// It is started at the first rotation.
+	std::unique_ptr<ThreadPool> helper_;
 };
 
 }	// namespace annety
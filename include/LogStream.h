@@ -9,6 +9,7 @@
 #include <iosfwd>	// std::basic_ostream,std::char_traits
 #include <limits>	// std::numeric_limits
 #include <string>
+#include <utility>	// std::move
 
 namespace annety
 {
@@ -29,8 +30,10 @@ class TimeDelta;
 // It is value sematics, which means that it can be copied or assigned.
 class LogStream
 {
+public:
 	static const int  kMaxBufferSize = 4096;
 
+private:
 	static const int kMaxNumericSize = 32;
 	
 	static_assert(kMaxNumericSize - 10 > std::numeric_limits<double>::digits10,
@@ -52,6 +55,13 @@ class LogStream
 
 public:
 	LogStream(ssize_t max_size = kMaxBufferSize) : buffer_(max_size) {}
+
+	// Formats into the storage of |buffer| (no allocation), such as the 
+	// reused buffer of thread. Get it back by take_buffer().
+	explicit LogStream(ByteBuffer&& buffer) : buffer_(std::move(buffer))
+	{
+		buffer_.reset();
+	}
 	
 	// copy-ctor, move-ctor, dtor and assignment
 	LogStream(const LogStream&) = default;
@@ -141,6 +151,12 @@ public:
 		return buffer_;
 	}
 
+	// The stream is empty after it.
+	ByteBuffer take_buffer()
+	{
+		return std::move(buffer_);
+	}
+
 private:
 	template<typename T>
 	LogStream& format_number(T);
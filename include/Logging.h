@@ -13,6 +13,7 @@
 #include "LogStream.h"
 #include "ScopedClearLastError.h"
 #include "TimeStamp.h"
+#include "strings/StringPiece.h"
 
 #include <sstream>
 #include <string>
@@ -95,6 +96,14 @@ LogFFlushHandlerFunction set_log_fflush_handler(LogFFlushHandlerFunction handler
 void set_min_log_severity(LogSeverity severity);
 LogSeverity get_min_log_severity();
 
+// The records are timed by the coarse clock (TimeStamp::now_coarse()), it
+// is much cheaper, but the resolution is the tick of kernel (1~4ms).
+void set_log_coarse_time(bool on);
+bool get_log_coarse_time();
+
+// The name of |severity| ("TRACE" ... "FATAL"), "UNKNOWN" if it is invalid.
+StringPiece log_severity_name(int severity);
+
 // internal. Used by LOG_IS_ON to lazy-evaluate stream arguments.
 bool should_logging_message(LogSeverity severity);
 
@@ -155,14 +164,15 @@ private:
 		Impl(int line, const Filename& file, LogSeverity sev, const std::string& msg, 
 			int err = 0);
 		
-		~Impl() = default;
+		~Impl();
 
 		void begin();
 		void endl();
 
 	public:
-		LogStream stream_{};
-		TimeStamp time_{TimeStamp::now()};
+		// Formats into the reused buffer of thread.
+		LogStream stream_;
+		TimeStamp time_{get_log_coarse_time()? TimeStamp::now_coarse(): TimeStamp::now()};
 
 		int line_{0};
 		Filename file_;
@@ -55,6 +55,27 @@ public:
 		append(&x, sizeof x);
 	}
 
+	// prepend int* to buffer ---------------------------------
+	void prepend_int64(int64_t x)
+	{
+		int64_t be64 = host_to_net64(x);
+		prepend(&be64, sizeof be64);
+	}
+	void prepend_int32(int32_t x)
+	{
+		int32_t be32 = host_to_net32(x);
+		prepend(&be32, sizeof be32);
+	}
+	void prepend_int16(int16_t x)
+	{
+		int16_t be16 = host_to_net16(x);
+		prepend(&be16, sizeof be16);
+	}
+	void prepend_int8(int8_t x)
+	{
+		prepend(&x, sizeof x);
+	}
+
 	// read int* from buffer ----------------------------------
 	int64_t read_int64()
 	{
@@ -127,6 +148,13 @@ public:
 	void has_read_int16() { has_read(sizeof(int16_t));}
 	void has_read_int8() { has_read(sizeof(int8_t));}
 
+	// Read from |fd| into the writable bytes, and then into the |spill| 
+	// buffer by readv(2). The spilled bytes are appended (buffer grows).
+	// Returns the result of readv(2), that is the writable bytes plus 
+	// |spill_len| at most.
+	ssize_t read_fd(int fd, int* err, char* spill, size_t spill_len);
+
+	// The spill buffer is thread local (64k bytes).
 	ssize_t read_fd(int fd, int* err = nullptr);
 };
 
@@ -0,0 +1,223 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#ifndef ANT_TCP_CLIENT_POOL_H_
+#define ANT_TCP_CLIENT_POOL_H_
+
+#include "Macros.h"
+#include "EndPoint.h"
+#include "TcpConnection.h"
+#include "CallbackForward.h"
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <functional>
+
+namespace annety
+{
+class EventLoop;
+class EventLoopPool;
+class TcpClientPool;
+using TcpClientPoolPtr = std::shared_ptr<TcpClientPool>;
+
+// Example:
+// // TcpClientPool
+// TcpClientPoolPtr pool = make_tcp_client_pool(&loop, "backend");
+// pool->add_endpoint(EndPoint("127.0.0.1", 1669));
+// pool->set_connection_num(4);
+// pool->set_thread_num(2);
+// pool->set_message_callback(...);
+// pool->start();
+// ...
+// TcpClientPool::Lease lease = pool->lease(EndPoint("127.0.0.1", 1669));
+// if (lease) {
+// 	lease.connection()->send(...);
+// }
+// ...
+
+// Keeps N warm connections per upstream EndPoint for the backend fan-out.
+//
+// The connections are distributed on the loops (round-robin), each one is
+// a TcpClient with the Connector retry enabled, so a closed connection is
+// reconnected with the back-off of Connector.
+//
+// lease() picks the connected connection that has the least outstanding
+// leases, the connections of the calling loop are preferred. A lease from
+// its own loop does not take any lock, the other threads load the shared
+// connection pointer by std::atomic_load().
+class TcpClientPool : public std::enable_shared_from_this<TcpClientPool>
+{
+public:
+	using ThreadInitCallback = std::function<void(EventLoop*)>;
+
+	struct Slot;
+
+	// A leased connection, the lease is returned when it destructs.
+	// It must be returned before the pool destructs.
+	// *Not thread safe*
+	class Lease
+	{
+	public:
+		Lease() = default;
+		Lease(Slot* slot, TcpConnectionPtr conn);
+		~Lease();
+
+		Lease(Lease&& rhs) noexcept;
+		Lease& operator=(Lease&& rhs) noexcept;
+
+		explicit operator bool() const { return !!conn_;}
+		const TcpConnectionPtr& connection() const { return conn_;}
+
+		// Return the lease now.
+		void release();
+
+		// Report the connection is broken (e.g. a request timeout), it is
+		// closed and reconnected by the Connector retry.
+		void fail();
+
+	private:
+		Slot* slot_{nullptr};
+		TcpConnectionPtr conn_;
+
+		DISALLOW_COPY_AND_ASSIGN(Lease);
+	};
+
+	~TcpClientPool();
+
+	const std::string& name() const { return name_;}
+
+	// *Not thread safe*, but usually be called before start().
+	void add_endpoint(const EndPoint& addr);
+
+	// The number of connections per EndPoint, default is one per loop.
+	// *Not thread safe*, but usually be called before start().
+	void set_connection_num(int num_conns);
+
+	// Runs the connections on an own EventLoopPool of |num_threads|.
+	// *Not thread safe*, but usually be called before start().
+	void set_thread_num(int num_threads);
+
+	// Runs the connections on the |loops| of the caller (such as the worker
+	// loops of TcpServer), so the upstream connections are leased in the
+	// same loop of the downstream connections.
+	// *Not thread safe*, but usually be called before start().
+	void set_loops(const std::vector<EventLoop*>& loops);
+
+	// Connect all connections, only the first call has effect.
+	void start();
+
+	// Disconnect all connections, and stop reconnecting.
+	void stop();
+
+	// Lease a connected connection of |addr|, or of any EndPoint.
+	// Returns an empty lease if there is no connected one.
+	// *Thread safe*
+	Lease lease(const EndPoint& addr);
+	Lease lease();
+
+	// The number of connected connections.
+	// *Thread safe*
+	int connected_count() const;
+
+	// *Not thread safe*, but usually be called before start().
+	void set_thread_init_callback(ThreadInitCallback cb)
+	{
+		thread_init_cb_ = std::move(cb);
+	}
+
+	// User registered callback functions.
+
+	// *Not thread safe*, but usually be called before start().
+	void set_connect_callback(ConnectCallback cb)
+	{
+		connect_cb_ = std::move(cb);
+	}
+	// *Not thread safe*, but usually be called before start().
+	void set_close_callback(CloseCallback cb)
+	{
+		close_cb_ = std::move(cb);
+	}
+	// *Not thread safe*, but usually be called before start().
+	void set_message_callback(MessageCallback cb)
+	{
+		message_cb_ = std::move(cb);
+	}
+	// *Not thread safe*, but usually be called before start().
+	void set_write_complete_callback(WriteCompleteCallback cb)
+	{
+		write_complete_cb_ = std::move(cb);
+	}
+
+	// A warm connection of an EndPoint.
+	// The `conn` is only stored in the `loop` thread.
+	struct Slot
+	{
+		Slot(EventLoop* l, TcpClientPtr c);
+		~Slot();
+
+		EventLoop* loop;
+		TcpClientPtr client;
+		TcpConnectionPtr conn;
+		std::atomic<bool> connected{false};
+		std::atomic<int> outstanding{0};
+	};
+
+private:
+	struct Upstream
+	{
+		EndPoint addr;
+		std::vector<std::unique_ptr<Slot>> slots;
+	};
+
+	// *Not thread safe*, but run in the loop thread of |slot|.
+	void handle_connect(Slot* slot, const TcpConnectionPtr& conn);
+	void handle_close(Slot* slot, const TcpConnectionPtr& conn);
+
+	// Picks the least outstanding slot of |upstream| (nullptr is any), in 
+	// the calling loop first.
+	// *Thread safe*
+	Lease select(const Upstream* upstream);
+	Slot* select_slot(const Upstream* upstream, const EventLoop* loop) const;
+
+	TcpClientPool(EventLoop* loop, const std::string& name);
+
+	void initialize();
+
+	friend TcpClientPoolPtr make_tcp_client_pool(EventLoop* loop,
+		const std::string& name);
+
+private:
+	EventLoop* owner_loop_;
+	const std::string name_;
+	bool initilize_{false};
+	int num_conns_{0};
+
+	// ATOMIC_FLAG_INIT is macro
+	std::atomic_flag started_ = ATOMIC_FLAG_INIT;
+
+	// ThreadPool of event loops, or the loops of caller.
+	std::unique_ptr<EventLoopPool> workers_;
+	std::vector<EventLoop*> loops_;
+
+	std::vector<std::unique_ptr<Upstream>> upstreams_;
+	std::atomic<int> connected_{0};
+
+	// User registered callback functions.
+	ConnectCallback connect_cb_;
+	CloseCallback close_cb_;
+	MessageCallback message_cb_;
+	WriteCompleteCallback write_complete_cb_;
+	ThreadInitCallback thread_init_cb_;
+
+	DISALLOW_COPY_AND_ASSIGN(TcpClientPool);
+};
+
+// Constructs an object of type TcpClientPoolPtr and wraps it.
+TcpClientPoolPtr make_tcp_client_pool(EventLoop* loop, const std::string& name);
+
+}	// namespace annety
+
+#endif	// ANT_TCP_CLIENT_POOL_H_
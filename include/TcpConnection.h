@@ -23,6 +23,7 @@ class Channel;
 class EventLoop;
 class SocketFD;
 class NetBuffer;
+class BufferChain;
 
 // Connection wrapper of TCP protocol.
 //
@@ -56,6 +57,12 @@ public:
 	void send(const void*, int);
 	void send(const StringPiece&);
 
+	// *Thread safe*
+	// Queue the shared immutable bytes without copying, so one encoded 
+	// message can be sent to many connections. Do not modify it any more.
+	void send(const std::shared_ptr<const NetBuffer>&);
+	void send(const std::shared_ptr<const std::string>&);
+
 	// *Thread safe*
 	// After the output buffer is sent, then handling shutdown 
 	// the writable channel.
@@ -70,6 +77,39 @@ public:
 	// TCP opens the Nagle algorithm by default. Turn off it.
 	void set_tcp_nodelay(bool on);
 
+	// *Not thread safe*, but run in own loop thread (e.g. message callback).
+	//
+	// Defer the writes of send() until the last uncork(), the sent bytes are
+	// queued in the output buffer, then they are flushed by writev(2) at once.
+	// The corks are nested. See ScopedCork.
+	void cork();
+	void uncork();
+	bool is_corked() const
+	{
+		return corked_ > 0;
+	}
+
+	// The input buffer is sized adaptively: it is allocated at the first 
+	// read, the expected size of a read is doubled after a full read and 
+	// halved after two small reads (kMinReadSize ~ kMaxReadSize). The 
+	// bytes exceed the input buffer are read into the spill buffer of loop.
+	//
+	// *Not thread safe*, but run in own loop thread (e.g. connect callback).
+	//
+	// Keep reading until EAGAIN (the socket is drained) in one readable 
+	// event, at most the read budget (256KB). The edge-triggered mode always 
+	// reads until EAGAIN.
+	void set_read_until_eagain(bool on)
+	{
+		read_until_eagain_ = on;
+	}
+	// Release the memory of the input buffer after it has been empty and 
+	// idle for |delay_s| seconds. <= 0 means never.
+	void set_input_shrink_delay(double delay_s)
+	{
+		input_shrink_delay_s_ = delay_s;
+	}
+
 	// *Not thread safe*, but run in own loop thread.
 	// Getter/Setter the connection context.
 	void set_context(const containers::Any& context) 
@@ -125,7 +165,6 @@ public:
 	void connect_destroyed();
 
 	NetBuffer* input_buffer();
-	NetBuffer* output_buffer();
 
 private:
 	enum StateE {kDisconnected, kConnecting, kConnected, kDisconnecting};
@@ -133,12 +172,33 @@ private:
 	void initialize_in_loop();
 
 	void handle_read(TimeStamp);
+	// Reads the rest after the read budget of edge-triggered mode.
+	void handle_read_more();
 	void handle_write();
+
+	// Adjust the expected size of next read by the bytes of a read.
+	void adjust_read_size(size_t n);
+	void shrink_input_buffer();
 	void handle_close();
 	void handle_error();
 
 	void send_in_loop(const StringPiece&);
 	void send_in_loop(const void*, size_t);
+	void send_in_loop(NetBuffer&);	// this one will swap data
+	void send_in_loop(const std::shared_ptr<const void>&, const StringPiece&);
+	void send_shared(std::shared_ptr<const void>, const StringPiece&);
+
+	// Flush the output buffer that was queued by the corked sends.
+	void flush_in_loop();
+	// Write the output buffer by writev(2), until it is empty or EAGAIN if 
+	// |until_eagain|, otherwise once. The writable event is enabled if some
+	// bytes are left, disabled if it is empty.
+	void drain_output(bool until_eagain);
+
+	// Returns the number of bytes written directly, -1 means the peer 
+	// endpoint has closed.
+	ssize_t write_in_loop(const void*, size_t);
+	void check_high_water_mark(size_t);
 
 	void shutdown_in_loop();
 	void force_close_in_loop();
@@ -178,9 +238,18 @@ private:
 	SelectableFDPtr connect_socket_;
 	std::unique_ptr<Channel> connect_channel_;
 
-	// socket buffer
+	// socket buffer. The output is a chain of segments flushed by writev(2).
 	std::unique_ptr<NetBuffer> input_buffer_;
-	std::unique_ptr<NetBuffer> output_buffer_;
+	std::unique_ptr<BufferChain> output_buffer_;
+	int corked_{0};
+
+	// Adaptive sizing of the input buffer.
+	size_t read_size_;
+	bool read_shrinking_{false};
+	bool read_until_eagain_{false};
+	double input_shrink_delay_s_;
+	bool input_shrink_pending_{false};
+	TimeStamp last_read_ms_;
 
 	// A connection's context.
 	containers::Any context_;
@@ -197,6 +266,41 @@ private:
 	DISALLOW_COPY_AND_ASSIGN(TcpConnection);
 };
 
+// Example:
+// // ScopedCork
+// void on_message(const TcpConnectionPtr& conn, NetBuffer* buff, TimeStamp)
+// {
+// 	ScopedCork cork(conn);
+// 	for (...) {
+// 		conn->send(...);	// queued
+// 	}
+// }	// flushed by one writev(2)
+// ...
+
+// Corks the connection in the scope. A null |conn| is ignored.
+// *Not thread safe*, but run in own loop thread.
+class ScopedCork
+{
+public:
+	explicit ScopedCork(const TcpConnectionPtr& conn) : conn_(conn)
+	{
+		if (conn_) {
+			conn_->cork();
+		}
+	}
+	~ScopedCork()
+	{
+		if (conn_) {
+			conn_->uncork();
+		}
+	}
+
+private:
+	TcpConnectionPtr conn_;
+
+	DISALLOW_COPY_AND_ASSIGN(ScopedCork);
+};
+
 }	// namespace annety
 
 #endif	// ANT_TCP_CONNECTION_H_
@@ -5,11 +5,14 @@
 #define ANT_TCP_SERVER_H_
 
 #include "Macros.h"
+#include "EndPoint.h"
 #include "TcpConnection.h"
 #include "CallbackForward.h"
+#include "synchronization/MutexLock.h"
 
 #include <map>
 #include <string>
+#include <vector>
 #include <atomic>
 #include <memory>
 #include <utility>
@@ -28,6 +31,11 @@ class EventLoopPool;
 //
 // This class owns lifetime of Acceptor, it also storages all client 
 // connections pool which has been connected.
+//
+// In the multi-acceptor mode, every worker loop owns an Acceptor that is
+// bound with SO_REUSEPORT, the kernel balances new connections between 
+// them. Connections stay on the loop that accepted them, and are stored 
+// in the connections pool of that loop.
 class TcpServer : public std::enable_shared_from_this<TcpServer>
 {
 public:
@@ -49,10 +57,35 @@ public:
 	// - N means a thread pool with N threads, new connections
 	//   are assigned on a round-robin basis.
 	//
-	// NOTICE: Accepts new connection always in owner_loop_'s thread.
+	// NOTICE: Accepts new connection in owner_loop_'s thread, unless the
+	// multi-acceptor mode is turned on.
 	//
 	// *Not thread safe*, but usually be called before listen().
 	void set_thread_num(int num_threads);
+
+	// Turn on the multi-acceptor mode, each worker loop accepts and owns 
+	// its connections. The round-robin of `set_thread_num` is replaced by
+	// the kernel SO_REUSEPORT balancing.
+	//
+	// *Not thread safe*, but usually be called before listen().
+	void set_multi_acceptor(bool on);
+
+	// The max number of connections accepted per readable event of the
+	// listen socket, see Acceptor::set_accept_batch().
+	//
+	// *Not thread safe*, but usually be called before listen().
+	void set_accept_batch(int batch);
+
+	// Connection-rate metrics of all acceptors, valid after listen().
+	// *Thread safe*
+	int64_t accepted_count() const;
+	int64_t rejected_count() const;
+	int64_t emfile_count() const;
+
+	// The loops of the connections, valid after listen(). 
+	// e.g. TcpClientPool::set_loops().
+	// *Not thread safe*, but run in the owner loop.
+	std::vector<EventLoop*> get_all_loops() const;
 	// *Not thread safe*, but usually be called before listen().
 	void set_thread_init_callback(ThreadInitCallback cb)
 	{
@@ -82,13 +115,21 @@ public:
 	}
 
 private:
-	// *Not thread safe*, but run in own loop thread.
-	void new_connection(SelectableFDPtr&& peerfd, const EndPoint& peeraddr);
+	struct Shard;
+
+	// *Not thread safe*, but run in the accepting loop thread.
+	void new_connection(Shard* shard, SelectableFDPtr&& peerfd, const EndPoint& peeraddr);
+	// Hand off the accepted connections of a batch, one post per worker.
+	// *Not thread safe*, but run in the accepting loop thread.
+	void establish_connections(Shard* shard);
 
 	// *Thread safe*, for Connection.
-	void remove_connection(const TcpConnectionPtr&);
-	// *Not thread safe*, but run in own loop thread.
-	void remove_connection_in_loop(const TcpConnectionPtr&);
+	void remove_connection(Shard* shard, const TcpConnectionPtr&);
+	// *Not thread safe*, but run in the loop thread of |shard|.
+	void remove_connection_in_loop(Shard* shard, const TcpConnectionPtr&);
+
+	// *Not thread safe*, but run in the loop thread of |shard|.
+	void destroy_shard(Shard* shard);
 
 	TcpServer(EventLoop* loop,
 		const EndPoint& addr,
@@ -107,23 +148,51 @@ private:
 private:
 	using ConnectionMap = std::map<std::string, TcpConnectionPtr>;
 
+	// The Acceptor and the client connections pool of the accepting loop.
+	// *Not thread safe*, but only accessed in the `loop` thread.
+	struct Shard
+	{
+		Shard(EventLoop* l, std::unique_ptr<Acceptor> a);
+		~Shard();
+
+		EventLoop* loop;
+		std::unique_ptr<Acceptor> acceptor;
+		ConnectionMap connections;
+
+		// The metrics of the destroyed |acceptor|, guarded by |shards_lock_|.
+		int64_t accepted{0};
+		int64_t rejected{0};
+		int64_t emfile{0};
+
+		// The connections of the current accepting batch.
+		std::vector<TcpConnectionPtr> pending;
+	};
+
 	EventLoop* owner_loop_{nullptr};
 	const std::string name_;
 	const std::string ip_port_;
+	const EndPoint listen_addr_;
+	const bool nodelay_;
 	bool initilize_{false};
+	bool multi_acceptor_{false};
+	int accept_batch_{0};
 	
 	// ATOMIC_FLAG_INIT is macro
 	std::atomic_flag started_ = ATOMIC_FLAG_INIT;
 
-	// Accept the processor.
+	// Accept the processor of the owner loop, it is moved into a shard 
+	// when listen().
 	std::unique_ptr<Acceptor> acceptor_;
 	
 	// ThreadPool of event loops.
 	std::unique_ptr<EventLoopPool> workers_;
 
-	// Client connections pool (std::map).
-	int next_conn_id_{1};
-	ConnectionMap connections_;
+	// One shard of the owner loop, or one per worker loop in the 
+	// multi-acceptor mode. The |shards_| and the |acceptor| of shards are 
+	// guarded by |shards_lock_| for the metrics, which read them in any thread.
+	mutable MutexLock shards_lock_;
+	std::vector<std::unique_ptr<Shard>> shards_;
+	std::atomic<int> next_conn_id_{1};
 
 	// User registered callback functions.
 	ConnectCallback connect_cb_;
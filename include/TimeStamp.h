@@ -377,6 +377,17 @@ public:
 	// times are increasing, or that two calls to now() won't be the same.
 	static TimeStamp now();
 
+	// Returns the current UTC time of the coarse clock (CLOCK_REALTIME_COARSE),
+	// it is much cheaper than now(), but the resolution is the tick of kernel
+	// (1~4ms). It is now() on the platforms without the coarse clock.
+	static TimeStamp now_coarse();
+
+	// Returns the time of the monotonic clock (CLOCK_MONOTONIC), in the
+	// timebase of the UTC time of the first call. It never goes backwards
+	// or jumps when the system clock is adjusted, which is the time of the
+	// timers.
+	static TimeStamp now_monotonic();
+
 	// Converts to/from time_t in UTC and a TimeStamp class.
 	static TimeStamp from_time_t(const time_t& tt);
 	time_t to_time_t() const;
@@ -4,6 +4,8 @@
 #ifndef ANT_TIMER_ID_H_
 #define ANT_TIMER_ID_H_
 
+#include <stdint.h>	// int64_t
+
 namespace annety
 {
 class Timer;
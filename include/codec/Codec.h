@@ -10,16 +10,36 @@
 #include "TcpConnection.h"
 #include "CallbackForward.h"
 #include "EventLoop.h"	// check_in_own_loop
+#include "strings/StringPiece.h"
 
+#include <vector>
 #include <functional>
 #include <utility>
 
 namespace annety
 {
+// The callback of a decoded payload. The |payload| is a read-only view of
+// the input buffer of connection (no copy), it is valid until the callback 
+// returns, copy it if it must be kept.
+using CodecMessageCallback = 
+		std::function<void(const TcpConnectionPtr&, const StringPiece&, TimeStamp)>;
+
+// The callback of all payloads that are decoded from one read of connection
+// (the pipelined requests), they are views of the input buffer as the above.
+// The connection is corked in the callback, so the replies of the batch are
+// flushed by one writev(2) when it returns.
+using CodecBatchMessageCallback = 
+		std::function<void(const TcpConnectionPtr&, const std::vector<StringPiece>&, TimeStamp)>;
+
 // Base class of codec
 class Codec
 {
 public:
+	// The prependable bytes in front of the payload that encode() needs at 
+	// most, reserve them (NetBuffer::reserve_prependable()) before the payload
+	// is appended, so the header is prepended in place.
+	static const size_t kPrependSize = 8;
+
 	explicit Codec(EventLoop* loop) : owner_loop_(loop)
 	{
 		CHECK(loop);
@@ -27,46 +47,60 @@ public:
 
 	virtual ~Codec() = default;
 
-	// Decode payload from |buff| to |payload|
-	// NOTE: You must be remove the read bytes from |buff| when decode success.
+	// Decode payload from |buff|, the |payload| is a view of the bytes of |buff|.
+	// NOTE: You must be remove the read bytes from |buff| when decode success,
+	// the removed bytes are not overwritten until |buff| is written again.
 	// Returns:
 	//   -1  decode error, going to close connection
 	//    1  decode success, going to call message callback
 	//    0  decode incomplete, continues to read more data
 	// *Not thread safe*, but run in the own loop.
-	virtual int decode(NetBuffer* buff, NetBuffer* payload) = 0;
+	virtual int decode(NetBuffer* buff, StringPiece* payload) = 0;
 
-	// Encode stream bytes from |payload| to |buff|
-	// NOTE: Do not remove the sent bytes from |payload| even if encode success.
+	// Encode the frame of |payload| in place, the header is prepended in front
+	// of the payload, and the trailer is appended.
 	// Returns:
 	//   -1  encode error, going to close connection
 	//    1  encode success, going to send data to peer
 	//    0  encode incomplete, continues to send more data
 	// *Thread safe*, pure function.
-	virtual int encode(NetBuffer* payload, NetBuffer* buff) = 0;
+	virtual int encode(NetBuffer* payload) = 0;
 	
 	// *Not thread safe*
-	void set_message_callback(MessageCallback cb)
+	void set_message_callback(CodecMessageCallback cb)
 	{
 		message_cb_ = std::move(cb);
 	}
 
+	// Deliver the payloads of a read by batch, rather than one by one.
+	// *Not thread safe*
+	void set_batch_message_callback(CodecBatchMessageCallback cb)
+	{
+		batch_message_cb_ = std::move(cb);
+	}
+
+	// Decode all complete frames of |buff|, and call the message callback.
 	// *Not thread safe*, but run in the own loop.
-	void recv(const TcpConnectionPtr& conn, NetBuffer* buff, TimeStamp receive_ms)
+	virtual void recv(const TcpConnectionPtr& conn, NetBuffer* buff, TimeStamp receive_ms)
 	{
 		owner_loop_->check_in_own_loop();
 
 		CHECK(!!buff);
 
+		if (batch_message_cb_) {
+			recv_batch(conn, buff, receive_ms);
+			return;
+		}
+
 		int rt = 0;
 		do {
-			NetBuffer payload;
+			StringPiece payload;
 			// NOTE: You must be remove the read bytes from |buff| when decode success.
 			rt = decode(buff, &payload);
 
 			if (rt == 1) {
 				if (message_cb_) {
-					message_cb_(conn, &payload, receive_ms);
+					message_cb_(conn, payload, receive_ms);
 				} else {
 					LOG(WARNING) << "LengthHeaderCodec::message_callback no message callback";
 				}
@@ -77,30 +111,76 @@ public:
 		} while (rt == 1);
 	}
 
-	// *Thread safe*, pure function.
-	void send(const TcpConnectionPtr& conn, NetBuffer* payload)
+	// Encode a copy of |payload| into a frame, then send it.
+	// NOTE: Do not remove the sent bytes from |payload| even if encode success.
+	// *Thread safe*
+	void send(const TcpConnectionPtr& conn, const NetBuffer* payload)
 	{
 		CHECK(!!payload);
 
-		int rt = 0;
-		do {
-			NetBuffer buff;
-			// NOTE: Do not remove the sent bytes from |payload| when encode success.
-			rt = encode(payload, &buff);
+		send(conn, StringPiece(payload->begin_read(), payload->readable_bytes()));
+	}
 
-			if (rt == 1) {
-				conn->send(&buff);
-			} else if (rt == -1) {
-				LOG(ERROR) << "LengthHeaderCodec::send_callback Invalid buff, rt=" << rt;
-				conn->shutdown();
-			}
-		} while (0);
+	// Copy |payload| into a frame once, the |payload| is not modified (such
+	// as the broadcast of a received payload).
+	// *Thread safe*
+	void send(const TcpConnectionPtr& conn, const StringPiece& payload)
+	{
+		NetBuffer frame(ByteBuffer::kUnLimitSize, kPrependSize + payload.size() + sizeof(uint32_t));
+		frame.reserve_prependable(kPrependSize);
+		frame.append(payload);
+		send_take(conn, &frame);
+	}
+
+	// Encode |payload| in place, then send it without copying. Reserve the 
+	// kPrependSize bytes in front of the payload, or the header is copied.
+	// NOTE: The bytes of |payload| are taken (swapped) when encode success,
+	// it is empty after return.
+	// *Thread safe*
+	void send_take(const TcpConnectionPtr& conn, NetBuffer* payload)
+	{
+		CHECK(!!payload);
+
+		int rt = encode(payload);
+		if (rt == 1) {
+			conn->send(payload);
+		} else if (rt == -1) {
+			LOG(ERROR) << "LengthHeaderCodec::send_callback Invalid buff, rt=" << rt;
+			conn->shutdown();
+		}
+	}
+
+private:
+	void recv_batch(const TcpConnectionPtr& conn, NetBuffer* buff, TimeStamp receive_ms)
+	{
+		// The decoded payloads are not overwritten, until |buff| is written 
+		// again (the next read).
+		int rt = 0;
+		StringPiece payload;
+		while ((rt = decode(buff, &payload)) == 1) {
+			batch_payloads_.push_back(payload);
+		}
+
+		if (!batch_payloads_.empty()) {
+			ScopedCork cork(conn);
+			batch_message_cb_(conn, batch_payloads_, receive_ms);
+			batch_payloads_.clear();
+		}
+
+		if (rt == -1) {
+			LOG(ERROR) << "Codec::recv_batch Invalid buff, rt=" << rt;
+			conn->shutdown();
+		}
 	}
 
 protected:
 	EventLoop* owner_loop_;
 
-	MessageCallback message_cb_;
+	CodecMessageCallback message_cb_;
+	CodecBatchMessageCallback batch_message_cb_;
+
+	// The payloads of the last read, the capacity is reused.
+	std::vector<StringPiece> batch_payloads_;
 
 	DISALLOW_COPY_AND_ASSIGN(Codec);
 };
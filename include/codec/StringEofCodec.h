@@ -8,6 +8,7 @@
 #include "Logging.h"
 #include "codec/Codec.h"
 #include "strings/StringPiece.h"
+#include "strings/StringUtil.h"
 
 namespace annety
 { 
@@ -32,62 +33,59 @@ public:
 		, inner_string_eof_(string_eof)
 		, string_eof_(inner_string_eof_.data(), inner_string_eof_.size())
 		, max_payload_(max_payload)
-		, curr_offset_(0)
 	{
 		CHECK(string_eof.size() > 0);
 		CHECK(max_payload > 0);
 	}
 
-	// Decode payload from |buff| to |payload|
+	// Decode payload from |buff|, the |payload| is a view of the bytes of |buff|.
+	// The scanned bytes of an incomplete frame are kept on |buff| (the input
+	// buffer of connection), they are not scanned again by the next decode().
 	// NOTE: Has moved the read bytes from |buff| when decode success.
 	// Returns:
 	//   -1  decode error, going to close connection
 	//    1  decode success, going to call message callback
 	//    0  decode incomplete, continues to read more data
 	// *Not thread safe*, but run in the own loop.
-	virtual int decode(NetBuffer* buff, NetBuffer* payload) override
+	virtual int decode(NetBuffer* buff, StringPiece* payload) override
 	{
 		CHECK(!!buff && !!payload);
 
-		int rt = 0;
-		
-		if (buff->readable_bytes() >= string_eof().size()) {
-			StringPiece::size_type n = StringPiece::npos;
-			if (string_eof().size() == 1) {
-				// High performance (for single character).
-				n = buff->to_string_piece().find(*string_eof().data(), curr_offset_);
-			} else {
-				n = buff->to_string_piece().find(string_eof(), curr_offset_);
-			}
-			curr_offset_ += buff->readable_bytes() - string_eof().size() - 1;
+		const size_t readable = buff->readable_bytes();
+		if (readable < string_eof().size()) {
+			return 0;
+		}
 
-			if (n == StringPiece::npos && 
-				max_payload() > 0 && buff->readable_bytes() > max_payload() + string_eof().size()) {
-				LOG(ERROR) << "StringEofCodec::decode Invalid buffer bytes=" << buff->readable_bytes()
+		// The bytes before scanned_bytes() have been scanned, without the eof.
+		size_t n = find_substring(buff->to_string_piece(), string_eof(), buff->scanned_bytes());
+		if (n == StringPiece::npos) {
+			if (max_payload() > 0 && 
+				readable > static_cast<size_t>(max_payload()) + string_eof().size())
+			{
+				LOG(ERROR) << "StringEofCodec::decode Invalid buffer bytes=" << readable
 					<< ", max_payload=" << max_payload();
-				rt = -1;
-			} else if (n != StringPiece::npos) {
-				// FIXME: Move bytes from |buff| to |payload|. (should be no-copy)
-				payload->append(buff->begin_read(), n);
-				buff->has_read(n + string_eof().size());
-				curr_offset_ = 0;
-				rt = 1;
+				return -1;
 			}
+			// The eof may be split by the next read.
+			buff->set_scanned_bytes(readable - string_eof().size() + 1);
+			return 0;
 		}
 
-		return rt;
+		// The bytes are not overwritten until |buff| is written again.
+		payload->set(buff->begin_read(), n);
+		buff->has_read(n + string_eof().size());
+		return 1;
 	}
 	
-	// Encode stream bytes from |payload| to |buff|
-	// NOTE: Do not remove the sent bytes from |payload| even if encode success.
+	// Encode the frame of |payload| in place, the eof string is appended.
 	// Returns:
 	//   -1  encode error, going to close connection
 	//    1  encode success, going to send data to peer
 	//    0  encode incomplete, continues to send more data
 	// *Thread safe*, pure function.
-	virtual int encode(NetBuffer* payload, NetBuffer* buff) override
+	virtual int encode(NetBuffer* payload) override
 	{
-		CHECK(!!buff && !!payload);
+		CHECK(!!payload);
 		
 		const ssize_t length = payload->readable_bytes();
 		if (length == 0) {
@@ -99,11 +97,7 @@ public:
 			return -1;
 		}
 
-		// FIXME: Copy bytes from |payload| to |buff|. (should be no-copy)
-		buff->append(payload->begin_read(), length);
-		buff->append(string_eof().data(), string_eof().size());
-		// Do not remove the sent bytes.
-		// payload->has_read(length);
+		payload->append(string_eof().data(), string_eof().size());
 
 		return 1;
 	}
@@ -125,8 +119,6 @@ private:
 	StringPiece string_eof_;
 	ssize_t max_payload_;
 
-	size_t curr_offset_;
-
 	DISALLOW_COPY_AND_ASSIGN(StringEofCodec);
 };
 
@@ -0,0 +1,259 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#ifndef ANT_CONTAINERS_INLINE_FUNCTION_H
+#define ANT_CONTAINERS_INLINE_FUNCTION_H
+
+#include "Macros.h"
+
+#include <functional>	// std::function
+#include <new>			// placement new
+#include <utility>		// std::move,std::forward
+#include <type_traits>	// std::decay,std::enable_if,std::aligned_storage
+#include <cstddef>		// size_t,std::nullptr_t,max_align_t
+#include <assert.h>		// assert
+
+namespace annety
+{
+// Example:
+// // InlineFunction
+// int a = 1;
+// containers::InlineFunction<void(int)> f = [a](int v) {
+// 	cout << a + v << endl;
+// };
+// containers::InlineFunction<void(int)> g = std::move(f);	// move only
+// if (g) g(1);
+// if (!f) cout << "moved" << endl;
+// ...
+
+namespace containers
+{
+template <typename Signature, size_t InlineSize = 64>
+class InlineFunction;
+
+// A move-only callable wrapper like std::function, but the callable is
+// constructed in an inline storage of |InlineSize| bytes, the heap is
+// used only for oversized (or throwing move) callables.
+//
+// It is used by the hot path of EventLoop (the functors and the Channel 
+// callbacks), almost all of them are bound with a few pointers.
+// std::function only inlines 16 bytes, and requires copyable callables.
+//
+// NOTE: It does not include Logging.h (it is included by CallbackForward.h
+// everywhere), the empty call is checked by assert().
+//
+// *Not thread safe*
+template <typename R, typename... Args, size_t InlineSize>
+class InlineFunction<R(Args...), InlineSize>
+{
+private:
+	using Storage = typename std::aligned_storage<InlineSize, alignof(std::max_align_t)>::type;
+
+	struct Operations
+	{
+		R (*invoke)(void* storage, Args&&... args);
+		// Move construct |dst| from |src|, and destroy |src|.
+		void (*relocate)(void* dst, void* src);
+		void (*destroy)(void* storage);
+	};
+
+	template <typename F>
+	using IsInline = std::integral_constant<bool,
+				sizeof(F) <= InlineSize &&
+				alignof(std::max_align_t) % alignof(F) == 0 &&
+				std::is_nothrow_move_constructible<F>::value
+			>;
+
+	template <typename F>
+	struct InlineOperations
+	{
+		static R invoke(void* storage, Args&&... args)
+		{
+			return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+		}
+		static void relocate(void* dst, void* src)
+		{
+			F* from = static_cast<F*>(src);
+			::new (dst) F(std::move(*from));
+			from->~F();
+		}
+		static void destroy(void* storage)
+		{
+			static_cast<F*>(storage)->~F();
+		}
+		static const Operations* get()
+		{
+			static const Operations ops = {&invoke, &relocate, &destroy};
+			return &ops;
+		}
+	};
+
+	template <typename F>
+	struct HeapOperations
+	{
+		static R invoke(void* storage, Args&&... args)
+		{
+			return (**static_cast<F**>(storage))(std::forward<Args>(args)...);
+		}
+		static void relocate(void* dst, void* src)
+		{
+			*static_cast<F**>(dst) = *static_cast<F**>(src);
+		}
+		static void destroy(void* storage)
+		{
+			delete *static_cast<F**>(storage);
+		}
+		static const Operations* get()
+		{
+			static const Operations ops = {&invoke, &relocate, &destroy};
+			return &ops;
+		}
+	};
+
+	// The null function pointer and the empty std::function are treated
+	// as an empty InlineFunction.
+	template <typename F>
+	static bool is_null(const F&)
+	{
+		return false;
+	}
+	template <typename F>
+	static bool is_null(F* f)
+	{
+		return f == nullptr;
+	}
+	template <typename S>
+	static bool is_null(const std::function<S>& f)
+	{
+		return !f;
+	}
+	template <typename S, size_t N>
+	static bool is_null(const InlineFunction<S, N>& f)
+	{
+		return !f;
+	}
+
+	template <typename F>
+	using EnableIfCallable = typename std::enable_if<
+				!std::is_same<typename std::decay<F>::type, InlineFunction>::value
+			>::type;
+
+public:
+	InlineFunction() noexcept = default;
+	InlineFunction(std::nullptr_t) noexcept {}
+
+	template <typename F, typename = EnableIfCallable<F>>
+	InlineFunction(F&& f)
+	{
+		construct(std::forward<F>(f));
+	}
+
+	InlineFunction(InlineFunction&& rhs) noexcept
+	{
+		move_from(rhs);
+	}
+
+	~InlineFunction()
+	{
+		clear();
+	}
+
+	InlineFunction& operator=(InlineFunction&& rhs) noexcept
+	{
+		if (this != &rhs) {
+			clear();
+			move_from(rhs);
+		}
+		return *this;
+	}
+
+	InlineFunction& operator=(std::nullptr_t) noexcept
+	{
+		clear();
+		return *this;
+	}
+
+	template <typename F, typename = EnableIfCallable<F>>
+	InlineFunction& operator=(F&& f)
+	{
+		clear();
+		construct(std::forward<F>(f));
+		return *this;
+	}
+
+	explicit operator bool() const noexcept
+	{
+		return ops_ != nullptr;
+	}
+
+	R operator()(Args... args) const
+	{
+		assert(ops_ && "call an empty function");
+		return ops_->invoke(&storage_, std::forward<Args>(args)...);
+	}
+
+	// Returns true if the callable of type |F| is constructed inline.
+	template <typename F>
+	static constexpr bool is_inline()
+	{
+		return IsInline<typename std::decay<F>::type>::value;
+	}
+
+private:
+	template <typename F>
+	void construct(F&& f)
+	{
+		using Functor = typename std::decay<F>::type;
+		if (is_null(static_cast<const Functor&>(f))) {
+			return;
+		}
+		construct(std::forward<F>(f), IsInline<Functor>());
+	}
+
+	template <typename F>
+	void construct(F&& f, std::true_type)
+	{
+		using Functor = typename std::decay<F>::type;
+		::new (&storage_) Functor(std::forward<F>(f));
+		ops_ = InlineOperations<Functor>::get();
+	}
+
+	template <typename F>
+	void construct(F&& f, std::false_type)
+	{
+		using Functor = typename std::decay<F>::type;
+		::new (&storage_) Functor*(new Functor(std::forward<F>(f)));
+		ops_ = HeapOperations<Functor>::get();
+	}
+
+	void move_from(InlineFunction& rhs) noexcept
+	{
+		if (rhs.ops_) {
+			rhs.ops_->relocate(&storage_, &rhs.storage_);
+			ops_ = rhs.ops_;
+			rhs.ops_ = nullptr;
+		}
+	}
+
+	void clear() noexcept
+	{
+		if (ops_) {
+			const Operations* ops = ops_;
+			ops_ = nullptr;
+			ops->destroy(&storage_);
+		}
+	}
+
+private:
+	// The callable (or its pointer on heap) is called as non-const, as
+	// std::function does.
+	mutable Storage storage_;
+	const Operations* ops_{nullptr};
+
+	DISALLOW_COPY_AND_ASSIGN(InlineFunction);
+};
+
+}	// namespace containers
+}	// namespace annety
+
+#endif	// ANT_CONTAINERS_INLINE_FUNCTION_H
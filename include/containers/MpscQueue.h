@@ -0,0 +1,119 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#ifndef ANT_CONTAINERS_MPSC_QUEUE_H
+#define ANT_CONTAINERS_MPSC_QUEUE_H
+
+#include "Macros.h"
+
+#include <atomic>
+#include <utility>		// std::move
+#include <stddef.h>		// size_t
+
+namespace annety
+{
+namespace containers
+{
+// Example:
+// // MpscQueue
+// MpscQueue<int> q;
+// q.push(1);	// any thread
+// q.push(2);	// any thread
+//
+// q.consume([](int& v) {	// the only one consumer thread
+// 	cout << v << endl;
+// });
+// ...
+
+// Unbounded lock-free multi-producer single-consumer queue.
+// (Dmitry Vyukov's intrusive node based MPSC queue)
+//
+// push() is wait-free, one atomic exchange per value. The consumer may see
+// the queue as empty for a moment while a producer is linking its node, so
+// the producer must notify the consumer *after* push() returns.
+//
+// *Thread safe* for push(), but consume() only called by one thread.
+template <typename T>
+class MpscQueue
+{
+public:
+	MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+	~MpscQueue()
+	{
+		Node* node = tail_->next.load(std::memory_order_relaxed);
+		while (node) {
+			Node* next = node->next.load(std::memory_order_relaxed);
+			delete node;
+			node = next;
+		}
+		if (tail_ != &stub_) {
+			delete tail_;
+		}
+	}
+
+	// *Thread safe*
+	void push(T value)
+	{
+		Node* node = new Node(std::move(value));
+		Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+		prev->next.store(node, std::memory_order_release);
+	}
+
+	// Pops the values were pushed before calling, and calls |f| on each.
+	// The values pushed by |f| are left to the next round.
+	// Returns the number of values has been consumed.
+	// *Not thread safe*, but only called by the consumer thread.
+	template <typename F>
+	size_t consume(F&& f)
+	{
+		Node* last = head_.load(std::memory_order_acquire);
+
+		size_t count = 0;
+		while (tail_ != last) {
+			Node* next = tail_->next.load(std::memory_order_acquire);
+			if (!next) {
+				// A producer is linking its node.
+				break;
+			}
+			if (tail_ != &stub_) {
+				delete tail_;
+			}
+			tail_ = next;
+
+			// The value of tail node is released, the node is deleted by
+			// the next pop.
+			T value(std::move(next->value));
+			f(value);
+			count++;
+		}
+		return count;
+	}
+
+	// *Not thread safe*, but only called by the consumer thread.
+	bool empty() const
+	{
+		return !tail_->next.load(std::memory_order_acquire);
+	}
+
+private:
+	struct Node
+	{
+		Node() = default;
+		explicit Node(T&& v) : value(std::move(v)) {}
+
+		std::atomic<Node*> next{nullptr};
+		T value;
+	};
+
+	Node stub_;
+	std::atomic<Node*> head_;
+	Node* tail_;
+
+	DISALLOW_COPY_AND_ASSIGN(MpscQueue);
+};
+
+}	// namespace containers
+}	// namespace annety
+
+#endif	// ANT_CONTAINERS_MPSC_QUEUE_H
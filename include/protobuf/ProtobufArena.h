@@ -0,0 +1,198 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#ifndef ANT_PROTOBUF_PROTOBUF_ARENA_H
+#define ANT_PROTOBUF_PROTOBUF_ARENA_H
+
+#include "Macros.h"
+#include "Logging.h"
+#include "TimeStamp.h"
+#include "TcpConnection.h"
+#include "CallbackForward.h"
+
+#include <memory>
+#include <functional>
+#include <stdint.h>
+
+#include <google/protobuf/arena.h>
+#include <google/protobuf/message.h>
+
+namespace annety
+{
+using MessagePtr = std::shared_ptr<google::protobuf::Message>;
+
+class ProtobufArena;
+
+// Example:
+// // ProtobufArenaMessage
+// codec.enable_arena(
+// 	[](const TcpConnectionPtr& conn, const ProtobufArenaMessage& mesg, TimeStamp) {
+// 		const Snapshot* snapshot = mesg.cast<Snapshot>();
+// 		...
+// 		// keep it after the callback
+// 		MessagePtr copy = mesg.detach();
+// 	});
+// ...
+
+// The handle of a message that is parsed on the Arena of ProtobufCodec.
+//
+// The message is borrowed, it is valid only until the dispatch callback
+// returns, the arena is reset after the decoded batch of frames. Use
+// detach() to copy it out of the arena. A stale handle is checked by
+// the generation of arena (in debug build).
+class ProtobufArenaMessage
+{
+public:
+	ProtobufArenaMessage(google::protobuf::Message* mesg, const ProtobufArena* arena);
+
+	google::protobuf::Message* get() const;
+
+	google::protobuf::Message* operator->() const
+	{
+		return get();
+	}
+	google::protobuf::Message& operator*() const
+	{
+		return *get();
+	}
+
+	template <typename T>
+	T* cast() const
+	{
+		DCHECK(dynamic_cast<T*>(get()));
+		return static_cast<T*>(get());
+	}
+
+	// Copies the message onto the heap, it is owned by the caller.
+	MessagePtr detach() const
+	{
+		MessagePtr mesg(get()->New());
+		mesg->CopyFrom(*get());
+		return mesg;
+	}
+
+private:
+	google::protobuf::Message* mesg_;
+	const ProtobufArena* arena_;
+	uint64_t generation_;
+};
+
+using ProtobufArenaMessageCallback =
+		std::function<void(const TcpConnectionPtr&, const ProtobufArenaMessage&, TimeStamp)>;
+
+// The recyclable Arena of the parsed messages of one loop (the codec).
+//
+// The arena starts on an owned initial block, reset() destroys all messages
+// and keeps the block, so the steady state parses without malloc(). If a
+// batch has overflowed the block, the block grows to the size of that batch
+// (up to kMaxBlockSize).
+//
+// *Not thread safe*, but run in the own loop.
+class ProtobufArena
+{
+public:
+	static const size_t kDefaultBlockSize = 64 * 1024;
+	static const size_t kMaxBlockSize = 16 * 1024 * 1024;
+
+	explicit ProtobufArena(size_t block_size = kDefaultBlockSize)
+	{
+		CHECK(block_size > 0 && block_size <= kMaxBlockSize);
+		rebuild(block_size);
+	}
+
+	~ProtobufArena()
+	{
+		// Destroy the messages before the block.
+		arena_.reset();
+	}
+
+	google::protobuf::Arena* get()
+	{
+		used_ = true;
+		return arena_.get();
+	}
+
+	// The handles of the messages before reset() are stale.
+	uint64_t generation() const
+	{
+		return generation_;
+	}
+
+	size_t block_size() const
+	{
+		return block_size_;
+	}
+
+	// Destroys all messages of the arena.
+	void reset();
+
+private:
+	void rebuild(size_t block_size);
+
+private:
+	size_t block_size_{0};
+	std::unique_ptr<char[]> block_;
+	std::unique_ptr<google::protobuf::Arena> arena_;
+
+	bool used_{false};
+	uint64_t generation_{0};
+
+	DISALLOW_COPY_AND_ASSIGN(ProtobufArena);
+};
+
+void ProtobufArena::reset()
+{
+	if (!used_) {
+		return;
+	}
+	used_ = false;
+	generation_++;
+
+	const uint64_t allocated = arena_->SpaceAllocated();
+	if (allocated > block_size_ && block_size_ < kMaxBlockSize) {
+		size_t block_size = block_size_;
+		while (block_size < allocated && block_size < kMaxBlockSize) {
+			block_size *= 2;
+		}
+		LOG(DEBUG) << "ProtobufArena::reset grow the block from " << block_size_
+			<< " to " << block_size << " bytes";
+
+		rebuild(block_size);
+	} else {
+		arena_->Reset();
+	}
+}
+
+void ProtobufArena::rebuild(size_t block_size)
+{
+	arena_.reset();
+
+	block_size_ = block_size;
+	if (block_size_ > kMaxBlockSize) {
+		block_size_ = kMaxBlockSize;
+	}
+	block_.reset(new char[block_size_]);
+
+	google::protobuf::ArenaOptions options;
+	options.initial_block = block_.get();
+	options.initial_block_size = block_size_;
+	arena_.reset(new google::protobuf::Arena(options));
+}
+
+ProtobufArenaMessage::ProtobufArenaMessage(google::protobuf::Message* mesg, const ProtobufArena* arena)
+	: mesg_(mesg)
+	, arena_(arena)
+	, generation_(arena->generation())
+{
+	CHECK(mesg_);
+}
+
+google::protobuf::Message* ProtobufArenaMessage::get() const
+{
+	DCHECK(arena_->generation() == generation_) << "the arena message is stale";
+	return mesg_;
+}
+
+}	// namespace annety
+
+#endif  // ANT_PROTOBUF_PROTOBUF_ARENA_H
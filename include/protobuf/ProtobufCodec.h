@@ -10,13 +10,18 @@
 #include "ByteOrder.h"
 #include "Crc32c.h"
 #include "codec/Codec.h"
+#include "protobuf/ProtobufArena.h"
 
 #include <utility>
 #include <functional>
+#include <memory>
+#include <vector>
 #include <string>
-#include <cstring>	// size_t,ssize_t,::memcpy
+#include <cstring>	// size_t,ssize_t,::memcpy,::memcmp
 
 #include <google/protobuf/message.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 
 namespace annety
 {
@@ -46,6 +51,144 @@ using MessagePtr = std::shared_ptr<google::protobuf::Message>;
 using ProtobufMessageCallback = 
 		std::function<void(const TcpConnectionPtr&, const MessagePtr&, TimeStamp)>;
 
+// The generated message types of the received frames, by the hash of type
+// name, so the type name of frame is resolved without the DescriptorPool
+// lookup (and the std::string of name).
+//
+// It also keeps a few parsed messages of each type for reuse, a message is
+// reused only if no one holds it after it has been dispatched (see
+// ProtobufCodec::set_message_reuse(), it is off by default).
+//
+// *Not thread safe*, one instance per thread (the loop), see current().
+class ProtobufTypeCache
+{
+public:
+	struct Entry
+	{
+		uint64_t hash;
+		std::string name;
+		const google::protobuf::Message* prototype;
+		std::vector<MessagePtr> spares;
+	};
+
+	// The cache of calling thread.
+	static ProtobufTypeCache& current();
+
+	// Returns nullptr if |name| is not a generated message type.
+	Entry* find(const char* name, size_t len);
+
+	// A cleared message of |entry|, it is reused or New().
+	MessagePtr acquire(Entry* entry);
+
+	// Returns the dispatched |mesg| of |entry|, it is reused if no one else 
+	// holds it.
+	void release(Entry* entry, MessagePtr& mesg);
+
+private:
+	ProtobufTypeCache() : table_(kInitialSize, nullptr) {}
+
+	// FNV-1a
+	static uint64_t hash(const char* name, size_t len);
+
+	Entry* insert(uint64_t hash, const char* name, size_t len);
+
+private:
+	static const size_t kInitialSize = 64;
+	static const size_t kMaxSpares = 4;
+
+	std::vector<Entry*> table_;
+	std::vector<std::unique_ptr<Entry>> entries_;
+
+	DISALLOW_COPY_AND_ASSIGN(ProtobufTypeCache);
+};
+
+ProtobufTypeCache& ProtobufTypeCache::current()
+{
+	static thread_local ProtobufTypeCache cache;
+	return cache;
+}
+
+uint64_t ProtobufTypeCache::hash(const char* name, size_t len)
+{
+	uint64_t h = 14695981039346656037ULL;
+	for (size_t i = 0; i < len; ++i) {
+		h ^= static_cast<unsigned char>(name[i]);
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+ProtobufTypeCache::Entry* ProtobufTypeCache::find(const char* name, size_t len)
+{
+	const uint64_t h = hash(name, len);
+	const size_t mask = table_.size() - 1;
+	for (size_t i = h & mask; table_[i]; i = (i + 1) & mask) {
+		Entry* entry = table_[i];
+		if (entry->hash == h && entry->name.size() == len && 
+			::memcmp(entry->name.data(), name, len) == 0)
+		{
+			return entry;
+		}
+	}
+	return insert(h, name, len);
+}
+
+ProtobufTypeCache::Entry* ProtobufTypeCache::insert(uint64_t h, const char* name, size_t len)
+{
+	using namespace google::protobuf;
+
+	// The unknown types are not cached, they are likely garbage.
+	const Descriptor* desc = DescriptorPool::generated_pool()->FindMessageTypeByName(std::string(name, len));
+	if (!desc) {
+		return nullptr;
+	}
+	const Message* prototype = MessageFactory::generated_factory()->GetPrototype(desc);
+	if (!prototype) {
+		return nullptr;
+	}
+
+	entries_.emplace_back(new Entry{h, std::string(name, len), prototype, {}});
+
+	// Keep the load factor under 50%, rebuild the table.
+	if (entries_.size() * 2 > table_.size()) {
+		table_.assign(table_.size() * 2, nullptr);
+		for (auto& entry : entries_) {
+			size_t i = entry->hash & (table_.size() - 1);
+			while (table_[i]) {
+				i = (i + 1) & (table_.size() - 1);
+			}
+			table_[i] = entry.get();
+		}
+	} else {
+		size_t i = h & (table_.size() - 1);
+		while (table_[i]) {
+			i = (i + 1) & (table_.size() - 1);
+		}
+		table_[i] = entries_.back().get();
+	}
+	return entries_.back().get();
+}
+
+MessagePtr ProtobufTypeCache::acquire(Entry* entry)
+{
+	if (!entry->spares.empty()) {
+		MessagePtr mesg = std::move(entry->spares.back());
+		entry->spares.pop_back();
+		return mesg;
+	}
+	return MessagePtr(entry->prototype->New());
+}
+
+void ProtobufTypeCache::release(Entry* entry, MessagePtr& mesg)
+{
+	// No one else can share it if the use count is 1.
+	if (mesg && mesg.use_count() == 1 && entry->spares.size() < kMaxSpares) {
+		mesg->Clear();
+		entry->spares.push_back(std::move(mesg));
+	}
+	mesg.reset();
+}
+
 // A codec that handle protobuf bytes of the following struct's streams:
 // struct streams __attribute__ ((__packed__))
 // {
@@ -77,7 +220,7 @@ public:
 	};
 
 	using ErrorCallback = 
-			std::function<void(const TcpConnectionPtr&, NetBuffer*, TimeStamp, ERROR_CODE)>;
+			std::function<void(const TcpConnectionPtr&, const StringPiece&, TimeStamp, ERROR_CODE)>;
 
 	ProtobufCodec(EventLoop* loop, ProtobufMessageCallback cb) 
 		: ProtobufCodec(loop, std::move(cb), ProtobufCodec::error_callback) {}
@@ -94,30 +237,77 @@ public:
 			std::bind(&ProtobufCodec::parse, this, _1, _2, _3));
 	}
 
+	// Parses the messages on a recyclable arena of |block_size| bytes (it 
+	// grows to the largest batch), they are dispatched to |cb| as borrowed 
+	// ProtobufArenaMessage instead of the MessagePtr. The arena is reset 
+	// after the received batch of frames is dispatched, see recv().
+	// *Not thread safe*, but usually be called before recv().
+	void enable_arena(ProtobufArenaMessageCallback cb, 
+					  size_t block_size = ProtobufArena::kDefaultBlockSize)
+	{
+		arena_.reset(new ProtobufArena(block_size));
+		arena_cb_ = std::move(cb);
+	}
+
+	// Reuses the dispatched messages (cleared) for the next frames of the same
+	// type, it is off by default. A message is reused only if no one else
+	// holds a shared_ptr of it after the callback returns.
+	// NOTE: If it is on, the callbacks must not keep the message by a raw 
+	// pointer, a reference or a weak_ptr, keep a copy of the MessagePtr.
+	// *Not thread safe*, but usually be called before recv().
+	void set_message_reuse(bool on)
+	{
+		message_reuse_ = on;
+	}
+
+	// The polynomial of checksum, the default is kCrc32Ieee (the wire format
+	// of old peers), kCrc32Castagnoli runs the SSE4.2 instruction.
+	// *Not thread safe*, but usually be called before recv()/send().
+	void set_checksum_polynomial(Crc32c::POLYNOMIAL polynomial)
+	{
+		polynomial_ = polynomial;
+	}
+
 	// *Not thread safe*, but run in the own loop.
 	// using Codec::recv;
-	void recv(const TcpConnectionPtr& conn, NetBuffer* buff, TimeStamp receive)
+	virtual void recv(const TcpConnectionPtr& conn, NetBuffer* buff, TimeStamp receive) override
 	{
 		Codec::recv(conn, buff, receive);
+
+		// All arena messages of the batch have been dispatched.
+		if (arena_) {
+			arena_->reset();
+		}
 	}
 
 	// *Thread safe*, pure function.
 	void send(const TcpConnectionPtr& conn, const google::protobuf::Message& mesg)
 	{
-		NetBuffer payload;
-		if (serialize(mesg, &payload)) {
-			Codec::send(conn, &payload);
+		NetBuffer frame;
+		if (serialize_frame(mesg, &frame)) {
+			conn->send(&frame);
 		}
 	}
 
-	// Decode payload from |buff| to |payload|
+	// Serialize the whole frame of |mesg| into |frame| in place (the length, 
+	// typename, message and checksum), it is the same bytes of encode().
+	//
+	// If |inner| is not null, it is serialized as the bytes field |field| of 
+	// |mesg| in place, the field of |mesg| itself must be empty. It saves the 
+	// copies of SerializeAsString() of the nested message.
+	//
+	// *Thread safe*, pure function.
+	bool serialize_frame(const google::protobuf::Message& mesg, NetBuffer* frame, 
+						 int field = 0, const google::protobuf::Message* inner = nullptr);
+
+	// Decode payload from |buff|, the |payload| is a view of the bytes of |buff|.
 	// NOTE: Has moved the read bytes from |buff| when decode success.
 	// Returns:
 	//   -1  decode error, going to close connection
 	//    1  decode success, going to call message callback when decode success
 	//    0  decode incomplete, continues to read more data
 	// *Not thread safe*, but run in the own loop.
-	virtual int decode(NetBuffer* buff, NetBuffer* payload) override
+	virtual int decode(NetBuffer* buff, StringPiece* payload) override
 	{
 		CHECK(!!buff && !!payload);
 
@@ -159,19 +349,12 @@ public:
 				if (LIKELY(checksum_length() > 0)) {
 					checksum = peek_uint32(buff->begin_read() + length_type() + length - checksum_length());
 
-					using crc32_func_t = uint32_t(*)(const char*, size_t);
-					crc32_func_t crc32_func = nullptr;
-					if (LIKELY(length - checksum_length() > 60)) {
-						crc32_func = Crc32c::crc32_long;
-					} else {
-						crc32_func = Crc32c::crc32_short;
-					}
-					expectsum = crc32_func(buff->begin_read() + length_type(), length - checksum_length());
+					expectsum = Crc32c::checksum(polynomial_, buff->begin_read() + length_type(), length - checksum_length());
 				}
 
 				if (LIKELY(expectsum == checksum)) {
-					// FIXME: Move bytes from |buff| to |payload|. (should be no-copy)
-					payload->append(buff->begin_read() + length_type(), length - checksum_length());
+					// The bytes are not overwritten until |buff| is written again.
+					payload->set(buff->begin_read() + length_type(), length - checksum_length());
 					buff->has_read(length_type() + length);
 					rt = 1;
 				} else {
@@ -185,33 +368,33 @@ public:
 		return rt;
 	}
 
-	// Encode stream bytes from |payload| to |buff|
-	// NOTE: Do not remove the sent bytes from |payload| even if encode success.
+	// Encode the frame of |payload| in place, the length is prepended in front
+	// of the payload, and the checksum is appended.
 	// Returns:
 	//   -1  encode error, going to close connection
 	//    1  encode success, going to send data to peer
 	//    0  encode incomplete, continues to send more data
 	// *Thread safe*, pure function.
-	virtual int encode(NetBuffer* payload, NetBuffer* buff) override
+	virtual int encode(NetBuffer* payload) override
 	{
-		CHECK(!!buff && !!payload);
+		CHECK(!!payload);
 		
 		auto set_buff_length = [] (ssize_t length, NetBuffer* buff) {
 			switch (length_type()) {
 			case kLengthType8:
-				buff->append_int8(length);
+				buff->prepend_int8(length);
 				break;
 
 			case kLengthType16:
-				buff->append_int16(length);
+				buff->prepend_int16(length);
 				break;
 
 			case kLengthType32:
-				buff->append_int32(length);
+				buff->prepend_int32(length);
 				break;
 
 			case kLengthType64:
-				buff->append_int64(length);
+				buff->prepend_int64(length);
 				break;
 			}
 		};
@@ -226,37 +409,30 @@ public:
 			return -1;
 		}
 
-		// FIXME: Copy bytes from |payload| to |buff|. (should be no-copy)
-		set_buff_length(length + checksum_length(), buff);
-		buff->append(payload->begin_read(), length);
-		// Do not remove the sent bytes.
-		// payload->has_read(length);
-
 		// Turn on/off crc32 checksum.
+		uint32_t checksum = 0;
 		if (LIKELY(checksum_length() > 0)) {
-			using crc32_func_t = uint32_t(*)(const char*, size_t);
-			crc32_func_t crc32_func = nullptr;
-			if (LIKELY(length > 60)) {
-				crc32_func = Crc32c::crc32_long;
-			} else {
-				crc32_func = Crc32c::crc32_short;
-			}
+			checksum = Crc32c::checksum(polynomial_, payload->begin_read(), length);
+		}
 
-			uint32_t checksum = crc32_func(payload->begin_read(), length);
-			buff->append_int32(checksum);
+		// Into the prependable bytes of |payload|, no copy if it is enough.
+		set_buff_length(length + checksum_length(), payload);
+		if (LIKELY(checksum_length() > 0)) {
+			payload->append_int32(checksum);
 		}
 
 		return 1;
 	}
 
 private:
-	bool serialize(const google::protobuf::Message&, NetBuffer*);
-	void parse(const TcpConnectionPtr&, NetBuffer*, TimeStamp);
+	void parse(const TcpConnectionPtr&, const StringPiece&, TimeStamp);
+	void parse_arena(const TcpConnectionPtr&, const StringPiece&, TimeStamp);
 
-	static ERROR_CODE parse_mesg(NetBuffer*, MessagePtr&);
-	static google::protobuf::Message* generate_mesg(const std::string&);
+	static ERROR_CODE parse_type(StringPiece*, ProtobufTypeCache::Entry**);
+	static ERROR_CODE parse_mesg(StringPiece, MessagePtr&, ProtobufTypeCache::Entry**);
+	static ERROR_CODE parse_mesg(StringPiece, google::protobuf::Arena*, google::protobuf::Message**);
 
-	static void error_callback(const TcpConnectionPtr&, NetBuffer*, TimeStamp, ERROR_CODE);
+	static void error_callback(const TcpConnectionPtr&, const StringPiece&, TimeStamp, ERROR_CODE);
 	static const std::string& to_errstr(ERROR_CODE errorCode);
 
 	// sizeof(int32_t)
@@ -292,41 +468,89 @@ private:
 private:
 	ProtobufMessageCallback dispatch_cb_;
 	ErrorCallback error_cb_;
+	Crc32c::POLYNOMIAL polynomial_{Crc32c::kCrc32Ieee};
+	bool message_reuse_{false};
+
+	// The arena mode.
+	std::unique_ptr<ProtobufArena> arena_;
+	ProtobufArenaMessageCallback arena_cb_;
 
 	DISALLOW_COPY_AND_ASSIGN(ProtobufCodec);
 };
 
-bool ProtobufCodec::serialize(const google::protobuf::Message& mesg, NetBuffer* payload)
+bool ProtobufCodec::serialize_frame(const google::protobuf::Message& mesg, NetBuffer* frame, 
+									int field, const google::protobuf::Message* inner)
 {
+	using google::protobuf::io::CodedOutputStream;
+	using google::protobuf::internal::WireFormatLite;
+
 	DCHECK(mesg.IsInitialized());
 	
-	CHECK(payload && !payload->readable_bytes());
+	CHECK(frame && !frame->readable_bytes());
 
-	// append typenamelen + typename
 	const std::string& type_name = mesg.GetTypeName();
 	int32_t nameLen = static_cast<int32_t>(type_name.size()+1); // c-style string
-	payload->append_int32(nameLen);
-	payload->append(type_name.data(), nameLen);
 
-	// append message
-	int size = mesg.ByteSizeLong(); // `ByteSize` is deprecated.
-	payload->ensure_writable_bytes(size);
-	mesg.SerializeToArray(payload->begin_write(), size);
-	payload->has_written(size);
+	// The sizes are cached by ByteSizeLong(), for SerializeWithCachedSizesToArray().
+	size_t size = mesg.ByteSizeLong();
+	size_t inner_size = 0;
+	uint32_t tag = 0;
+	if (inner) {
+		tag = WireFormatLite::MakeTag(field, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+		inner_size = inner->ByteSizeLong();
+		size += CodedOutputStream::VarintSize32(tag) + 
+				CodedOutputStream::VarintSize32(static_cast<uint32_t>(inner_size)) + inner_size;
+	}
+
+	const ssize_t length = sizeof(nameLen) + nameLen + size;
+	if (length + checksum_length() > max_payload()) {
+		LOG(ERROR) << "ProtobufCodec::serialize_frame Invalid length=" << length
+			<< ", max_payload=" << max_payload();
+		return false;
+	}
+
+	frame->ensure_writable_bytes(header_length() + length + checksum_length());
+	frame->append_int32(static_cast<int32_t>(length + checksum_length()));
 
-	CHECK(payload->readable_bytes() == sizeof(nameLen) + nameLen + size);
+	// append typenamelen + typename
+	frame->append_int32(nameLen);
+	frame->append(type_name.data(), nameLen);
+
+	// append message, then the nested bytes field.
+	uint8_t* begin = reinterpret_cast<uint8_t*>(frame->begin_write());
+	uint8_t* end = mesg.SerializeWithCachedSizesToArray(begin);
+	if (inner) {
+		end = CodedOutputStream::WriteTagToArray(tag, end);
+		end = CodedOutputStream::WriteVarint32ToArray(static_cast<uint32_t>(inner_size), end);
+		end = inner->SerializeWithCachedSizesToArray(end);
+	}
+	frame->has_written(end - begin);
+
+	CHECK(frame->readable_bytes() == static_cast<size_t>(header_length() + length));
+
+	// Turn on/off crc32 checksum.
+	if (LIKELY(checksum_length() > 0)) {
+		uint32_t checksum = Crc32c::checksum(polynomial_, frame->begin_read() + header_length(), length);
+		frame->append_int32(checksum);
+	}
 
 	return true;
 }
 
-void ProtobufCodec::parse(const TcpConnectionPtr& conn, NetBuffer* payload, TimeStamp receive)
+void ProtobufCodec::parse(const TcpConnectionPtr& conn, const StringPiece& payload, TimeStamp receive)
 {
-	CHECK(payload && payload->readable_bytes() > 0);
+	CHECK(payload.size() > 0);
+
+	if (arena_) {
+		parse_arena(conn, payload, receive);
+		return;
+	}
 
 	// RAII
 	MessagePtr mesg;
+	ProtobufTypeCache::Entry* entry = nullptr;
 
-	ERROR_CODE err = parse_mesg(payload, mesg);
+	ERROR_CODE err = parse_mesg(payload, mesg, &entry);
 	if (err == kNoError && mesg) {
 		if (dispatch_cb_) {
 			// Dispatch protobuf message callbacks.
@@ -337,30 +561,48 @@ void ProtobufCodec::parse(const TcpConnectionPtr& conn, NetBuffer* payload, Time
 	} else {
 		error_cb_(conn, payload, receive, err);
 	}
+
+	if (entry && message_reuse_) {
+		ProtobufTypeCache::current().release(entry, mesg);
+	}
+}
+
+void ProtobufCodec::parse_arena(const TcpConnectionPtr& conn, const StringPiece& payload, TimeStamp receive)
+{
+	// The message is destroyed by the reset of arena, after the batch.
+	google::protobuf::Message* mesg = nullptr;
+
+	ERROR_CODE err = parse_mesg(payload, arena_->get(), &mesg);
+	if (err == kNoError && mesg) {
+		if (arena_cb_) {
+			// Dispatch protobuf message callbacks.
+			arena_cb_(conn, ProtobufArenaMessage(mesg, arena_.get()), receive);
+		} else {
+			LOG(WARNING) << "ProtobufCodec::parse_arena no dispatch callback";
+		}
+	} else {
+		error_cb_(conn, payload, receive, err);
+	}
 }
 
-ProtobufCodec::ERROR_CODE ProtobufCodec::parse_mesg(NetBuffer* payload, MessagePtr& mesg)
+ProtobufCodec::ERROR_CODE ProtobufCodec::parse_type(StringPiece* payload, ProtobufTypeCache::Entry** entry)
 {
-	CHECK(payload && payload->readable_bytes() > 0);
+	CHECK(payload && payload->size() > 0);
 
 	ERROR_CODE err = kNoError;
 
-	const size_t nameLen = payload->read_int32();
-	if (nameLen >= 2 && nameLen <= payload->readable_bytes()) {
+	size_t nameLen = 0;
+	if (payload->size() >= sizeof(int32_t)) {
+		nameLen = peek_uint32(payload->data());
+		payload->remove_prefix(sizeof(int32_t));
+	}
+	if (nameLen >= 2 && nameLen <= payload->size()) {
 		// type name (-1 because of the index is 0 offset).
-		std::string name(payload->begin_read(), payload->begin_read() + nameLen - 1);
-
-		// Create (prototype) message object from typename.
-		mesg.reset(generate_mesg(name)); // RAII
-		if (mesg) {
-			// Parse protobuf from payload.
-			const char* data = payload->begin_read() + nameLen;
-			int32_t dataLen = payload->readable_bytes() - nameLen;
-			if (mesg->ParseFromArray(data, dataLen)) {
-				err = kNoError;
-			} else {
-				err = kParseError;
-			}
+		*entry = ProtobufTypeCache::current().find(payload->data(), nameLen - 1);
+		if (*entry) {
+			// The bytes of message are left in |payload|.
+			payload->remove_prefix(nameLen);
+			err = kNoError;
 		} else {
 			err = kUnknownMessageType;
 		}
@@ -371,23 +613,41 @@ ProtobufCodec::ERROR_CODE ProtobufCodec::parse_mesg(NetBuffer* payload, MessageP
 	return err;
 }
 
-google::protobuf::Message* ProtobufCodec::generate_mesg(const std::string& name)
+ProtobufCodec::ERROR_CODE ProtobufCodec::parse_mesg(StringPiece payload, MessagePtr& mesg, 
+													 ProtobufTypeCache::Entry** entry)
 {
-	using namespace google::protobuf;
-	
-	Message* mesg = nullptr;
-	const Descriptor* desc = DescriptorPool::generated_pool()->FindMessageTypeByName(name);
-	if (desc) {
-		const Message* prototype = MessageFactory::generated_factory()->GetPrototype(desc);
-		if (prototype) {
-			mesg = prototype->New();
+	ERROR_CODE err = parse_type(&payload, entry);
+	if (err == kNoError) {
+		// Create (prototype) message object from typename.
+		mesg = ProtobufTypeCache::current().acquire(*entry);
+		// Parse protobuf from payload.
+		if (!mesg->ParseFromArray(payload.data(), static_cast<int>(payload.size()))) {
+			err = kParseError;
+		}
+	}
+
+	return err;
+}
+
+ProtobufCodec::ERROR_CODE ProtobufCodec::parse_mesg(StringPiece payload, google::protobuf::Arena* arena, 
+													 google::protobuf::Message** mesg)
+{
+	ProtobufTypeCache::Entry* entry = nullptr;
+
+	ERROR_CODE err = parse_type(&payload, &entry);
+	if (err == kNoError) {
+		// Create (prototype) message object on the arena.
+		*mesg = entry->prototype->New(arena);
+		// Parse protobuf from payload.
+		if (!(*mesg)->ParseFromArray(payload.data(), static_cast<int>(payload.size()))) {
+			err = kParseError;
 		}
 	}
 
-	return mesg;
+	return err;
 }
 
-void ProtobufCodec::error_callback(const TcpConnectionPtr& conn, NetBuffer*, TimeStamp, ERROR_CODE err)
+void ProtobufCodec::error_callback(const TcpConnectionPtr& conn, const StringPiece&, TimeStamp, ERROR_CODE err)
 {
 	LOG(ERROR) << "ProtobufCodec::error_callback - " << to_errstr(err);
 	if (conn) {
@@ -9,11 +9,14 @@
 #include "TimeStamp.h"
 #include "TcpConnection.h"
 #include "CallbackForward.h"
+#include "protobuf/ProtobufArena.h"
 
-#include <map>
+#include <memory>
+#include <vector>
 #include <utility>
 #include <functional>
 #include <type_traits>
+#include <stdint.h>		// uintptr_t
 
 #include <google/protobuf/message.h>
 
@@ -29,6 +32,7 @@ class Callback
 public:
 	virtual ~Callback() = default;
 	virtual void operator()(const TcpConnectionPtr&, const MessagePtr&, TimeStamp) const = 0;
+	virtual void operator()(const TcpConnectionPtr&, const ProtobufArenaMessage&, TimeStamp) const = 0;
 };
 
 template <typename T>
@@ -44,58 +48,185 @@ public:
 
 	CallbackT(const ProtobufMessageTCallback& cb) : cb_(cb) {}
 
+	// The |mesg| is created from the generated prototype of T::descriptor(),
+	// it is dispatched by the descriptor, so no RTTI cast is needed.
 	void operator()(const TcpConnectionPtr& conn, const MessagePtr& mesg, TimeStamp receive) const override
 	{
-		std::shared_ptr<T> concrete = std::dynamic_pointer_cast<T>(mesg);
-		CHECK(concrete);
+		DCHECK(dynamic_cast<T*>(mesg.get()));
 		
-		cb_(conn, concrete, receive);
+		cb_(conn, std::static_pointer_cast<T>(mesg), receive);
+	}
+
+	// The callback may keep the shared |mesg|, so it is copied out of arena.
+	void operator()(const TcpConnectionPtr& conn, const ProtobufArenaMessage& mesg, TimeStamp receive) const override
+	{
+		(*this)(conn, mesg.detach(), receive);
 	}
 
 private:
 	ProtobufMessageTCallback cb_;
 };
 
+template <typename T>
+class ArenaCallbackT : public Callback
+{
+// compile-time assertion checking
+static_assert(std::is_base_of<google::protobuf::Message, T>::value,
+		"T must be derived from google::protobuf::Message.");
+
+public:
+	// The |mesg| is borrowed, it is valid only until the callback returns.
+	using ProtobufArenaMessageTCallback = 
+			std::function<void(const TcpConnectionPtr&, T*, TimeStamp)>;
+
+	ArenaCallbackT(const ProtobufArenaMessageTCallback& cb) : cb_(cb) {}
+
+	void operator()(const TcpConnectionPtr& conn, const MessagePtr& mesg, TimeStamp receive) const override
+	{
+		DCHECK(dynamic_cast<T*>(mesg.get()));
+
+		cb_(conn, static_cast<T*>(mesg.get()), receive);
+	}
+
+	void operator()(const TcpConnectionPtr& conn, const ProtobufArenaMessage& mesg, TimeStamp receive) const override
+	{
+		cb_(conn, mesg.cast<T>(), receive);
+	}
+
+private:
+	ProtobufArenaMessageTCallback cb_;
+};
+
 // A simple dispatcher of protobuf message.
+//
+// The callbacks are compiled into a flat open-addressed table keyed by the
+// descriptor of message when they are registered, so dispatch() is a probe
+// of the pointer hash.
+//
+// The messages parsed on the arena of ProtobufCodec (see enable_arena()) are
+// dispatched by dispatch_arena(). The callbacks of add_arena() borrow them,
+// the callbacks of add() get a heap copy of them.
 class ProtobufDispatch
 {
 public:
 	ProtobufDispatch(ProtobufMessageCallback cb = ProtobufDispatch::unknown) 
-		: default_cb_(std::move(cb)) {}
+		: table_(kInitialSize, Slot{nullptr, nullptr})
+		, default_cb_(std::move(cb)) {}
 
 	// Register protobuf message callbacks.
+	// *Not thread safe*, but usually be called before dispatch().
 	template <typename T>
 	void add(const typename CallbackT<T>::ProtobufMessageTCallback& cb)
 	{
-		std::shared_ptr<CallbackT<T>> pd(new CallbackT<T>(cb));
-		cbs_[T::descriptor()] = pd;
+		insert(T::descriptor(), std::unique_ptr<Callback>(new CallbackT<T>(cb)));
+	}
+
+	// Register protobuf message callbacks, that borrow the message.
+	// *Not thread safe*, but usually be called before dispatch().
+	template <typename T>
+	void add_arena(const typename ArenaCallbackT<T>::ProtobufArenaMessageTCallback& cb)
+	{
+		insert(T::descriptor(), std::unique_ptr<Callback>(new ArenaCallbackT<T>(cb)));
 	}
 
 	void dispatch(const TcpConnectionPtr&, const MessagePtr&, TimeStamp) const;
+	void dispatch_arena(const TcpConnectionPtr&, const ProtobufArenaMessage&, TimeStamp) const;
 
 private:
 	static void unknown(const TcpConnectionPtr&, const MessagePtr&, TimeStamp);
 
+	void insert(const google::protobuf::Descriptor*, std::unique_ptr<Callback>);
+	const Callback* find(const google::protobuf::Descriptor*) const;
+
+	size_t home(const google::protobuf::Descriptor* desc) const
+	{
+		// The descriptors are aligned, drop the low zero bits.
+		return (reinterpret_cast<uintptr_t>(desc) >> 4) & (table_.size() - 1);
+	}
+
 private:
-	using CallbackMap = 
-			std::map<const google::protobuf::Descriptor*, std::shared_ptr<Callback>>;
+	static const size_t kInitialSize = 16;
+
+	struct Slot
+	{
+		const google::protobuf::Descriptor* desc;	// nullptr is empty
+		const Callback* cb;
+	};
 
 	// Protobuf callback lists.
 	// [
 	//		T::descriptor() => callback,
 	// ]
-	CallbackMap cbs_;
+	std::vector<Slot> table_;
+	std::vector<std::unique_ptr<Callback>> cbs_;
 
 	ProtobufMessageCallback default_cb_;
 
 	DISALLOW_COPY_AND_ASSIGN(ProtobufDispatch);
 };
 
+void ProtobufDispatch::insert(const google::protobuf::Descriptor* desc, std::unique_ptr<Callback> cb)
+{
+	CHECK(desc && cb);
+
+	// Re-registration replaces the callback in place, the old one is destroyed.
+	const size_t mask = table_.size() - 1;
+	for (size_t i = home(desc); table_[i].desc; i = (i + 1) & mask) {
+		if (table_[i].desc == desc) {
+			for (auto& owned : cbs_) {
+				if (owned.get() == table_[i].cb) {
+					table_[i].cb = cb.get();
+					owned = std::move(cb);
+					return;
+				}
+			}
+			NOTREACHED();
+		}
+	}
+
+	cbs_.push_back(std::move(cb));
+
+	// Keep the load factor under 50%, rebuild the table.
+	size_t size = 0;
+	for (const Slot& slot : table_) {
+		size += slot.desc? 1: 0;
+	}
+	std::vector<Slot> slots;
+	slots.swap(table_);
+	slots.push_back(Slot{desc, cbs_.back().get()});
+
+	size_t capacity = slots.size() - 1;
+	while ((size + 1) * 2 > capacity) {
+		capacity *= 2;
+	}
+	table_.assign(capacity, Slot{nullptr, nullptr});
+	for (const Slot& slot : slots) {
+		if (slot.desc) {
+			size_t i = home(slot.desc);
+			while (table_[i].desc) {
+				i = (i + 1) & (table_.size() - 1);
+			}
+			table_[i] = slot;
+		}
+	}
+}
+
+const Callback* ProtobufDispatch::find(const google::protobuf::Descriptor* desc) const
+{
+	const size_t mask = table_.size() - 1;
+	for (size_t i = home(desc); table_[i].desc; i = (i + 1) & mask) {
+		if (table_[i].desc == desc) {
+			return table_[i].cb;
+		}
+	}
+	return nullptr;
+}
+
 void ProtobufDispatch::dispatch(const TcpConnectionPtr& conn, const MessagePtr& mesg, TimeStamp receive) const
 {
-	CallbackMap::const_iterator it = cbs_.find(mesg->GetDescriptor());
-	if (it != cbs_.end()) {
-		(*it->second)(conn, mesg, receive);
+	const Callback* cb = find(mesg->GetDescriptor());
+	if (cb) {
+		(*cb)(conn, mesg, receive);
 	} else {
 		// Unknown protobuf message.
 		if (default_cb_) {
@@ -107,6 +238,22 @@ void ProtobufDispatch::dispatch(const TcpConnectionPtr& conn, const MessagePtr&
 	}
 }
 
+void ProtobufDispatch::dispatch_arena(const TcpConnectionPtr& conn, const ProtobufArenaMessage& mesg, TimeStamp receive) const
+{
+	const Callback* cb = find(mesg->GetDescriptor());
+	if (cb) {
+		(*cb)(conn, mesg, receive);
+	} else {
+		// Unknown protobuf message.
+		if (default_cb_) {
+			default_cb_(conn, mesg.detach(), receive);
+		} else {
+			LOG(ERROR) << "ProtobufDispatch::dispatch_arena Invalid message, TypeName=" 
+				<< mesg->GetTypeName();
+		}
+	}
+}
+
 void ProtobufDispatch::unknown(const TcpConnectionPtr&, const MessagePtr& mesg, TimeStamp)
 {
 	LOG(WARNING) << "ProtobufDispatch::unknown - " << mesg->GetTypeName();
@@ -6,17 +6,27 @@
 
 #include "EventLoop.h"
 #include "Logging.h"
+#include "NetBuffer.h"
+#include "TimerId.h"
+#include "TimeStamp.h"
+#include "containers/Bind.h"
+#include "threading/ThreadPool.h"
 #include "synchronization/MutexLock.h"
 #include "protobuf/ProtobufCodec.h"
 #include "protobuf/ProtobufDispatch.h"
+#include "protorpc/ProtorpcController.h"
 
 // Define the protorpc bytes protocol.
 #include "ProtorpcMessage.pb.h"
 
 #include <map>
+#include <deque>
 #include <string>
+#include <vector>
 #include <atomic>
 #include <memory>
+#include <utility>
+#include <algorithm>
 
 #include <google/protobuf/message.h>
 #include <google/protobuf/descriptor.h>
@@ -30,11 +40,95 @@ using ProtorpcMessagePtr = std::shared_ptr<ProtorpcMessage>;
 class ProtorpcChannel;
 using ProtorpcChannelPtr = std::shared_ptr<ProtorpcChannel>;
 
-class ProtorpcChannel : public ::google::protobuf::RpcChannel
+// The timing of one method of service, it is shared by the channels of all
+// connections. The queueing delay is from the request is received to the
+// method is called, the execution time is until the done closure is called.
+// *Thread safe*
+struct ProtorpcMethodStats
+{
+	void record(TimeDelta queue, TimeDelta exec);
+
+	std::atomic<int64_t> calls{0};
+	std::atomic<int64_t> expired{0};
+	std::atomic<int64_t> queue_us{0};
+	std::atomic<int64_t> max_queue_us{0};
+	std::atomic<int64_t> exec_us{0};
+	std::atomic<int64_t> max_exec_us{0};
+};
+
+// The service impl registered into the channels. The methods are called in
+// the |pool| (nullptr is in the loop of connection).
+struct ProtorpcService
+{
+	explicit ProtorpcService(::google::protobuf::Service* s, ThreadPool* p = nullptr)
+		: impl(s)
+		, pool(p)
+		, stats(new ProtorpcMethodStats[s->GetDescriptor()->method_count()]) {}
+
+	ProtorpcMethodStats& method_stats(const ::google::protobuf::MethodDescriptor* method)
+	{
+		return stats[method->index()];
+	}
+
+	::google::protobuf::Service* impl;
+	ThreadPool* pool;
+	std::unique_ptr<ProtorpcMethodStats[]> stats;
+};
+using ProtorpcServicePtr = std::shared_ptr<ProtorpcService>;
+
+// The channels whose requests are parked on the full pools. They are woken
+// (resumed in their own loops) when a task of the pool is started, which
+// frees a slot of the queue, or when a queued task is dropped by stop().
+// *Thread safe*
+class ProtorpcPoolWaiters
+{
+public:
+	static ProtorpcPoolWaiters& instance()
+	{
+		static ProtorpcPoolWaiters waiters;
+		return waiters;
+	}
+
+	// Wakes |channel| once, when a slot of |pool| is free.
+	void wait(ThreadPool* pool, const ProtorpcChannelPtr& channel);
+
+	// Wakes all the channels waiting for |pool|.
+	void wake(ThreadPool* pool);
+
+private:
+	// The number of waiting channels, wake() is lock free if it is 0.
+	std::atomic<int> size_{0};
+
+	MutexLock lock_;
+	std::map<ThreadPool*, std::vector<std::weak_ptr<ProtorpcChannel>>> waiters_;
+};
+
+// The protobuf rpc channel of one connection, both for client and server.
+//
+// Many calls can be in flight on a connection (pipelined), the responses 
+// are matched by the call id in an open-addressed table, which is only 
+// accessed in the own loop thread, so there is no lock on the call path.
+//
+// The deadline of call (ProtorpcController::set_timeout() or the default of
+// channel) is carried on the wire, the server skips the expired requests.
+// The expired calls are swept in batches by one timer of the own loop, and
+// fail with the TIMEOUT error, the calls in flight fail with DISCONNECTED
+// when the connection is detached.
+//
+// The methods of service are called in the loop, or in the ThreadPool of
+// service, and the responses are posted back to the loop. When the pool is
+// full, the requests are parked and the connection stops reading until the
+// pool accepts them again (back-pressure to the client).
+//
+// NOTICE: The channel must be owned by ProtorpcChannelPtr, CallMethod() 
+// from the other threads is posted to the own loop with a strong pointer.
+class ProtorpcChannel : public ::google::protobuf::RpcChannel,
+						public std::enable_shared_from_this<ProtorpcChannel>
 {
 public:
 	explicit ProtorpcChannel(EventLoop* loop)
-		: codec_(loop, std::bind(
+		: loop_(loop)
+		, codec_(loop, std::bind(
 				&ProtobufDispatch::dispatch, 
 				&dispatch_, 
 				std::placeholders::_1, 
@@ -58,10 +152,15 @@ public:
 	{
 		DLOG(TRACE) << "ProtorpcChannel::~ProtorpcChannel - " << this;
 		
-		for (const auto& outstanding : outstandings_) {
-			OutstandingCall out = outstanding.second;
-			delete out.resp;
+		if (sweeping_) {
+			loop_->cancel(sweep_timer_);
 		}
+		for (ServerCall* call : parked_) {
+			delete call;
+		}
+		outstandings_.for_each([](const OutstandingCall& out) {
+			delete out.resp;
+		});
 	}
 
 	// Register protorpc service impl.
@@ -70,7 +169,13 @@ public:
 	{
 		CHECK(service);
 
-		const google::protobuf::ServiceDescriptor* desc = service->GetDescriptor();
+		add(std::make_shared<ProtorpcService>(service));
+	}
+	void add(const ProtorpcServicePtr& service)
+	{
+		CHECK(service && service->impl);
+
+		const google::protobuf::ServiceDescriptor* desc = service->impl->GetDescriptor();
 		services_[desc->full_name()] = service;
 	}
 
@@ -79,18 +184,41 @@ public:
 	// but the requirements are less strict in one important way:  the request 
 	// and response objects need not be of any specific class as long as their 
 	// descriptors are method->input_type() and method->output_type().
+	//
+	// The |request| is serialized by the calling thread, the |response| is
+	// owned by the channel, it will be deleted after |done| is called.
+	// *Thread safe*
 	virtual void CallMethod(const ::google::protobuf::MethodDescriptor* method,
 							::google::protobuf::RpcController* controller,
 							const ::google::protobuf::Message* request,
 							::google::protobuf::Message* response,
 							::google::protobuf::Closure* done) override;
 	
+	// The calls in flight fail with the DISCONNECTED error.
 	// *Not thread safe*, but run in own loop thread.
 	void detach_connection()
 	{
 		CHECK(conn_);
 
 		conn_.reset();
+
+		// The parked requests can not be answered, release them.
+		for (ServerCall* call : parked_) {
+			delete call;
+		}
+		parked_.clear();
+		waiting_pool_ = nullptr;
+
+		std::vector<OutstandingCall> calls;
+		calls.reserve(outstandings_.size());
+		outstandings_.for_each([&calls](const OutstandingCall& out) {
+			calls.push_back(out);
+		});
+		outstandings_.clear();
+
+		for (const OutstandingCall& out : calls) {
+			fail(out, ProtorpcMessage::DISCONNECTED);
+		}
 	}
 
 	// *Not thread safe*, but run in own loop thread.
@@ -110,22 +238,218 @@ public:
 		// Then the `ProtorpcChannel::dispatch` will be called.
 	}
 
+	// The default timeout of calls in seconds, 0 is no deadline.
+	// *Not thread safe*, but usually be called before the calls.
+	void set_timeout(double timeout_s)
+	{
+		CHECK(timeout_s >= 0);
+		timeout_s_ = timeout_s;
+	}
+
+	// Gives up the call of |id|, it fails with the CANCELED error.
+	// *Thread safe*
+	void cancel(int64_t id);
+
+	// The number of calls waiting for response.
+	// *Not thread safe*, but run in the own loop.
+	size_t outstanding_size() const
+	{
+		return outstandings_.size();
+	}
+
 private:
 	// *Not thread safe*, but run in the own loop.
 	void dispatch(const TcpConnectionPtr&, const ProtorpcMessagePtr&, TimeStamp);
-	void request(const ProtorpcMessage&);
+	void request(const ProtorpcMessage&, TimeStamp);
 	void response(const ProtorpcMessage&);
 
-	void finish(::google::protobuf::Message*, int64_t);
+	// protobuf rpc request of server, it is the done closure of method.
+	// The Run() may be called in any thread.
+	class ServerCall : public ::google::protobuf::Closure
+	{
+	public:
+		virtual void Run() override;
+
+		std::weak_ptr<ProtorpcChannel> channel;
+		EventLoop* loop;
+		ProtorpcService* service;
+		const ::google::protobuf::MethodDescriptor* method;
+		int64_t id;
+		std::unique_ptr<::google::protobuf::Message> req;
+		std::unique_ptr<::google::protobuf::Message> res;
+		ProtorpcMessage::ERROR_CODE error{ProtorpcMessage::NO_ERROR};
+		// On the monotonic clock (TimeStamp::now_monotonic()).
+		TimeStamp receive;
+		TimeStamp deadline;		// null is no deadline
+		TimeStamp start;
+	};
+
+	// The task of pool owns the call until it is executed. If the task is
+	// dropped (ThreadPool::stop()), the call fails with the CANCELED error.
+	struct PooledCall
+	{
+		explicit PooledCall(ServerCall* c) : call(c) {}
+		~PooledCall();
+
+		ServerCall* call;
+	};
+
+	// Calls the method of the call in the pool thread.
+	static void execute(const std::shared_ptr<PooledCall>& task);
+
+	// *Not thread safe*, but run in the own loop.
+	void finish(const std::shared_ptr<ServerCall>& call);
+	void failed(int64_t id, ProtorpcMessage::ERROR_CODE err);
+
+	// Submits the |call| into the pool of service, or parks it if the pool
+	// is full. The parked calls are resumed when the pool has a free slot
+	// (ProtorpcPoolWaiters), they fail with CANCELED if it is stopped.
+	// *Not thread safe*, but run in the own loop.
+	void submit(ServerCall* call);
+	bool try_submit(ServerCall* call);
+	void resume();
+	void handle_wakeup();
+
+	// Queues resume() into the own loop, by ProtorpcPoolWaiters.
+	// *Thread safe*
+	void wakeup();
+	friend class ProtorpcPoolWaiters;
 
 	// protobuf rpc request of client.
 	struct OutstandingCall
 	{
+		int64_t id;		// 0 is empty
 		::google::protobuf::Message* resp;
 		::google::protobuf::Closure* done;
+		::google::protobuf::RpcController* controller;
+		TimeStamp deadline;		// null is no deadline, monotonic
+	};
+
+	// *Not thread safe*, but run in the own loop.
+	void send_request(const OutstandingCall& call, NetBuffer& frame);
+	void cancel_in_loop(int64_t id);
+	void fail(const OutstandingCall& call, ProtorpcMessage::ERROR_CODE err);
+
+	// Expires the calls of passed deadline in batches, in every sweep interval.
+	// *Not thread safe*, but run in the own loop.
+	void start_sweep(TimeStamp deadline);
+	void sweep();
+
+	// Open-addressed (Robin Hood linear probing) table of calls by id. The ids
+	// are sequential, so the calls in flight rarely collide.
+	// *Not thread safe*, but run in the own loop.
+	class CallTable
+	{
+	public:
+		CallTable() : calls_(kInitialSize, OutstandingCall()) {}
+
+		size_t size() const { return size_;}
+
+		void insert(const OutstandingCall& call)
+		{
+			DCHECK(call.id > 0);
+			if ((size_ + 1) * 2 > calls_.size()) {
+				grow();
+			}
+			place(call);
+			size_++;
+		}
+
+		// Removes the call of |id| into |call|.
+		bool take(int64_t id, OutstandingCall* call)
+		{
+			const size_t mask = calls_.size() - 1;
+			size_t i = home(id);
+			for (size_t d = 0; calls_[i].id != 0 && d <= distance(i); i = (i + 1) & mask, d++) {
+				if (calls_[i].id == id) {
+					*call = calls_[i];
+					erase_at(i);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void clear()
+		{
+			std::fill(calls_.begin(), calls_.end(), OutstandingCall());
+			size_ = 0;
+		}
+
+		template <typename F>
+		void for_each(F&& f) const
+		{
+			for (const OutstandingCall& call : calls_) {
+				if (call.id != 0) {
+					f(call);
+				}
+			}
+		}
+
+	private:
+		static const size_t kInitialSize = 64;
+
+		size_t home(int64_t id) const
+		{
+			return static_cast<size_t>(id) & (calls_.size() - 1);
+		}
+
+		// The probe distance of the call in slot |i| from its home slot.
+		size_t distance(size_t i) const
+		{
+			return (i - home(calls_[i].id)) & (calls_.size() - 1);
+		}
+
+		// Robin Hood insertion, the call that is farther from its home slot
+		// takes the slot, so a deletion stops shifting at a home slot.
+		void place(OutstandingCall call)
+		{
+			const size_t mask = calls_.size() - 1;
+			size_t i = home(call.id);
+			for (size_t d = 0; calls_[i].id != 0; i = (i + 1) & mask, d++) {
+				size_t incumbent = distance(i);
+				if (incumbent < d) {
+					std::swap(call, calls_[i]);
+					d = incumbent;
+				}
+			}
+			calls_[i] = call;
+		}
+
+		void grow()
+		{
+			std::vector<OutstandingCall> calls(calls_.size() * 2, OutstandingCall());
+			calls.swap(calls_);
+			for (const OutstandingCall& call : calls) {
+				if (call.id != 0) {
+					place(call);
+				}
+			}
+		}
+
+		// Backward shift deletion, no tombstone. The calls after the hole
+		// are shifted until an empty slot or a call in its home slot.
+		void erase_at(size_t i)
+		{
+			const size_t mask = calls_.size() - 1;
+			for (size_t j = (i + 1) & mask; calls_[j].id != 0 && distance(j) > 0; j = (j + 1) & mask) {
+				calls_[i] = calls_[j];
+				i = j;
+			}
+			calls_[i] = OutstandingCall();
+			size_--;
+		}
+
+	private:
+		std::vector<OutstandingCall> calls_;
+		size_t size_{0};
 	};
 
 private:
+	// The granularity of deadlines.
+	static constexpr double kSweepInterval = 0.01;
+
+	EventLoop* loop_;
 	TcpConnectionPtr conn_;
 
 	// Protobuf bytes codec.
@@ -135,17 +459,29 @@ private:
 	std::atomic<int64_t> id_{0};
 
 	// protobuf rpc request of client.
-	MutexLock lock_;
-	std::map<int64_t, OutstandingCall> outstandings_;
+	CallTable outstandings_;
+
+	// The default timeout of calls.
+	double timeout_s_{0};
+
+	// The sweep timer is armed while any call has a deadline.
+	bool sweeping_{false};
+	TimerId sweep_timer_;
+	TimeStamp next_expire_;
+
+	// The requests wait for the full pools, the reading is stopped.
+	std::deque<ServerCall*> parked_;
+	// The pool the channel is waiting for, nullptr is none.
+	ThreadPool* waiting_pool_{nullptr};
 
 	// Protorpc service lists.
 	// [
-	//		"service-name" => service-impl*,
+	//		"service-name" => service-impl,
 	// ]
-	std::map<std::string, ::google::protobuf::Service*> services_;
+	std::map<std::string, ProtorpcServicePtr> services_;
 };
 
-void ProtorpcChannel::dispatch(const TcpConnectionPtr& conn, const ProtorpcMessagePtr& mesg, TimeStamp)
+void ProtorpcChannel::dispatch(const TcpConnectionPtr& conn, const ProtorpcMessagePtr& mesg, TimeStamp receive)
 {
 	DLOG(TRACE) << "ProtorpcChannel::dispatch - " << mesg->DebugString();
 
@@ -153,7 +489,7 @@ void ProtorpcChannel::dispatch(const TcpConnectionPtr& conn, const ProtorpcMessa
 
 	switch (static_cast<int>(mesg->type())) {
 		case ProtorpcMessage::REQUEST:
-			request(*mesg);
+			request(*mesg, receive);
 			break;
 
 		case ProtorpcMessage::RESPONSE:
@@ -173,64 +509,76 @@ void ProtorpcChannel::response(const ProtorpcMessage& mesg)
 
 	CHECK(conn_);
 
-	OutstandingCall out = { nullptr, nullptr};
-	{
-		AutoLock locked(lock_);
-		std::map<int64_t, OutstandingCall>::iterator it = outstandings_.find(mesg.id());
-		if (it != outstandings_.end()) {
-			out = it->second;
-			outstandings_.erase(it);
-		}
+	OutstandingCall out;
+	if (!outstandings_.take(mesg.id(), &out)) {
+		// The call has been expired or canceled.
+		return;
 	}
 
-	if (out.resp) {
-		// RAII for release the out.resp* (New in RpcClient::new_connection).
-		std::unique_ptr<google::protobuf::Message> l(out.resp);
+	if (mesg.error() != ProtorpcMessage::NO_ERROR) {
+		fail(out, mesg.error());
+		return;
+	}
+	if (!out.resp->ParseFromString(mesg.response())) {
+		fail(out, ProtorpcMessage::INVALID_RESPONSE);
+		return;
+	}
 
-		out.resp->ParseFromString(mesg.response());
-		if (out.done) {
-			// RpcClient::done() will be called.
-			out.done->Run();
-		}
+	// RAII for release the out.resp* (New in RpcClient::new_connection).
+	std::unique_ptr<google::protobuf::Message> l(out.resp);
+	if (out.done) {
+		// RpcClient::done() will be called.
+		out.done->Run();
 	}
 }
 
-void ProtorpcChannel::request(const ProtorpcMessage& mesg)
+void ProtorpcChannel::request(const ProtorpcMessage& mesg, TimeStamp /*receive*/)
 {
 	DLOG(TRACE) << "ProtorpcChannel::request req - " << mesg.DebugString();
 
 	CHECK(conn_);
 
-	auto failed = [this] (ProtorpcMessage::ERROR_CODE err, const ProtorpcMessage& mesg) {
-		ProtorpcMessage resp;
-		resp.set_id(mesg.id());
-		resp.set_error(err);
-		resp.set_type(ProtorpcMessage::RESPONSE);
-
-		codec_.send(conn_, resp);
-	};
-
 	// Init error code.
 	ProtorpcMessage::ERROR_CODE err = ProtorpcMessage::WRONG_PROTO;
 
 	// Lookup listen impl services.
-	std::map<std::string, google::protobuf::Service*>::const_iterator it = services_.find(mesg.service());
+	std::map<std::string, ProtorpcServicePtr>::const_iterator it = services_.find(mesg.service());
 	if (it == services_.end()) {
 		err = ProtorpcMessage::NO_SERVICE;
-		failed(err, mesg);
+		failed(mesg.id(), err);
 		return;
 	}
 
 	// Service descriptor by impl.
-	google::protobuf::Service* impl = it->second;
+	ProtorpcService* service = it->second.get();
+	google::protobuf::Service* impl = service->impl;
 	const google::protobuf::ServiceDescriptor* desc = impl->GetDescriptor();
 	CHECK(desc);
 
 	// Method descriptor by method name.
-	const google::protobuf::MethodDescriptor* method = impl->GetDescriptor()->FindMethodByName(mesg.method());
+	const google::protobuf::MethodDescriptor* method = desc->FindMethodByName(mesg.method());
 	if (!method) {
 		err = ProtorpcMessage::NO_METHOD;
-		failed(err, mesg);
+		failed(mesg.id(), err);
+		return;
+	}
+
+	// The deadlines are on the monotonic clock, the request is received in
+	// the current iteration of loop.
+	TimeStamp received = loop_->loop_monotonic_time();
+	TimeStamp deadline;
+	if (mesg.timeout() > 0) {
+		deadline = received + TimeDelta::from_milliseconds(mesg.timeout());
+	}
+
+	// Skip the request that has been expired (waiting in the socket and the
+	// input buffer), the client has given up it.
+	TimeStamp now = TimeStamp::now_monotonic();
+	if (!deadline.is_null() && deadline < now) {
+		service->method_stats(method).expired.fetch_add(1, std::memory_order_relaxed);
+
+		err = ProtorpcMessage::TIMEOUT;
+		failed(mesg.id(), err);
 		return;
 	}
 
@@ -240,36 +588,246 @@ void ProtorpcChannel::request(const ProtorpcMessage& mesg)
 	// Parse request bytes.
 	if (!req->ParseFromString(mesg.request())) {
 		err = ProtorpcMessage::INVALID_REQUEST;
-		failed(err, mesg);
+		failed(mesg.id(), err);
 		return;
 	}
 
-	// res will be release in ProtorpcChannel::finish().
-	google::protobuf::Message* res = impl->GetResponsePrototype(method).New();
+	// The call will be released in ServerCall::Run().
+	ServerCall* call = new ServerCall();
+	call->channel = shared_from_this();
+	call->loop = loop_;
+	call->service = service;
+	call->method = method;
+	call->id = mesg.id();
+	call->req = std::move(req);
+	call->res.reset(impl->GetResponsePrototype(method).New());
+	call->receive = received;
+	call->deadline = deadline;
+
+	if (service->pool) {
+		submit(call);
+		return;
+	}
 
 	// After here, the `Service::CallMethod` will be called, and then finish().
 	// NOTE: Service::CallMethod is not Channel::CallMethod.
-	impl->CallMethod(method, nullptr, req.get(), res, 
-				NewCallback(this, &ProtorpcChannel::finish, res, mesg.id()));
+	call->start = now;
+	impl->CallMethod(method, nullptr, call->req.get(), call->res.get(), call);
+}
+
+ProtorpcChannel::PooledCall::~PooledCall()
+{
+	if (call) {
+		ThreadPool* pool = call->service->pool;
+
+		call->error = ProtorpcMessage::CANCELED;
+		call->Run();
+
+		ProtorpcPoolWaiters::instance().wake(pool);
+	}
+}
+
+void ProtorpcChannel::execute(const std::shared_ptr<PooledCall>& task)
+{
+	// FOR SERVER RPC REQUEST IN POOL.
+
+	ServerCall* call = task->call;
+	task->call = nullptr;
+
+	// A slot of the queue is free now.
+	ProtorpcPoolWaiters::instance().wake(call->service->pool);
+
+	call->start = TimeStamp::now_monotonic();
+
+	// Skip the request that has been expired in the queue of pool.
+	if (!call->deadline.is_null() && call->deadline < call->start) {
+		call->service->method_stats(call->method).expired.fetch_add(1, std::memory_order_relaxed);
+		call->error = ProtorpcMessage::TIMEOUT;
+		call->Run();
+		return;
+	}
+
+	call->service->impl->CallMethod(call->method, nullptr, 
+				call->req.get(), call->res.get(), call);
+}
+
+void ProtorpcChannel::ServerCall::Run()
+{
+	std::shared_ptr<ServerCall> self(this);
+
+	if (error == ProtorpcMessage::NO_ERROR) {
+		service->method_stats(method).record(start - receive, TimeStamp::now_monotonic() - start);
+	}
+
+	if (loop->is_in_own_loop()) {
+		ProtorpcChannelPtr locked = channel.lock();
+		if (locked) {
+			locked->finish(self);
+		}
+	} else {
+		// Post the response back to the loop of connection.
+		using containers::make_weak_bind;
+		loop->queue_in_own_loop(
+			make_weak_bind(&ProtorpcChannel::finish, channel, std::move(self)));
+	}
 }
 
-void ProtorpcChannel::finish(::google::protobuf::Message* res, int64_t id)
+void ProtorpcChannel::finish(const std::shared_ptr<ServerCall>& call)
 {
 	// FOR SERVER RPC RESPONSE.
 
-	DLOG(TRACE) << "ProtorpcChannel::finish res - " << res->DebugString();
+	loop_->check_in_own_loop();
 
-	CHECK(conn_ && res);
+	DLOG(TRACE) << "ProtorpcChannel::finish res - " << call->res->DebugString();
 
-	// RAII for release the res* (New in ProtorpcChannel::request).
-	std::unique_ptr<google::protobuf::Message> l(res);
+	if (conn_) {
+		if (call->error != ProtorpcMessage::NO_ERROR) {
+			failed(call->id, call->error);
+		} else {
+			ProtorpcMessage mesg;
+			mesg.set_id(call->id);
+			mesg.set_type(ProtorpcMessage::RESPONSE);
 
-	ProtorpcMessage mesg;
-	mesg.set_id(id);
-	mesg.set_response(res->SerializeAsString()); // FIXME: error check
-	mesg.set_type(ProtorpcMessage::RESPONSE);
+			// The response is serialized into the frame in place.
+			NetBuffer frame;
+			if (codec_.serialize_frame(mesg, &frame, 
+					ProtorpcMessage::kResponseFieldNumber, call->res.get()))
+			{
+				conn_->send(&frame);
+			}
+		}
+	}
+
+	// A slot of pool may be free now.
+	resume();
+}
+
+void ProtorpcChannel::failed(int64_t id, ProtorpcMessage::ERROR_CODE err)
+{
+	ProtorpcMessage resp;
+	resp.set_id(id);
+	resp.set_error(err);
+	resp.set_type(ProtorpcMessage::RESPONSE);
+
+	codec_.send(conn_, resp);
+}
+
+void ProtorpcChannel::submit(ServerCall* call)
+{
+	// Keep the order of requests, after the parked ones.
+	if (parked_.empty() && try_submit(call)) {
+		return;
+	}
+
+	if (parked_.empty()) {
+		LOG(DEBUG) << "ProtorpcChannel::submit the pool is full, stop reading "
+			<< conn_->name();
+
+		conn_->stop_read();
+	}
+	parked_.push_back(call);
+
+	resume();
+}
+
+bool ProtorpcChannel::try_submit(ServerCall* call)
+{
+	ThreadPool* pool = call->service->pool;
+	if (!pool->running()) {
+		// The pool is stopped, nothing will run the call.
+		if (conn_) {
+			failed(call->id, ProtorpcMessage::CANCELED);
+		}
+		delete call;
+		return true;
+	}
+
+	std::shared_ptr<PooledCall> task = std::make_shared<PooledCall>(call);
+	if (pool->try_run_task(std::bind(&ProtorpcChannel::execute, task))) {
+		return true;
+	}
+
+	// It is not queued, the call is still parked.
+	task->call = nullptr;
+	return false;
+}
+
+void ProtorpcChannel::resume()
+{
+	loop_->check_in_own_loop();
+
+	if (parked_.empty()) {
+		return;
+	}
+
+	while (!parked_.empty()) {
+		ServerCall* call = parked_.front();
+		if (!try_submit(call)) {
+			ThreadPool* pool = call->service->pool;
+			if (waiting_pool_ == pool) {
+				return;
+			}
+
+			// Waits for a free slot of the pool, then retries once, so the
+			// slot freed before the waiting is not missed.
+			waiting_pool_ = pool;
+			ProtorpcPoolWaiters::instance().wait(pool, shared_from_this());
+			if (!try_submit(call)) {
+				return;
+			}
+		}
+		parked_.pop_front();
+	}
+
+	if (conn_) {
+		conn_->start_read();
+	}
+}
+
+void ProtorpcChannel::wakeup()
+{
+	using containers::make_weak_bind;
+	loop_->queue_in_own_loop(
+		make_weak_bind(&ProtorpcChannel::handle_wakeup, shared_from_this()));
+}
 
-	codec_.send(conn_, mesg);
+void ProtorpcChannel::handle_wakeup()
+{
+	waiting_pool_ = nullptr;
+	resume();
+}
+
+void ProtorpcPoolWaiters::wait(ThreadPool* pool, const ProtorpcChannelPtr& channel)
+{
+	AutoLock locked(lock_);
+	waiters_[pool].push_back(channel);
+	size_.fetch_add(1);
+}
+
+void ProtorpcPoolWaiters::wake(ThreadPool* pool)
+{
+	if (size_.load() == 0) {
+		return;
+	}
+
+	std::vector<std::weak_ptr<ProtorpcChannel>> channels;
+	{
+		AutoLock locked(lock_);
+		auto it = waiters_.find(pool);
+		if (it == waiters_.end()) {
+			return;
+		}
+		channels.swap(it->second);
+		waiters_.erase(it);
+		size_.fetch_sub(static_cast<int>(channels.size()));
+	}
+
+	for (const std::weak_ptr<ProtorpcChannel>& weak : channels) {
+		ProtorpcChannelPtr channel = weak.lock();
+		if (channel) {
+			channel->wakeup();
+		}
+	}
 }
 
 void ProtorpcChannel::CallMethod(const ::google::protobuf::MethodDescriptor* method,
@@ -282,25 +840,185 @@ void ProtorpcChannel::CallMethod(const ::google::protobuf::MethodDescriptor* met
 
 	DLOG(TRACE) << "ProtorpcChannel::CallMethod req - " << request->DebugString();
 
-	CHECK(conn_ && request && response);
+	CHECK(request && response);
 	
-	int64_t id = ++id_;
+	int64_t id = id_.fetch_add(1, std::memory_order_relaxed) + 1;
+
+	OutstandingCall call = { id, response, done, controller, TimeStamp()};
+
+	// The timeout of controller, or the default of channel.
+	double timeout_s = timeout_s_;
+	ProtorpcController* ctl = dynamic_cast<ProtorpcController*>(controller);
+	if (ctl) {
+		if (ctl->timeout() > 0) {
+			timeout_s = ctl->timeout();
+		}
+		using containers::make_weak_bind;
+		ctl->set_cancel_callback(
+			make_weak_bind(&ProtorpcChannel::cancel, shared_from_this(), id));
+	}
 
 	ProtorpcMessage mesg;
 	mesg.set_id(id);
 	mesg.set_service(method->service()->full_name());
 	mesg.set_method(method->name());
-	mesg.set_request(request->SerializeAsString());	// FIXME: error check
 	mesg.set_type(ProtorpcMessage::REQUEST);
+	if (timeout_s > 0) {
+		TimeDelta timeout = TimeDelta::from_seconds_d(timeout_s);
+		call.deadline = TimeStamp::now_monotonic() + timeout;
+		mesg.set_timeout(std::max<int64_t>(timeout.in_milliseconds(), 1));
+	}
+
+	// The request is serialized into the frame in place, by the calling thread.
+	NetBuffer frame;
+	if (!codec_.serialize_frame(mesg, &frame, ProtorpcMessage::kRequestFieldNumber, request)) {
+		frame.has_read_all();
+	}
+
+	if (loop_->is_in_own_loop()) {
+		send_request(call, frame);
+	} else {
+		// The `frame` will be moved into the functor. The channel is held by
+		// a strong reference, the call must not be dropped silently: the
+		// `done` fails with DISCONNECTED if the connection is gone.
+		loop_->queue_in_own_loop(
+			std::bind(&ProtorpcChannel::send_request, shared_from_this(), 
+					call, std::move(frame)));
+	}
+}
+
+void ProtorpcChannel::send_request(const OutstandingCall& call, NetBuffer& frame)
+{
+	loop_->check_in_own_loop();
+
+	if (!conn_ || frame.readable_bytes() == 0) {
+		LOG(ERROR) << "ProtorpcChannel::send_request the call " << call.id 
+			<< " failed, " << (conn_? "invalid request": "no connection");
+
+		fail(call, conn_? ProtorpcMessage::INVALID_REQUEST: ProtorpcMessage::DISCONNECTED);
+		return;
+	}
 
 	// Save request context of client.
-	OutstandingCall out = { response, done};
-	{
-		AutoLock locked(lock_);
-		outstandings_[id] = out;
+	outstandings_.insert(call);
+	if (!call.deadline.is_null()) {
+		start_sweep(call.deadline);
+	}
+
+	conn_->send(&frame);
+}
+
+void ProtorpcChannel::cancel(int64_t id)
+{
+	if (loop_->is_in_own_loop()) {
+		cancel_in_loop(id);
+	} else {
+		using containers::make_weak_bind;
+		loop_->queue_in_own_loop(
+			make_weak_bind(&ProtorpcChannel::cancel_in_loop, shared_from_this(), id));
+	}
+}
+
+void ProtorpcChannel::cancel_in_loop(int64_t id)
+{
+	loop_->check_in_own_loop();
+
+	OutstandingCall out;
+	if (outstandings_.take(id, &out)) {
+		fail(out, ProtorpcMessage::CANCELED);
+	}
+}
+
+void ProtorpcChannel::fail(const OutstandingCall& call, ProtorpcMessage::ERROR_CODE err)
+{
+	DLOG(TRACE) << "ProtorpcChannel::fail the call " << call.id << " - " 
+		<< ProtorpcMessage::ERROR_CODE_Name(err);
+
+	// RAII for release the resp* (New in RpcClient).
+	std::unique_ptr<google::protobuf::Message> l(call.resp);
+
+	if (call.controller) {
+		ProtorpcController* ctl = dynamic_cast<ProtorpcController*>(call.controller);
+		if (ctl) {
+			ctl->set_error(err, ProtorpcMessage::ERROR_CODE_Name(err));
+		} else {
+			call.controller->SetFailed(ProtorpcMessage::ERROR_CODE_Name(err));
+		}
+	}
+	if (call.done) {
+		call.done->Run();
+	}
+}
+
+void ProtorpcChannel::start_sweep(TimeStamp deadline)
+{
+	if (!sweeping_ || deadline < next_expire_) {
+		next_expire_ = deadline;
+	}
+	if (!sweeping_) {
+		sweeping_ = true;
+
+		using containers::make_weak_bind;
+		sweep_timer_ = loop_->run_after(kSweepInterval,
+			make_weak_bind(&ProtorpcChannel::sweep, shared_from_this()));
+	}
+}
+
+void ProtorpcChannel::sweep()
+{
+	loop_->check_in_own_loop();
+
+	sweeping_ = false;
+	if (outstandings_.size() == 0) {
+		return;
+	}
+
+	// Scan the table only when the earliest deadline has passed.
+	TimeStamp now = TimeStamp::now_monotonic();
+	if (now < next_expire_) {
+		start_sweep(next_expire_);
+		return;
+	}
+
+	std::vector<int64_t> expired;
+	TimeStamp next;
+	outstandings_.for_each([&](const OutstandingCall& out) {
+		if (out.deadline.is_null()) {
+			return;
+		}
+		if (out.deadline <= now) {
+			expired.push_back(out.id);
+		} else if (next.is_null() || out.deadline < next) {
+			next = out.deadline;
+		}
+	});
+
+	for (int64_t id : expired) {
+		OutstandingCall out;
+		if (outstandings_.take(id, &out)) {
+			fail(out, ProtorpcMessage::TIMEOUT);
+		}
+	}
+
+	// The calls of done callbacks may have armed the timer.
+	if (!next.is_null()) {
+		start_sweep(next);
 	}
+}
+
+void ProtorpcMethodStats::record(TimeDelta queue, TimeDelta exec)
+{
+	auto update_max = [](std::atomic<int64_t>& max, int64_t value) {
+		int64_t prev = max.load(std::memory_order_relaxed);
+		while (prev < value && 
+			!max.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {}
+	};
 
-	codec_.send(conn_, mesg);
+	calls.fetch_add(1, std::memory_order_relaxed);
+	queue_us.fetch_add(queue.in_microseconds(), std::memory_order_relaxed);
+	exec_us.fetch_add(exec.in_microseconds(), std::memory_order_relaxed);
+	update_max(max_queue_us, queue.in_microseconds());
+	update_max(max_exec_us, exec.in_microseconds());
 }
 
 }	// namespace annety
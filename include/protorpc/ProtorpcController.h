@@ -0,0 +1,182 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#ifndef ANT_PROTORPC_PROTORPC_CONTROLLER_H
+#define ANT_PROTORPC_PROTORPC_CONTROLLER_H
+
+#include "Macros.h"
+#include "Logging.h"
+
+// Define the protorpc bytes protocol.
+#include "ProtorpcMessage.pb.h"
+
+#include <string>
+#include <atomic>
+#include <functional>
+
+#include <google/protobuf/service.h>
+
+namespace annety
+{
+// Example:
+// // ProtorpcController
+// ProtorpcController controller;
+// controller.set_timeout(0.2);
+// stub.Solve(&controller, &req, res, NewCallback(...));
+// ...
+// controller.StartCancel();	// give up the call
+// ...
+// // in the done callback
+// if (controller.Failed()) {
+// 	LOG(ERROR) << controller.ErrorText();
+// }
+// ...
+
+// The RpcController of protorpc call, it carries the deadline of the call
+// and reports the failure (timeout, canceled, disconnected, or the error
+// code of the remote).
+//
+// The controller must outlive the call, until the done callback is called.
+class ProtorpcController : public ::google::protobuf::RpcController
+{
+public:
+	ProtorpcController() = default;
+
+	virtual ~ProtorpcController() override
+	{
+		notify_cancel();
+	}
+
+	// Client-side methods.
+
+	// Resets to the initial state (and no timeout), so it can be reused.
+	// *Not thread safe*, but usually be called before the call.
+	virtual void Reset() override;
+
+	// *Not thread safe*, but usually be called in the done callback.
+	virtual bool Failed() const override
+	{
+		return error_ != ProtorpcMessage::NO_ERROR;
+	}
+	virtual std::string ErrorText() const override
+	{
+		return reason_;
+	}
+
+	// Gives up the call, the done callback is called in the loop of channel
+	// with the CANCELED error, unless the call has been finished.
+	// The server is not notified, its response will be discarded.
+	// *Thread safe*, after the CallMethod() returned.
+	virtual void StartCancel() override;
+
+	// Server-side methods.
+
+	// *Not thread safe*
+	virtual void SetFailed(const std::string& reason) override
+	{
+		set_error(ProtorpcMessage::INVALID_RESPONSE, reason);
+	}
+
+	// *Thread safe*
+	virtual bool IsCanceled() const override
+	{
+		return canceled_.load(std::memory_order_acquire);
+	}
+
+	// The |callback| is called once, when the call is canceled, or when the
+	// controller is reset (destructed).
+	// *Not thread safe*
+	virtual void NotifyOnCancel(::google::protobuf::Closure* callback) override;
+
+	// The timeout of the call in seconds, 0 is the default of channel.
+	// *Not thread safe*, but usually be called before the call.
+	void set_timeout(double timeout_s)
+	{
+		CHECK(timeout_s >= 0);
+		timeout_s_ = timeout_s;
+	}
+	double timeout() const
+	{
+		return timeout_s_;
+	}
+
+	// *Not thread safe*, but usually be called in the done callback.
+	ProtorpcMessage::ERROR_CODE error_code() const
+	{
+		return error_;
+	}
+
+	// *Not thread safe*, but run in the loop of channel.
+	void set_error(ProtorpcMessage::ERROR_CODE error, const std::string& reason)
+	{
+		error_ = error;
+		reason_ = reason;
+	}
+
+	// Be registered by ProtorpcChannel::CallMethod(), it cancels the call.
+	// *Not thread safe*, but be called before the call is sent.
+	void set_cancel_callback(std::function<void()> cb)
+	{
+		cancel_cb_ = std::move(cb);
+	}
+
+private:
+	void notify_cancel();
+
+private:
+	double timeout_s_{0};
+	ProtorpcMessage::ERROR_CODE error_{ProtorpcMessage::NO_ERROR};
+	std::string reason_;
+
+	std::atomic<bool> canceled_{false};
+	std::function<void()> cancel_cb_;
+	::google::protobuf::Closure* notify_cb_{nullptr};
+
+	DISALLOW_COPY_AND_ASSIGN(ProtorpcController);
+};
+
+void ProtorpcController::Reset()
+{
+	notify_cancel();
+
+	timeout_s_ = 0;
+	error_ = ProtorpcMessage::NO_ERROR;
+	reason_.clear();
+	canceled_.store(false, std::memory_order_release);
+	cancel_cb_ = nullptr;
+}
+
+void ProtorpcController::StartCancel()
+{
+	if (canceled_.exchange(true, std::memory_order_acq_rel)) {
+		return;
+	}
+	if (cancel_cb_) {
+		cancel_cb_();
+	}
+	notify_cancel();
+}
+
+void ProtorpcController::NotifyOnCancel(::google::protobuf::Closure* callback)
+{
+	CHECK(callback && !notify_cb_);
+
+	if (IsCanceled()) {
+		callback->Run();
+	} else {
+		notify_cb_ = callback;
+	}
+}
+
+void ProtorpcController::notify_cancel()
+{
+	if (notify_cb_) {
+		::google::protobuf::Closure* cb = notify_cb_;
+		notify_cb_ = nullptr;
+		cb->Run();
+	}
+}
+
+}	// namespace annety
+
+#endif	// ANT_PROTORPC_PROTORPC_CONTROLLER_H
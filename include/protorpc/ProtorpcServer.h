@@ -7,21 +7,33 @@
 #include "TcpServer.h"
 #include "EventLoop.h"
 #include "Logging.h"
+#include "FormatMacros.h"
+#include "strings/StringPrintf.h"
+#include "threading/ThreadPool.h"
 #include "protorpc/ProtorpcChannel.h"
 
 #include <map>
 #include <string>
+#include <vector>
 #include <memory>
 
 namespace annety
 {
 // Server wrapper of protobuf rpc.
+//
+// Each connection owns a ProtorpcChannel (stored in the context of 
+// connection), which runs in the loop of connection.
+//
+// The methods are called in the loop of connection by default, a slow
+// service should be offloaded to a ThreadPool, the pool is bounded by
+// ThreadPool::set_max_task_size(), the connections stop reading when the
+// pool is full. The pools are owned by the caller, and must be started
+// before listen(), and be joined after the server is destructed.
 class ProtorpcServer
 {
 public:
 	ProtorpcServer(EventLoop* loop, const EndPoint& addr)
 		: loop_(loop)
-		, channel_(new ProtorpcChannel(loop))
 	{
 		CHECK(loop);
 
@@ -36,12 +48,17 @@ public:
 		server_->set_close_callback(
 			std::bind(&ProtorpcServer::remove_connection, this, _1));
 		server_->set_message_callback(
-			std::bind(&ProtorpcChannel::recv, channel_.get(), _1, _2, _3));
+			std::bind(&ProtorpcServer::recv, this, _1, _2, _3));
 	}
 
 	// Starts the server if it's not listenning.
 	void listen()
 	{
+		for (const ProtorpcServicePtr& service : services_) {
+			if (!service->pool) {
+				service->pool = pool_;
+			}
+		}
 		server_->listen();
 	}
 
@@ -52,45 +69,110 @@ public:
 		server_->set_thread_num(num_threads);
 	}
 
-	// Add service impl instance.
+	// Add service impl instance, its methods are called in the |pool| (or
+	// the pool of set_thread_pool()).
 	// *Not thread safe*, but usually be called before listen().
-	void add(::google::protobuf::Service* service)
+	void add(::google::protobuf::Service* service, ThreadPool* pool = nullptr)
 	{
-		channel_->add(service);
+		CHECK(service);
+		
+		services_.push_back(std::make_shared<ProtorpcService>(service, pool));
+	}
+
+	// The default pool of services, nullptr runs them in the loop.
+	// *Not thread safe*, but usually be called before listen().
+	void set_thread_pool(ThreadPool* pool)
+	{
+		pool_ = pool;
 	}
 
+	// The timing of methods, one line per called method:
+	// "service.method calls=N expired=N queue_avg=Nus queue_max=Nus 
+	// exec_avg=Nus exec_max=Nus"
+	// *Thread safe*
+	std::string stats_string() const;
+
 private:
+	// *Not thread safe*, but run in the loop of connection.
 	void new_connection(const TcpConnectionPtr&);
 	void remove_connection(const TcpConnectionPtr&);
+	void recv(const TcpConnectionPtr&, NetBuffer*, TimeStamp);
 
 private:
 	EventLoop* loop_;
 	TcpServerPtr server_;
-	ProtorpcChannelPtr channel_;
+
+	// The pool of services by default.
+	ThreadPool* pool_{nullptr};
+
+	// Protorpc service lists, be added into every channel.
+	std::vector<ProtorpcServicePtr> services_;
 
 	DISALLOW_COPY_AND_ASSIGN(ProtorpcServer);
 };
 
 void ProtorpcServer::new_connection(const TcpConnectionPtr& conn)
 {
-	loop_->check_in_own_loop();
+	conn->get_owner_loop()->check_in_own_loop();
 
 	DLOG(TRACE) << "ProtorpcServer - " << conn->local_addr().to_ip_port() << " <- "
 		<< conn->peer_addr().to_ip_port() << " s is "
 		<< "UP";
 	
-	channel_->attach_connection(conn);
+	ProtorpcChannelPtr channel(new ProtorpcChannel(conn->get_owner_loop()));
+	for (const ProtorpcServicePtr& service : services_) {
+		channel->add(service);
+	}
+	channel->attach_connection(conn);
+
+	conn->set_context(channel);
 }
 
 void ProtorpcServer::remove_connection(const TcpConnectionPtr& conn)
 {
-	loop_->check_in_own_loop();
+	conn->get_owner_loop()->check_in_own_loop();
 
 	DLOG(TRACE) << "ProtorpcServer - " << conn->local_addr().to_ip_port() << " <- "
 		<< conn->peer_addr().to_ip_port() << " s is "
 		<< "DOWN";
 
-	channel_->detach_connection();
+	ProtorpcChannelPtr& channel = containers::any_cast<ProtorpcChannelPtr>(conn->get_context());
+	channel->detach_connection();
+
+	conn->get_mutable_context()->reset();
+}
+
+void ProtorpcServer::recv(const TcpConnectionPtr& conn, NetBuffer* buff, TimeStamp receive)
+{
+	ProtorpcChannelPtr& channel = containers::any_cast<ProtorpcChannelPtr>(conn->get_context());
+	channel->recv(conn, buff, receive);
+}
+
+std::string ProtorpcServer::stats_string() const
+{
+	std::string result;
+	for (const ProtorpcServicePtr& service : services_) {
+		const google::protobuf::ServiceDescriptor* desc = service->impl->GetDescriptor();
+		for (int i = 0; i < desc->method_count(); ++i) {
+			const ProtorpcMethodStats& stats = service->stats[i];
+			int64_t calls = stats.calls.load(std::memory_order_relaxed);
+			int64_t expired = stats.expired.load(std::memory_order_relaxed);
+			if (calls == 0 && expired == 0) {
+				continue;
+			}
+			int64_t n = calls > 0? calls: 1;
+			sstring_appendf(&result, 
+				"%s calls=%" PRId64 " expired=%" PRId64 
+				" queue_avg=%" PRId64 "us queue_max=%" PRId64 "us"
+				" exec_avg=%" PRId64 "us exec_max=%" PRId64 "us\n",
+				desc->method(i)->full_name().c_str(), calls, expired,
+				stats.queue_us.load(std::memory_order_relaxed) / n,
+				stats.max_queue_us.load(std::memory_order_relaxed),
+				stats.exec_us.load(std::memory_order_relaxed) / n,
+				stats.max_exec_us.load(std::memory_order_relaxed));
+		}
+	}
+	return result;
 }
 
 }	// namespace annety
@@ -0,0 +1,81 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// By: wlmwang
+// Date: Oct 17 2026
+
+#ifndef ANT_STRINGS_STRING_NUMBER_CONVERSIONS_H_
+#define ANT_STRINGS_STRING_NUMBER_CONVERSIONS_H_
+
+#include <string>
+#include <type_traits>	// std::is_integral,std::is_signed
+#include <stddef.h>		// size_t
+#include <stdint.h>		// int64_t,uint64_t
+
+namespace annety
+{
+// Example:
+// // StringNumberConversions
+// char buff[kMaxDoubleFormatSize];
+// size_t len = format_double(buff, 0.1 + 0.2);
+// cout << std::string(buff, len) << endl;	// 0.30000000000000004
+//
+// cout << number_to_string(-12345) << endl;
+// ...
+
+// The max size of a formatted number, there is no NUL terminator.
+// "-9223372036854775808", "18446744073709551615"
+const size_t kMaxIntegerFormatSize = 20;
+// "FFFFFFFFFFFFFFFF"
+const size_t kMaxHexFormatSize = 16;
+// "-2.2250738585072014e-308"
+const size_t kMaxDoubleFormatSize = 24;
+// "-1.17549435e-38"
+const size_t kMaxFloatFormatSize = 15;
+
+// Formats |v| in decimal into |buff| (two digits at a time), returns the
+// number of bytes written.
+size_t format_int64(char* buff, int64_t v);
+size_t format_uint64(char* buff, uint64_t v);
+
+template <typename T>
+size_t format_integer(char* buff, T v)
+{
+	static_assert(std::is_integral<T>::value, "T must be an integral type");
+	return std::is_signed<T>::value? format_int64(buff, static_cast<int64_t>(v))
+								   : format_uint64(buff, static_cast<uint64_t>(v));
+}
+
+// Formats |v| in uppercase hex into |buff| (no "0x" prefix), returns the
+// number of bytes written.
+size_t format_hex(char* buff, uint64_t v);
+
+// Formats |v| into |buff| with the shortest digits that round trip (strtod()
+// gives |v| back), returns the number of bytes written. It is the notation
+// of printf("%.17g"): the exponent form is used when the decimal exponent
+// is less than -4 or not less than 17, and the trailing zeros are removed.
+// "nan", "inf" and "-inf" as printf.
+//
+// The digits are generated by Grisu3 (by Florian Loitsch), it rejects about
+// 0.5% of the doubles, they fall back to printf("%.*e").
+size_t format_double(char* buff, double v);
+
+// Formats |v| into |buff| with the shortest digits that round trip as a
+// float (strtof() gives |v| back), in the notation of printf("%.9g").
+// Like as format_double(), 0.1f is "0.1", not the "0.10000000149011612"
+// of the widened double.
+size_t format_float(char* buff, float v);
+
+// Number -> string conversions.
+std::string number_to_string(int value);
+std::string number_to_string(unsigned int value);
+std::string number_to_string(long value);
+std::string number_to_string(unsigned long value);
+std::string number_to_string(long long value);
+std::string number_to_string(unsigned long long value);
+std::string number_to_string(double value);
+
+}	// namespace annety
+
+#endif  // ANT_STRINGS_STRING_NUMBER_CONVERSIONS_H_
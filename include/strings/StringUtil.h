@@ -202,6 +202,15 @@ inline bool is_hex_digit(Char c)
 // by HTML5, and don't include control characters.
 extern const char kWhitespace[];
 
+// Find----------------------------------------------------
+
+// Finds the first |needle| in |str| at or after |pos|, returns npos if it is
+// not found. It is a memchr()-style search of the multi-bytes delimiter: the
+// first and the last bytes of |needle| are compared on 16 (SSE2) or 32 (AVX2,
+// selected by the cpu features) positions at once, only the candidates are
+// compared by memcmp().
+size_t find_substring(StringPiece str, StringPiece needle, size_t pos = 0);
+
 // Trim----------------------------------------------------
 
 enum TrimPositions
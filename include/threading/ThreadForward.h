@@ -15,6 +15,7 @@
 #include <mach/mach_types.h>
 #endif
 
+#include <functional>
 #include <unistd.h>
 #include <pthread.h>
 
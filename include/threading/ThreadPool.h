@@ -71,9 +71,17 @@ public:
 	// It is safe to run_task() any time, before or after start().
 	void run_task(const TaskCallback& cb, int repeat_count = 1);
 
+	// Never blocks, returns false if the queue is full (set_max_task_size),
+	// the |cb| is moved only if it has been queued (or run).
+	// It is used by the event loop thread, which must not be blocked.
+	bool try_run_task(TaskCallback&& cb);
+
 	// Taskers queue size
 	size_t get_task_size() const;
 
+	// Returns false after stop(), the queued tasks have been dropped.
+	bool running() const;
+
 	// Must be called before start().
 	void set_max_task_size(size_t max_task_size)
 	{
@@ -16,6 +16,12 @@
 
 namespace annety
 {
+namespace
+{
+// The delay of accepting again after a failure of resources.
+const double kRetryDelay = 0.01;
+}	// namespace anonymous
+
 namespace internal
 {
 // specific listen socket related function interfaces
@@ -82,6 +88,7 @@ Acceptor::Acceptor(EventLoop* loop, const EndPoint& addr, bool reuseport, bool n
 
 	internal::bind(*listen_socket_, addr);
 
+	listen_channel_->set_edge_triggered(owner_loop_->is_edge_triggered());
 	listen_channel_->set_read_callback(std::bind(&Acceptor::handle_read, this));
 }
 
@@ -90,8 +97,17 @@ Acceptor::~Acceptor()
 	DLOG(TRACE) << "Acceptor::~Acceptor" << " fd=" 
 		<< listen_socket_->internal_fd() << " is destructing";
 	
-	listen_channel_->disable_all_event();
-	listen_channel_->remove();
+	if (retrying_) {
+		owner_loop_->cancel(retry_timer_);
+	}
+	// The channel was added to the poller by listen().
+	if (listen_) {
+		listen_channel_->disable_all_event();
+		listen_channel_->remove();
+	}
+	if (idle_fd_ >= 0) {
+		::close(idle_fd_);
+	}
 }
 
 void Acceptor::listen()
@@ -108,6 +124,31 @@ void Acceptor::handle_read()
 {
 	owner_loop_->check_in_own_loop();
 
+	// In edge-triggered mode, keep accepting until EAGAIN, otherwise the 
+	// pending connections of backlog will not be notified again. In the
+	// level-triggered mode, the rest of backlog is notified by next polling.
+	bool edge_triggered = listen_channel_->is_edge_triggered();
+	int count = 0;
+	while ((edge_triggered || count < accept_batch_) && accept_one()) {
+		count++;
+	}
+
+	// Log the failures once per batch, not per connection, they flood the 
+	// log in the overload.
+	if (batch_failures_ > 0) {
+		errno = batch_errno_;
+		PLOG(ERROR) << "Acceptor::handle_read " << batch_failures_ 
+			<< " accept failures in the batch, the last was";
+		batch_failures_ = 0;
+	}
+
+	if (count > 0 && accept_batch_cb_) {
+		accept_batch_cb_();
+	}
+}
+
+bool Acceptor::accept_one()
+{
 	EndPoint peeraddr;	// client's EndPoint
 	int connfd = internal::accept(*listen_socket_, peeraddr);
 	if (connfd >= 0) {
@@ -118,23 +159,77 @@ void Acceptor::handle_read()
 		// of std::unique_ptr.
 		SelectableFDPtr sockfd(new SocketFD(connfd));
 		if (new_connect_cb_) {
+			accepted_.fetch_add(1, std::memory_order_relaxed);
 			new_connect_cb_(std::move(sockfd), peeraddr);
 		} else {
 			// `sockfd` is std::unique_ptr, so no need to delete or close(fd) here.
+			rejected_.fetch_add(1, std::memory_order_relaxed);
 		}
-	} else {
-		PLOG(ERROR) << "Acceptor::handle_read was failed";
-
-		// Read the section named "The special problem of accept()ing when you 
-		// can't" in libev's doc.
-		// By Marc Lehmann, author of libev.
-		if (errno == EMFILE) {
-			// the file descriptor is exhausted.
-			DPCHECK(::close(idle_fd_) == 0);
-			DPCHECK(::close(::accept(listen_socket_->internal_fd(), NULL, NULL)) == 0);
-			idle_fd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+		return true;
+	} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+		// The backlog has been drained.
+		return false;
+	} else if (errno == ECONNABORTED || errno == EINTR || errno == EPROTO) {
+		// The pending connection was aborted (or interrupted), the backlog 
+		// may have more.
+		return true;
+	} else if (errno == EMFILE || errno == ENFILE) {
+		batch_failures_++;
+		batch_errno_ = errno;
+
+		emfile_.fetch_add(1, std::memory_order_relaxed);
+		if (!reject_one()) {
+			retry_later();
+			return false;
 		}
+		return true;
+	} else {
+		batch_failures_++;
+		batch_errno_ = errno;
+
+		retry_later();
+		return false;
+	}
+}
+
+void Acceptor::retry_later()
+{
+	// The level-triggered mode is notified by next polling.
+	if (!listen_channel_->is_edge_triggered() || retrying_) {
+		return;
 	}
+	retrying_ = true;
+	retry_timer_ = owner_loop_->run_after(kRetryDelay, 
+		std::bind(&Acceptor::handle_retry, this));
+}
+
+void Acceptor::handle_retry()
+{
+	retrying_ = false;
+	handle_read();
+}
+
+bool Acceptor::reject_one()
+{
+	// Read the section named "The special problem of accept()ing when you 
+	// can't" in libev's doc.
+	// By Marc Lehmann, author of libev.
+	//
+	// Release the `idle_fd_`, accept and close the connection, then hold 
+	// the `idle_fd_` again. Every call of the batch rejects one connection.
+	if (idle_fd_ >= 0) {
+		::close(idle_fd_);
+		idle_fd_ = -1;
+	}
+	int connfd = ::accept(listen_socket_->internal_fd(), NULL, NULL);
+	if (connfd >= 0) {
+		::close(connfd);
+		rejected_.fetch_add(1, std::memory_order_relaxed);
+	}
+	idle_fd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+	PLOG_IF(ERROR, idle_fd_ < 0) << "Acceptor::reject_one reopen idle fd failed";
+
+	return connfd >= 0 && idle_fd_ >= 0;
 }
 
 }	// namespace annety
@@ -5,10 +5,13 @@
 #define ANT_ACCEPTOR_H_
 
 #include "Macros.h"
+#include "TimerId.h"
 #include "CallbackForward.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <stdint.h>
 
 namespace annety
 {
@@ -19,12 +22,19 @@ class Channel;
 
 // Wrapper listen socket which used to accept connect sockets.
 //
+// Every readable event accepts a batch of connections from the backlog, 
+// then the batch callback is called once, so that the new connections 
+// can be handed off to the workers together.
+//
 // This class owns the SelectableFD and Channel lifetime.
 // *Not thread safe*, but they are all called in the own loop.
 class Acceptor
 {
 public:
 	using NewConnectCallback = std::function<void(SelectableFDPtr, const EndPoint&)>;
+	using AcceptBatchCallback = std::function<void()>;
+
+	static const int kDefaultAcceptBatch = 64;
 
 	Acceptor(EventLoop* loop, const EndPoint& addr, bool reuseport, bool nodelay);
 	~Acceptor();
@@ -40,10 +50,57 @@ public:
 	{
 		new_connect_cb_ = cb;
 	}
+	// Called after a batch of connections has been accepted.
+	void set_accept_batch_callback(const AcceptBatchCallback& cb)
+	{
+		accept_batch_cb_ = cb;
+	}
+
+	// The max number of connections accepted per readable event in the 
+	// level-triggered mode. The edge-triggered mode always drains the 
+	// backlog until EAGAIN.
+	void set_accept_batch(int batch)
+	{
+		accept_batch_ = batch > 0? batch: 1;
+	}
+	int accept_batch() const
+	{
+		return accept_batch_;
+	}
+
+	// Connection-rate metrics.
+	// *Thread safe*
+	int64_t accepted_count() const
+	{
+		return accepted_.load(std::memory_order_relaxed);
+	}
+	// The connections were closed at once, no file descriptor for them.
+	int64_t rejected_count() const
+	{
+		return rejected_.load(std::memory_order_relaxed);
+	}
+	int64_t emfile_count() const
+	{
+		return emfile_.load(std::memory_order_relaxed);
+	}
 
 private:
 	void handle_read();
 
+	// Returns true when a connection has been accepted or rejected, and 
+	// the backlog may have more.
+	bool accept_one();
+
+	// The file descriptors are exhausted, reject a connection by the 
+	// `idle_fd_`. Returns true when a connection has been rejected.
+	bool reject_one();
+
+	// The accept() failed (ENOBUFS, ENOMEM...) before the backlog was drained.
+	// In the edge-triggered mode there is no new edge for the rest, accept
+	// again after kRetryDelay.
+	void retry_later();
+	void handle_retry();
+
 private:
 	EventLoop* owner_loop_{nullptr};
 	bool listen_{false};
@@ -54,6 +111,20 @@ private:
 	
 	// New connection callback.
 	NewConnectCallback new_connect_cb_;
+	AcceptBatchCallback accept_batch_cb_;
+
+	int accept_batch_{kDefaultAcceptBatch};
+
+	bool retrying_{false};
+	TimerId retry_timer_;
+
+	// The failures of accept() in the current batch, and the last errno.
+	int batch_failures_{0};
+	int batch_errno_{0};
+
+	std::atomic<int64_t> accepted_{0};
+	std::atomic<int64_t> rejected_{0};
+	std::atomic<int64_t> emfile_{0};
 
 	// A special file descriptor is used to solve the situation that the file 
 	// descriptors are exhausted when accept().
@@ -0,0 +1,183 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#include "AsyncLogging.h"
+#include "LogFile.h"
+#include "Logging.h"
+#include "threading/Thread.h"
+#include "strings/StringPrintf.h"
+
+#include <inttypes.h>	// PRId64
+#include <utility>
+
+namespace annety
+{
+AsyncLogging::AsyncLogging(const FilePath& path,
+						   off_t rotate_size_b,
+						   double flush_interval_s,
+						   size_t max_buffer_size)
+	: path_(path)
+	, rotate_size_b_(rotate_size_b)
+	, flush_interval_(TimeDelta::from_seconds_d(flush_interval_s))
+	, max_buffer_size_(max_buffer_size)
+	, lock_()
+	, cond_(lock_)
+	, current_(new Buffer(kBufferSize))
+	, next_(new Buffer(kBufferSize))
+{
+	CHECK_GT(max_buffer_size_, 0U);
+	buffers_.reserve(max_buffer_size_);
+}
+
+AsyncLogging::~AsyncLogging()
+{
+	if (running_) {
+		stop();
+	}
+}
+
+void AsyncLogging::start()
+{
+	CHECK(!running_) << "AsyncLogging::start is calling with running";
+
+	running_ = true;
+	thread_.reset(new Thread(std::bind(&AsyncLogging::thread_func, this),
+							 "AsyncLogging"));
+	thread_->start();
+}
+
+void AsyncLogging::stop()
+{
+	CHECK(running_) << "AsyncLogging::stop is calling with no running";
+	{
+		AutoLock locked(lock_);
+		running_ = false;
+		cond_.signal();
+	}
+	thread_->join();
+	thread_.reset();
+}
+
+void AsyncLogging::append(const StringPiece& message)
+{
+	append(message.data(), message.size());
+}
+
+void AsyncLogging::append(const char* message, int len)
+{
+	// A message longer than a buffer never fits, it is truncated (and
+	// counted as dropped).
+	const bool truncated = static_cast<size_t>(len) > kBufferSize;
+	if (truncated) {
+		len = static_cast<int>(kBufferSize);
+	}
+
+	AutoLock locked(lock_);
+	if (current_->append(message, len)) {
+		if (truncated) {
+			count_dropped();
+		}
+		return;
+	}
+
+	// The current buffer is full.
+	if (buffers_.size() >= max_buffer_size_) {
+		// The backend is falling behind, drop it.
+		count_dropped();
+		return;
+	}
+
+	buffers_.push_back(std::move(current_));
+	if (next_) {
+		current_ = std::move(next_);
+	} else {
+		// Rarely happens. The number of buffers is bounded by |max_buffer_size_|.
+		current_.reset(new Buffer(kBufferSize));
+	}
+	current_->append(message, len);
+	if (truncated) {
+		count_dropped();
+	}
+	cond_.signal();
+}
+
+void AsyncLogging::count_dropped()
+{
+	dropped_.fetch_add(1, std::memory_order_relaxed);
+	dropped_total_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncLogging::flush()
+{
+	AutoLock locked(lock_);
+	cond_.signal();
+}
+
+void AsyncLogging::thread_func()
+{
+	LogFile output(path_, rotate_size_b_);
+
+	BufferPtr spare1(new Buffer(kBufferSize));
+	BufferPtr spare2(new Buffer(kBufferSize));
+	BufferVector writing;
+	writing.reserve(max_buffer_size_);
+
+	bool running = true;
+	while (running) {
+		DCHECK(spare1 && spare1->readable_bytes() == 0);
+		DCHECK(writing.empty());
+		{
+			AutoLock locked(lock_);
+			if (buffers_.empty() && running_) {
+				// Write the current buffer every |flush_interval_|.
+				cond_.timed_wait(flush_interval_);
+			}
+			running = running_;
+
+			// Swap with the spare buffers, the front-end continues to append.
+			buffers_.push_back(std::move(current_));
+			current_ = std::move(spare1);
+			writing.swap(buffers_);
+			if (!next_) {
+				next_ = std::move(spare2);
+			}
+		}
+
+		int64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+		if (dropped > 0) {
+			TimeStamp::Exploded exploded;
+			TimeStamp::now().to_local_explode(&exploded);
+			std::string note = string_printf("%s AsyncLogging dropped %" PRId64
+				" messages, the disk is falling behind (or truncated)\n",
+				exploded.to_formatted_string().c_str(), dropped);
+			output.append(note);
+		}
+
+		for (const BufferPtr& buffer : writing) {
+			if (buffer->readable_bytes() > 0) {
+				output.append(buffer->begin_read(), buffer->readable_bytes());
+			}
+		}
+
+		// Reuse two of them as the spare buffers.
+		if (writing.size() > 2) {
+			writing.resize(2);
+		}
+		if (!spare1) {
+			DCHECK(!writing.empty());
+			spare1 = std::move(writing.back());
+			writing.pop_back();
+			spare1->reset();
+		}
+		if (!spare2) {
+			DCHECK(!writing.empty());
+			spare2 = std::move(writing.back());
+			writing.pop_back();
+			spare2->reset();
+		}
+		writing.clear();
+		output.flush();
+	}
+}
+
+}	// namespace annety
@@ -0,0 +1,652 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#include "BinaryLogging.h"
+#include "LogFile.h"
+#include "Logging.h"
+#include "threading/Thread.h"
+#include "threading/ThreadForward.h"
+#include "strings/StringPrintf.h"
+#include "strings/StringNumberConversions.h"
+
+#include <vector>
+#include <utility>
+#include <algorithm>	// std::min
+#include <inttypes.h>	// PRId64,PRIX64
+
+namespace annety
+{
+namespace
+{
+// The block: uint32_t magic | uint8_t type | uint32_t length | payload
+//
+// kBlockSite:    uint32_t id | int32_t severity | int32_t line |
+//                uint32_t length + file | uint32_t length + format
+// kBlockRecords: int64_t tid | records
+//
+// The integers are in the byte order of host.
+const uint32_t kBlockMagic = 0x42544e41;	// "ANTB"
+const size_t kBlockHeaderSize = 9;
+
+enum BlockType : uint8_t
+{
+	kBlockSite = 1,
+	kBlockRecords,
+};
+
+template <typename T>
+void append_raw(std::string* out, T v)
+{
+	out->append(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+void append_block_header(std::string* out, BlockType type, size_t length)
+{
+	append_raw<uint32_t>(out, kBlockMagic);
+	append_raw<uint8_t>(out, type);
+	append_raw<uint32_t>(out, static_cast<uint32_t>(length));
+}
+
+// Reads the raw values from a bounded range of bytes.
+class Reader
+{
+public:
+	Reader(const char* data, size_t len) : curr_(data), end_(data + len) {}
+
+	size_t remaining() const { return end_ - curr_;}
+
+	template <typename T>
+	bool read(T* v)
+	{
+		if (remaining() < sizeof(T)) {
+			return false;
+		}
+		::memcpy(v, curr_, sizeof(T));
+		curr_ += sizeof(T);
+		return true;
+	}
+
+	bool read(StringPiece* v)
+	{
+		uint32_t len = 0;
+		if (!read(&len) || remaining() < len) {
+			return false;
+		}
+		v->set(curr_, len);
+		curr_ += len;
+		return true;
+	}
+
+private:
+	const char* curr_;
+	const char* end_;
+};
+
+// The ring of the records of a thread, one producer (the thread) and one
+// consumer (the backend of BinaryLogging).
+class Ring
+{
+public:
+	explicit Ring(size_t size)
+		: buffer_(new char[size])
+		, size_(size)
+		, tid_(threads::tid()) {}
+
+	ThreadId tid() const { return tid_;}
+
+	// *Not thread safe*, but run in the producer thread.
+	bool push(const char* data, size_t len)
+	{
+		const uint64_t head = head_.load(std::memory_order_relaxed);
+		const uint64_t tail = tail_.load(std::memory_order_acquire);
+		if (size_ - (head - tail) < len) {
+			return false;
+		}
+
+		const size_t pos = head % size_;
+		const size_t first = std::min(len, size_ - pos);
+		::memcpy(buffer_.get() + pos, data, first);
+		::memcpy(buffer_.get(), data + first, len - first);
+
+		head_.store(head + len, std::memory_order_release);
+		return true;
+	}
+
+	// Moves all records into |out|, returns the number of bytes.
+	// *Not thread safe*, but run in the consumer thread.
+	size_t pop(std::string* out)
+	{
+		const uint64_t tail = tail_.load(std::memory_order_relaxed);
+		const uint64_t head = head_.load(std::memory_order_acquire);
+		const size_t len = static_cast<size_t>(head - tail);
+		if (len == 0) {
+			return 0;
+		}
+
+		const size_t pos = tail % size_;
+		const size_t first = std::min(len, size_ - pos);
+		out->append(buffer_.get() + pos, first);
+		out->append(buffer_.get(), len - first);
+
+		tail_.store(tail + len, std::memory_order_release);
+		return len;
+	}
+
+	// The thread has exited, the ring is released after it is drained.
+	std::atomic<bool> exited{false};
+
+private:
+	std::unique_ptr<char[]> buffer_;
+	const size_t size_;
+	const ThreadId tid_;
+
+	std::atomic<uint64_t> head_{0};
+	std::atomic<uint64_t> tail_{0};
+};
+
+using RingPtr = std::shared_ptr<Ring>;
+
+// The registered sites, the id is the index + 1.
+MutexLock g_sites_lock;
+std::vector<const BinaryLogSite*> g_sites;
+
+// The rings of the threads that have logged.
+MutexLock g_rings_lock;
+std::vector<RingPtr> g_rings;
+
+std::atomic<bool> g_running{false};
+std::atomic<size_t> g_ring_size{BinaryLogging::kDefaultRingSize};
+std::atomic<int64_t> g_dropped{0};
+
+// Marks the ring exited when the thread exits.
+struct RingHolder
+{
+	~RingHolder()
+	{
+		if (ring) {
+			ring->exited.store(true, std::memory_order_release);
+		}
+	}
+	RingPtr ring;
+};
+thread_local RingHolder tls_ring;
+
+Ring* get_ring()
+{
+	if (UNLIKELY(!tls_ring.ring)) {
+		tls_ring.ring = std::make_shared<Ring>(g_ring_size.load(std::memory_order_relaxed));
+
+		AutoLock locked(g_rings_lock);
+		g_rings.push_back(tls_ring.ring);
+	}
+	return tls_ring.ring.get();
+}
+
+// The number of the records of |records| (the bytes of Ring::pop()).
+int64_t count_records(const std::string& records)
+{
+	int64_t count = 0;
+	size_t offset = 0;
+	uint32_t size = 0;
+	while (offset + sizeof size <= records.size()) {
+		::memcpy(&size, records.data() + offset, sizeof size);
+		if (size == 0) {
+			break;
+		}
+		offset += size;
+		count++;
+	}
+	return count;
+}
+
+// Renders the arguments of a record into the "{}" of |format|.
+bool render_args(const char* format, Reader* args, std::string* text)
+{
+	const char* curr = format;
+	while (true) {
+		const char* holder = ::strstr(curr, "{}");
+		if (!holder && args->remaining() == 0) {
+			text->append(curr);
+			return true;
+		}
+		if (holder) {
+			text->append(curr, holder - curr);
+			curr = holder + 2;
+		} else {
+			// More arguments than the placeholders.
+			text->append(curr);
+			text->push_back(' ');
+			curr += ::strlen(curr);
+		}
+		if (args->remaining() == 0) {
+			// More placeholders than the arguments.
+			text->append("{}");
+			continue;
+		}
+
+		uint8_t tag = 0;
+		args->read(&tag);
+
+		bool ok = true;
+		switch (tag) {
+		case internal::kArgInt: {
+			int64_t v = 0;
+			if ((ok = args->read(&v))) {
+				char buff[kMaxIntegerFormatSize];
+				text->append(buff, format_int64(buff, v));
+			}
+			break;
+		}
+		case internal::kArgUInt: {
+			uint64_t v = 0;
+			if ((ok = args->read(&v))) {
+				char buff[kMaxIntegerFormatSize];
+				text->append(buff, format_uint64(buff, v));
+			}
+			break;
+		}
+		case internal::kArgDouble: {
+			double v = 0;
+			if ((ok = args->read(&v))) {
+				// The same digits as LogStream.
+				char buff[kMaxDoubleFormatSize];
+				text->append(buff, format_double(buff, v));
+			}
+			break;
+		}
+		case internal::kArgFloat: {
+			float v = 0;
+			if ((ok = args->read(&v))) {
+				char buff[kMaxFloatFormatSize];
+				text->append(buff, format_float(buff, v));
+			}
+			break;
+		}
+		case internal::kArgBool: {
+			uint8_t v = 0;
+			if ((ok = args->read(&v))) {
+				text->push_back(v? '1': '0');
+			}
+			break;
+		}
+		case internal::kArgChar: {
+			char v = 0;
+			if ((ok = args->read(&v))) {
+				text->push_back(v);
+			}
+			break;
+		}
+		case internal::kArgString: {
+			StringPiece v;
+			if ((ok = args->read(&v))) {
+				text->append(v.data(), v.size());
+			}
+			break;
+		}
+		case internal::kArgPointer: {
+			uint64_t v = 0;
+			if ((ok = args->read(&v))) {
+				sstring_appendf(text, "0x%" PRIX64, v);
+			}
+			break;
+		}
+		case internal::kArgTimeStamp: {
+			int64_t v = 0;
+			if ((ok = args->read(&v))) {
+				TimeStamp::Exploded exploded;
+				(TimeStamp() + TimeDelta::from_microseconds(v)).to_utc_explode(&exploded);
+				text->append(exploded.to_formatted_string());
+			}
+			break;
+		}
+		default:
+			ok = false;
+			break;
+		}
+		if (!ok) {
+			return false;
+		}
+	}
+}
+
+}	// namespace anonymous
+
+// BinaryLogSite
+BinaryLogSite::BinaryLogSite(const char* format, const LogMessage::Filename& file,
+							 int line, LogSeverity severity)
+	: format_(format)
+	, file_(file)
+	, line_(line)
+	, severity_(severity)
+{
+	CHECK(format_);
+
+	AutoLock locked(g_sites_lock);
+	g_sites.push_back(this);
+	id_ = static_cast<uint32_t>(g_sites.size());
+}
+
+// BinaryLogEncoder
+void internal::BinaryLogEncoder::put(const StringPiece& v)
+{
+	if (curr_ + 1 + sizeof(uint32_t) > end_) {
+		return;
+	}
+	const size_t len = std::min(v.size(), static_cast<size_t>(end_ - curr_) - 1 - sizeof(uint32_t));
+	const uint32_t len32 = static_cast<uint32_t>(len);
+
+	*curr_++ = static_cast<char>(kArgString);
+	::memcpy(curr_, &len32, sizeof len32);
+	curr_ += sizeof len32;
+	::memcpy(curr_, v.data(), len);
+	curr_ += len;
+}
+
+void internal::binary_log_record(const BinaryLogSite& site, char* record, size_t args_size)
+{
+	const uint32_t size = static_cast<uint32_t>(kBinaryLogHeaderSize + args_size);
+	const uint32_t id = site.id();
+	const TimeStamp now = get_log_coarse_time()? TimeStamp::now_coarse(): TimeStamp::now();
+	const int64_t micros = (now - TimeStamp()).in_microseconds();
+	::memcpy(record, &size, sizeof size);
+	::memcpy(record + 4, &id, sizeof id);
+	::memcpy(record + 8, &micros, sizeof micros);
+
+	if (site.severity() == LOG_FATAL || !g_running.load(std::memory_order_acquire)) {
+		// Rendered as a LOG() of the site.
+		std::string text;
+		Reader args(record + kBinaryLogHeaderSize, args_size);
+		render_args(site.format(), &args, &text);
+		LogMessage(site.line(), LogMessage::Filename(site.file().data()),
+			site.severity()).stream() << text;
+		return;
+	}
+
+	if (!get_ring()->push(record, size)) {
+		g_dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+// BinaryLogging
+BinaryLogging::BinaryLogging(const FilePath& path,
+							 off_t rotate_size_b,
+							 double poll_interval_s,
+							 double flush_interval_s,
+							 size_t ring_size_b)
+	: path_(path)
+	, rotate_size_b_(rotate_size_b)
+	, poll_interval_(TimeDelta::from_seconds_d(poll_interval_s))
+	, flush_interval_(TimeDelta::from_seconds_d(flush_interval_s))
+	, ring_size_b_(ring_size_b)
+	, lock_()
+	, cond_(lock_)
+{
+	CHECK(ring_size_b_ >= internal::kBinaryLogMaxRecordSize);
+}
+
+BinaryLogging::~BinaryLogging()
+{
+	if (running_) {
+		stop();
+	}
+}
+
+void BinaryLogging::start()
+{
+	CHECK(!running_) << "BinaryLogging::start is calling with running";
+
+	bool expected = false;
+	CHECK(g_running.compare_exchange_strong(expected, true))
+		<< "BinaryLogging::start another one is running";
+
+	g_ring_size.store(ring_size_b_, std::memory_order_relaxed);
+	running_ = true;
+	thread_.reset(new Thread(std::bind(&BinaryLogging::thread_func, this),
+							 "BinaryLogging"));
+	thread_->start();
+}
+
+void BinaryLogging::stop()
+{
+	CHECK(running_) << "BinaryLogging::stop is calling with no running";
+
+	// The following records are logged by LOG().
+	g_running.store(false, std::memory_order_release);
+	{
+		AutoLock locked(lock_);
+		running_ = false;
+		cond_.signal();
+	}
+	thread_->join();
+	thread_.reset();
+
+	// The records were pushed by the threads that had seen g_running before 
+	// it was cleared, but after the last collect(). Count them as dropped.
+	std::string records;
+	AutoLock locked(g_rings_lock);
+	for (auto it = g_rings.begin(); it != g_rings.end(); ) {
+		// Loads it before the last pop().
+		bool exited = (*it)->exited.load(std::memory_order_acquire);
+
+		records.clear();
+		(*it)->pop(&records);
+		g_dropped.fetch_add(count_records(records), std::memory_order_relaxed);
+
+		if (exited) {
+			it = g_rings.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+int64_t BinaryLogging::dropped_count()
+{
+	return g_dropped.load(std::memory_order_relaxed);
+}
+
+void BinaryLogging::collect(std::string* blocks)
+{
+	std::string records;
+	{
+		AutoLock locked(g_rings_lock);
+		for (auto it = g_rings.begin(); it != g_rings.end(); ) {
+			Ring* ring = it->get();
+			// Loads it before the last pop().
+			bool exited = ring->exited.load(std::memory_order_acquire);
+
+			size_t offset = records.size();
+			append_block_header(&records, kBlockRecords, 0);
+			append_raw<int64_t>(&records, ring->tid());
+			size_t len = ring->pop(&records);
+			if (len > 0) {
+				// Fill the length of the block.
+				uint32_t length = static_cast<uint32_t>(sizeof(int64_t) + len);
+				::memcpy(&records[offset + 5], &length, sizeof length);
+			} else {
+				records.resize(offset);
+			}
+
+			if (exited) {
+				it = g_rings.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	// The sites of the records have been registered.
+	{
+		AutoLock locked(g_sites_lock);
+		for (; written_sites_ < g_sites.size(); written_sites_++) {
+			const BinaryLogSite* site = g_sites[written_sites_];
+			const StringPiece file = site->file();
+			const StringPiece format(site->format());
+
+			append_block_header(blocks, kBlockSite,
+				4 * sizeof(uint32_t) + sizeof(int32_t) + file.size() + format.size());
+			append_raw<uint32_t>(blocks, site->id());
+			append_raw<int32_t>(blocks, site->severity());
+			append_raw<int32_t>(blocks, site->line());
+			append_raw<uint32_t>(blocks, static_cast<uint32_t>(file.size()));
+			blocks->append(file.data(), file.size());
+			append_raw<uint32_t>(blocks, static_cast<uint32_t>(format.size()));
+			blocks->append(format.data(), format.size());
+		}
+	}
+	blocks->append(records);
+}
+
+void BinaryLogging::thread_func()
+{
+	LogFile output(path_, rotate_size_b_);
+	BinaryLogDecoder decoder;
+
+	std::string blocks;
+	std::string text;
+	TimeStamp last_flush = TimeStamp::now();
+
+	bool running = true;
+	while (running) {
+		{
+			AutoLock locked(lock_);
+			if (running_) {
+				cond_.timed_wait(poll_interval_);
+			}
+			running = running_;
+		}
+
+		blocks.clear();
+		collect(&blocks);
+		if (!blocks.empty()) {
+			if (text_output_) {
+				text.clear();
+				ssize_t n = decoder.decode(blocks.data(), blocks.size(), &text);
+				DCHECK(n == static_cast<ssize_t>(blocks.size()));
+				ALLOW_UNUSED_LOCAL(n);
+				output.append(text);
+			} else {
+				output.append(blocks);
+			}
+		}
+
+		TimeStamp curr = TimeStamp::now();
+		if (!running || curr - last_flush >= flush_interval_) {
+			output.flush();
+			last_flush = curr;
+		}
+	}
+}
+
+// BinaryLogDecoder
+ssize_t BinaryLogDecoder::decode(const char* data, size_t len, std::string* text)
+{
+	size_t decoded = 0;
+	while (len - decoded >= kBlockHeaderSize) {
+		Reader header(data + decoded, kBlockHeaderSize);
+		uint32_t magic = 0, length = 0;
+		uint8_t type = 0;
+		header.read(&magic);
+		header.read(&type);
+		header.read(&length);
+		if (magic != kBlockMagic) {
+			return -1;
+		}
+		if (len - decoded - kBlockHeaderSize < length) {
+			break;
+		}
+
+		const char* payload = data + decoded + kBlockHeaderSize;
+		bool ok = false;
+		if (type == kBlockSite) {
+			ok = decode_site(payload, length);
+		} else if (type == kBlockRecords) {
+			ok = decode_records(payload, length, text);
+		}
+		if (!ok) {
+			return -1;
+		}
+		decoded += kBlockHeaderSize + length;
+	}
+	return static_cast<ssize_t>(decoded);
+}
+
+bool BinaryLogDecoder::decode_site(const char* data, size_t len)
+{
+	Reader reader(data, len);
+
+	uint32_t id = 0;
+	int32_t severity = 0, line = 0;
+	StringPiece file, format;
+	if (!reader.read(&id) || !reader.read(&severity) || !reader.read(&line) ||
+		!reader.read(&file) || !reader.read(&format))
+	{
+		return false;
+	}
+
+	Site& site = sites_[id];
+	site.severity = severity;
+	site.line = line;
+	site.file = file.as_string();
+	site.format = format.as_string();
+	return true;
+}
+
+bool BinaryLogDecoder::decode_records(const char* data, size_t len, std::string* text)
+{
+	Reader reader(data, len);
+
+	int64_t tid = 0;
+	if (!reader.read(&tid)) {
+		return false;
+	}
+
+	while (reader.remaining() > 0) {
+		uint32_t size = 0, id = 0;
+		int64_t micros = 0;
+		if (!reader.read(&size) || !reader.read(&id) || !reader.read(&micros) ||
+			size < internal::kBinaryLogHeaderSize ||
+			reader.remaining() < size - internal::kBinaryLogHeaderSize)
+		{
+			return false;
+		}
+		const size_t args_size = size - internal::kBinaryLogHeaderSize;
+		const char* args_data = data + (len - reader.remaining());
+
+		// The time exploded string is formatted once per second, as LOG().
+		const int64_t second = micros / TimeStamp::kMicrosecondsPerSecond;
+		if (second != last_second_) {
+			TimeStamp::Exploded exploded;
+			(TimeStamp() + TimeDelta::from_microseconds(micros)).to_local_explode(&exploded);
+			format_ymdhis_ = string_printf("%04d-%02d-%02d %02d:%02d:%02d",
+				exploded.year, exploded.month, exploded.day_of_month,
+				exploded.hour, exploded.minute, exploded.second);
+			last_second_ = second;
+		}
+
+		auto it = sites_.find(id);
+		const Site* site = it != sites_.end()? &it->second: nullptr;
+
+		const StringPiece severity = log_severity_name(site? site->severity: -1);
+		sstring_appendf(text, "%s.%06d %" PRId64 " %.*s ", format_ymdhis_.c_str(),
+			static_cast<int>(micros % TimeStamp::kMicrosecondsPerSecond), tid,
+			static_cast<int>(severity.size()), severity.data());
+
+		// The site is defined in the previous files.
+		Reader args(args_data, args_size);
+		if (!render_args(site? site->format.c_str(): "<unknown site>", &args, text)) {
+			return false;
+		}
+		if (site) {
+			sstring_appendf(text, " - %s:%d\n", site->file.c_str(), site->line);
+		} else {
+			sstring_appendf(text, " - <site %u>\n", id);
+		}
+
+		Reader rest(args_data + args_size, reader.remaining() - args_size);
+		reader = rest;
+	}
+	return true;
+}
+
+}	// namespace annety
@@ -0,0 +1,103 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#include "BufferChain.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace annety
+{
+void BufferChain::append(const void* data, size_t len)
+{
+	if (len == 0) {
+		return;
+	}
+
+	// Coalesce into the owned tail segment. The fixed length NetBuffer may
+	// be full, then push a new segment.
+	if (segments_.empty() || segments_.back().holder ||
+		!segments_.back().buffer->append(data, len))
+	{
+		size_t init_size = NetBuffer::kInitialSize;
+
+		Segment seg;
+		seg.buffer.reset(new NetBuffer(NetBuffer::kUnLimitSize, std::max(len, init_size)));
+		seg.buffer->append(data, len);
+		segments_.push_back(std::move(seg));
+	}
+	readable_bytes_ += len;
+}
+
+void BufferChain::append(NetBuffer&& buffer)
+{
+	size_t len = buffer.readable_bytes();
+	if (len == 0) {
+		return;
+	}
+
+	Segment seg;
+	seg.buffer.reset(new NetBuffer(std::move(buffer)));
+	segments_.push_back(std::move(seg));
+	readable_bytes_ += len;
+}
+
+void BufferChain::append(std::shared_ptr<const void> holder, const StringPiece& data)
+{
+	CHECK(holder);
+
+	if (data.empty()) {
+		return;
+	}
+
+	Segment seg;
+	seg.holder = std::move(holder);
+	seg.piece = data;
+	segments_.push_back(std::move(seg));
+	readable_bytes_ += data.size();
+}
+
+int BufferChain::peek_iovec(struct iovec* iov, int iovcnt) const
+{
+	DCHECK(iov);
+
+	int cnt = 0;
+	for (auto it = segments_.begin(); it != segments_.end() && cnt < iovcnt; ++it) {
+		iov[cnt].iov_base = const_cast<char*>(it->data());
+		iov[cnt].iov_len = it->size();
+		cnt++;
+	}
+	return cnt;
+}
+
+void BufferChain::has_read(size_t len)
+{
+	DCHECK_LE(len, readable_bytes_);
+
+	readable_bytes_ -= len;
+	while (len > 0) {
+		DCHECK(!segments_.empty());
+
+		Segment& seg = segments_.front();
+		size_t n = std::min(len, seg.size());
+		if (n < seg.size()) {
+			if (seg.holder) {
+				seg.piece.remove_prefix(n);
+			} else {
+				seg.buffer->has_read(n);
+			}
+		} else {
+			segments_.pop_front();
+		}
+		len -= n;
+	}
+}
+
+void BufferChain::has_read_all()
+{
+	readable_bytes_ = 0;
+	segments_.clear();
+}
+
+}	// namespace annety
@@ -0,0 +1,83 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#ifndef ANT_BUFFER_CHAIN_H_
+#define ANT_BUFFER_CHAIN_H_
+
+#include "Macros.h"
+#include "NetBuffer.h"
+#include "strings/StringPiece.h"
+
+#include <deque>
+#include <memory>
+#include <stddef.h>
+#include <sys/uio.h>	// struct iovec
+
+namespace annety
+{
+// A chain of buffer segments, it is the output queue of TcpConnection.
+//
+// A segment is one of:
+// 1. owned NetBuffer. The small bytes appended by copying are coalesced
+//    into the owned tail segment.
+// 2. shared immutable bytes (string slice or encoded blob). |holder| keeps
+//    the bytes alive, so the same bytes can be queued by many connections.
+//
+// The chain is flushed by writev(2) with the iovecs of peek_iovec().
+// *Not thread safe*, but run in the own loop of connection.
+class BufferChain
+{
+public:
+	BufferChain() = default;
+
+	size_t readable_bytes() const { return readable_bytes_;}
+	size_t segment_size() const { return segments_.size();}
+	bool empty() const { return readable_bytes_ == 0;}
+
+	// Copy |data| into the owned tail segment.
+	void append(const void* data, size_t len);
+
+	// Take the storage of |buffer|.
+	void append(NetBuffer&& buffer);
+
+	// Share the immutable |data|, the |holder| keeps it alive.
+	void append(std::shared_ptr<const void> holder, const StringPiece& data);
+
+	// Fill at most |iovcnt| iovecs from the front segments.
+	// Returns the number of iovecs has been filled.
+	int peek_iovec(struct iovec* iov, int iovcnt) const;
+
+	// Remove |len| bytes from the front segments.
+	void has_read(size_t len);
+	void has_read_all();
+
+private:
+	struct Segment
+	{
+		// Owned bytes, it is used when |holder| is null. It is allocated
+		// lazily, the shared segments do not pay for it.
+		std::unique_ptr<NetBuffer> buffer;
+
+		// Shared bytes.
+		std::shared_ptr<const void> holder;
+		StringPiece piece;
+
+		const char* data() const
+		{
+			return holder? piece.data(): buffer->begin_read();
+		}
+		size_t size() const
+		{
+			return holder? piece.size(): buffer->readable_bytes();
+		}
+	};
+
+	size_t readable_bytes_{0};
+	std::deque<Segment> segments_;
+
+	DISALLOW_COPY_AND_ASSIGN(BufferChain);
+};
+
+}	// namespace annety
+
+#endif	// ANT_BUFFER_CHAIN_H_
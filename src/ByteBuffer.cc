@@ -22,6 +22,14 @@ void ByteBuffer::make_writable_bytes(size_t len)
 	}
 
 	if (real_writeable_bytes < len) {
+		// Combine the read and writable bytes first, the readable bytes are
+		// only moved when the tail is not enough, so the prependable bytes
+		// are kept as long as possible.
+		if (reader_index_ > 0 && reader_index_ + real_writeable_bytes >= len) {
+			migration_buffer_data();
+			return;
+		}
+
 		// fixed length ByteBuffer
 		if (max_size_ != kUnLimitSize && max_size_ - writer_index_ < len) {
 			// std::cerr << "not enough space to write"
@@ -31,13 +39,31 @@ void ByteBuffer::make_writable_bytes(size_t len)
 			return;
 		}
 
-		// FIXME: should try to combine the read and writable bytes first
 		buffer_.resize(writer_index_+len);
-	} else if (begin_read() != data()) {
-		migration_buffer_data();
 	}
 }
 
+bool ByteBuffer::prepend(const char* data, size_t len)
+{
+	if (reader_index_ < len) {
+		// Move the readable bytes back.
+		const size_t gap = len - reader_index_;
+		if (max_size_ != kUnLimitSize && 
+			static_cast<size_t>(max_size_) < writer_index_ + gap)
+		{
+			return false;
+		}
+		buffer_.insert(buffer_.begin() + reader_index_, gap, 0);
+		reader_index_ += gap;
+		writer_index_ += gap;
+	}
+
+	reader_index_ -= len;
+	scanned_bytes_ = 0;
+	std::copy(data, data + len, begin_read());
+	return true;
+}
+
 void ByteBuffer::migration_buffer_data()
 {
 	if (begin_read() != data()) {
@@ -6,6 +6,7 @@
 
 #include "Macros.h"
 #include "TimeStamp.h"
+#include "containers/InlineFunction.h"
 
 #include <string>
 #include <memory>
@@ -27,8 +28,8 @@ class SelectableFD;
 class Channel
 {
 public:
-	using EventCallback = std::function<void()>;
-	using ReadEventCallback = std::function<void(TimeStamp)>;
+	using EventCallback = containers::InlineFunction<void()>;
+	using ReadEventCallback = containers::InlineFunction<void(TimeStamp)>;
 
 	void set_read_callback(ReadEventCallback cb)
 	{
@@ -55,6 +56,11 @@ public:
 	int revents() const { return revents_;}
 	int events() const { return events_;}
 
+	// Registers the IO events with edge-triggered mode, only the epoll(4) 
+	// poller supports it. Must be set before the first update().
+	void set_edge_triggered(bool on) { edge_triggered_ = on;}
+	bool is_edge_triggered() const { return edge_triggered_;}
+
 	bool is_none_event() const { return events_ == kNoneEvent;}
 	bool is_write_event() const { return events_ & kWriteEvent;}
 	bool is_read_event() const { return events_ & kReadEvent;}
@@ -116,6 +122,7 @@ private:
 	int	events_{0};
 	int revents_{0};
 
+	bool edge_triggered_{false};
 	bool added_to_loop_{false};
 	bool handling_event_{false};
 	bool logging_hup_{true};
@@ -167,10 +167,14 @@ void EPollPoller::update_poll_events(int operation, Channel* channel)
 	::memset(&event, 0, sizeof event);
 	event.events = channel->events();
 	event.data.ptr = channel;
+	if (channel->is_edge_triggered()) {
+		event.events |= EPOLLET;
+	}
 
 	DLOG(TRACE) << "EPollPoller::update_poll_events epoll_ctl op = " 
 		<< operation_to_string(operation) << " fd = " << channel->fd() 
-		<< " event = { " << channel->events_to_string() << " }";
+		<< " event = { " << channel->events_to_string() << " }"
+		<< " et = " << channel->is_edge_triggered();
 	
 	if (::epoll_ctl(epollfd_, operation, channel->fd(), &event) < 0) {
 		if (operation == kPollCtlDel) {
@@ -8,9 +8,13 @@
 #include "PollPoller.h"
 #include "EPollPoller.h"
 #include "TimerPool.h"
+#include "TreeTimerPool.h"
+#include "WheelTimerPool.h"
 #include "PlatformThread.h"
 
 #include <signal.h>		// signal
+#include <stdlib.h>		// getenv
+#include <string.h>		// strcmp
 
 namespace annety
 {
@@ -37,18 +41,82 @@ BEFORE_MAIN_EXECUTOR() { ::signal(SIGPIPE, SIG_IGN);}
 
 namespace {
 thread_local EventLoop* tls_event_loop = nullptr;
+
+EventLoop::PollerType get_poller_type(EventLoop::PollerType type)
+{
+	if (type != EventLoop::kPollerDefault) {
+#if !defined(OS_LINUX)
+		// epoll(4) is only available on Linux.
+		type = EventLoop::kPollerPoll;
+#endif	// !defined(OS_LINUX)
+		return type;
+	}
+
+	const char* env = ::getenv("ANNETY_POLLER");
+	if (env && ::strcmp(env, "poll") == 0) {
+		return EventLoop::kPollerPoll;
+	}
+#if defined(OS_LINUX)
+	if (env && ::strcmp(env, "epoll-et") == 0) {
+		return EventLoop::kPollerEPollET;
+	}
+	return EventLoop::kPollerEPoll;
+#else
+	return EventLoop::kPollerPoll;
+#endif	// defined(OS_LINUX)
+}
+
+Poller* new_poller(EventLoop* loop, EventLoop::PollerType type)
+{
+	switch (type) {
+#if defined(OS_LINUX)
+	case EventLoop::kPollerEPoll:
+	case EventLoop::kPollerEPollET:
+		return new EPollPoller(loop);
+#endif	// defined(OS_LINUX)
+	default:
+		return new PollPoller(loop);
+	}
+}
+
+EventLoop::TimerType get_timer_type(EventLoop::TimerType type)
+{
+	if (type != EventLoop::kTimerDefault) {
+		return type;
+	}
+
+	const char* env = ::getenv("ANNETY_TIMER");
+	if (env && ::strcmp(env, "wheel") == 0) {
+		return EventLoop::kTimerWheel;
+	}
+	return EventLoop::kTimerTree;
+}
+
+TimerPool* new_timer_pool(EventLoop* loop, EventLoop::TimerType type)
+{
+	switch (type) {
+	case EventLoop::kTimerWheel:
+		return new WheelTimerPool(loop);
+	default:
+		return new TreeTimerPool(loop);
+	}
+}
 }	// namespace anonymous
 
-EventLoop::EventLoop() 
+EventLoop::EventLoop(PollerType type, TimerType timer_type)
 	: owning_thread_id_(new ThreadId(PlatformThread::current_id()))
 	, owning_thread_ref_(new ThreadRef(PlatformThread::current_ref()))
-	, poller_(new PollPoller(this))
-	, timers_(new TimerPool(this))
+	, poller_type_(get_poller_type(type))
+	, poller_(new_poller(this, poller_type_))
+	, timer_type_(get_timer_type(timer_type))
+	, timers_(new_timer_pool(this, timer_type_))
 	, wakeup_socket_(new EventFD(true, true))
 	, wakeup_channel_(new Channel(this, wakeup_socket_.get()))
 {
 	LOG(DEBUG) << "EventLoop::EventLoop is creating by thread " 
 		<< owning_thread_id_.get() 
+		<< ", poller type is " << poller_type_
+		<< ", timer type is " << timer_type_
 		<< ", EventLoop address is " << this;
 
 	{
@@ -100,6 +168,7 @@ void EventLoop::loop()
 
 		active_channels_.clear();
 		poll_active_ms_ = poller_->poll(poll_timeout_ms_, &active_channels_);
+		poll_active_monotonic_ = TimeStamp::now_monotonic();
 		
 		if (LOG_IS_ON(TRACE)) {
 			print_active_channels();
@@ -117,7 +186,7 @@ void EventLoop::loop()
 #if !defined(OS_LINUX)
 		// On non-Linux platforms, Use the traditional poller timeout to implement 
 		// the timers, here you need to manually check the timeout timers.
-		timers_->check_timer(TimeStamp::now());
+		timers_->check_timer(TimeStamp::now_monotonic());
 #endif	// !defined(OS_LINUX)
 
 		// wakeup and run queue functions.
@@ -133,7 +202,15 @@ TimerId EventLoop::run_at(double time_s, TimerCallback cb)
 }
 TimerId EventLoop::run_at(TimeStamp time, TimerCallback cb)
 {
-	return timers_->add_timer(std::move(cb), time, 0.0);
+	// Converts to the monotonic time of timers, by the cached clocks of
+	// the loop if it is possible.
+	TimeStamp expired;
+	if (is_in_own_loop() && looping_) {
+		expired = time + (poll_active_monotonic_ - poll_active_ms_);
+	} else {
+		expired = time + (TimeStamp::now_monotonic() - TimeStamp::now());
+	}
+	return timers_->add_timer(std::move(cb), expired, 0.0);
 }
 
 TimerId EventLoop::run_after(double delay_s, TimerCallback cb)
@@ -142,7 +219,7 @@ TimerId EventLoop::run_after(double delay_s, TimerCallback cb)
 }
 TimerId EventLoop::run_after(TimeDelta delta, TimerCallback cb)
 {
-	return run_at(TimeStamp::now()+delta, std::move(cb));
+	return timers_->add_timer(std::move(cb), loop_monotonic_time()+delta, 0.0);
 }
 
 TimerId EventLoop::run_every(double interval_s, TimerCallback cb)
@@ -151,7 +228,15 @@ TimerId EventLoop::run_every(double interval_s, TimerCallback cb)
 }
 TimerId EventLoop::run_every(TimeDelta delta, TimerCallback cb)
 {
-	return timers_->add_timer(std::move(cb), TimeStamp::now()+delta, delta.in_seconds_f());
+	return timers_->add_timer(std::move(cb), loop_monotonic_time()+delta, delta.in_seconds_f());
+}
+
+TimeStamp EventLoop::loop_monotonic_time() const
+{
+	if (is_in_own_loop() && looping_) {
+		return poll_active_monotonic_;
+	}
+	return TimeStamp::now_monotonic();
 }
 
 void EventLoop::cancel(TimerId timerId)
@@ -199,17 +284,29 @@ void EventLoop::run_in_own_loop(Functor cb)
 
 void EventLoop::queue_in_own_loop(Functor cb)
 {
-	{
-		AutoLock locked(lock_);
-		wakeup_functors_.push_back(std::move(cb));
-	}
+	wakeup_functors_.push(std::move(cb));
 
 	// wakeup the own loop thread:
 	// 1. current thread is not the own loop thread.
 	// 2. the poller has returned (Executing wakeup function).
+	//
+	// Only the first producer writes `wakeup_socket_` until the loop 
+	// consumes the queue. The exchange must be after push().
 	if (!is_in_own_loop() || calling_wakeup_functors_.load(std::memory_order_relaxed)) {
-		wakeup();
+		if (!wakeup_pending_.exchange(true, std::memory_order_acq_rel)) {
+			wakeup();
+		}
+	}
+}
+
+char* EventLoop::spill_buffer()
+{
+	check_in_own_loop();
+
+	if (!spill_buffer_) {
+		spill_buffer_.reset(new char[kSpillBufferSize]);
 	}
+	return spill_buffer_.get();
 }
 
 void EventLoop::check_in_own_loop() const
@@ -225,20 +322,27 @@ bool EventLoop::is_in_own_loop() const
 	return *owning_thread_ref_ == PlatformThread::current_ref();
 }
 
+// static
+EventLoop* EventLoop::get_current_loop()
+{
+	return tls_event_loop;
+}
+
 void EventLoop::do_calling_wakeup_functors()
 {
 	check_in_own_loop();
 
 	calling_wakeup_functors_.store(true, std::memory_order_relaxed);
-	
-	std::vector<Functor> functors;
-	{
-		AutoLock locked(lock_);
-		functors.swap(wakeup_functors_);
-	}
-	for (const Functor& func : functors) {
+
+	// Clear the pending flag before consuming, the producers after this 
+	// will wakeup the loop again. Acquire the nodes linked before their 
+	// exchange.
+	wakeup_pending_.exchange(false, std::memory_order_acq_rel);
+
+	// The functors queued by functors are left to the next looping.
+	wakeup_functors_.consume([](containers::InlineFunction<void(), 96>& func) {
 		func();
-	}
+	});
 
 	calling_wakeup_functors_.store(false, std::memory_order_relaxed);
 }
@@ -6,10 +6,26 @@
 #include "Logging.h"
 #include "files/File.h"
 #include "files/FilePath.h"
+#include "files/FileUtil.h"
+#include "files/FileEnumerator.h"
 #include "strings/StringPrintf.h"
+#include "strings/StringUtil.h"
+#include "threading/ThreadPool.h"
 
+#include <algorithm>	// std::sort
+#include <set>
+#include <utility>		// std::move
+#include <vector>
+#include <errno.h>
+#include <signal.h>	// kill
+#include <stdio.h>	// fprintf
+#include <stdlib.h>	// atoi
 #include <unistd.h> // pid_t,getpid
 
+#if defined(ANT_HAS_ZLIB)
+#include <zlib.h>	// gzopen,gzwrite,gzclose
+#endif
+
 namespace annety
 {
 namespace {
@@ -26,17 +42,20 @@ std::string hostname()
 	}
 }
 
-// path.Ymd-HMS.hostname.pid.log
-FilePath get_log_filename(const FilePath& path)
+// path.Ymd-HMS.hostname.pid.log, or path.Ymd-HMS-index.hostname.pid.log if
+// it is rotated again in the same second.
+FilePath get_log_filename(const FilePath& path, const TimeStamp& curr, int index)
 {
+	// The hostname of the process.
+	static const std::string host = hostname();
+
 	// path
 	std::string filename = path.value();
 
 	// %Y%m%d-%H%M%S
 	TimeStamp::Exploded exploded;
-	TimeStamp curr = TimeStamp::now();
 	curr.to_local_explode(&exploded);
-	sstring_appendf(&filename, 
+	sstring_appendf(&filename,
 		".%04d%02d%02d-%02d%02d%02d.",
 		exploded.year,
 		exploded.month,
@@ -45,13 +64,161 @@ FilePath get_log_filename(const FilePath& path)
 		exploded.minute,
 		exploded.second
 	);
+	if (index > 0) {
+		filename.back() = '-';
+		sstring_appendf(&filename, "%d.", index);
+	}
 
 	// hostname().getpid().log
-	sstring_appendf(&filename, "%s.%d.%s", hostname().c_str(), ::getpid(), "log");
+	sstring_appendf(&filename, "%s.%d.%s", host.c_str(), ::getpid(), "log");
 
 	return FilePath(filename);
 }
 
+// path.next.hostname.pid
+FilePath get_next_filename(const FilePath& path)
+{
+	std::string filename = path.value();
+	sstring_appendf(&filename, ".next.%s.%d", hostname().c_str(), ::getpid());
+	return FilePath(filename);
+}
+
+// Returns true if the basename |name| is a next file "prefix.next.hostname.pid"
+// of a dead process of this host. It is left by the crashed process, the
+// pid of next process is different, so nobody else removes it.
+bool is_stale_next_filename(const std::string& name, const std::string& prefix)
+{
+	static const std::string host = hostname();
+
+	const std::string next = prefix + ".next." + host + ".";
+	if (name.size() <= next.size() || name.compare(0, next.size(), next) != 0) {
+		return false;
+	}
+	for (size_t i = next.size(); i < name.size(); i++) {
+		if (!is_ascii_digit(name[i]) || i - next.size() >= 9) {
+			return false;
+		}
+	}
+	const pid_t pid = static_cast<pid_t>(::atoi(name.c_str() + next.size()));
+	return pid > 0 && pid != ::getpid() && ::kill(pid, 0) < 0 && errno == ESRCH;
+}
+
+// The parsed name of a log file.
+struct LogName
+{
+	// "hostname.pid" of the process that wrote it.
+	std::string owner;
+	// Ymd-HMS, and the index of the rotation in the second.
+	int64_t stamp{0};
+	int64_t index{0};
+	bool compressed{false};
+};
+
+// Returns true if the basename |name| is a log file of |prefix| that is
+// "prefix.Ymd-HMS[-index].hostname.pid.log[.gz]", and parses it into |log|.
+// The next file "prefix.next.*" is not.
+bool parse_log_filename(const std::string& name, const std::string& prefix,
+						LogName* log)
+{
+	if (name.compare(0, prefix.size(), prefix) != 0) {
+		return false;
+	}
+	size_t pos = prefix.size();
+
+	// Consumes |n| digits (or one at least if |n| is 0) into |value|.
+	auto digits = [&name, &pos](size_t n, int64_t* value) {
+		size_t start = pos;
+		while (pos < name.size() && is_ascii_digit(name[pos]) &&
+			   (n == 0 || pos - start < n) && pos - start < 18) {
+			*value = *value * 10 + (name[pos] - '0');
+			pos++;
+		}
+		return n == 0? pos > start: pos - start == n;
+	};
+	auto expect = [&name, &pos](char c) {
+		if (pos < name.size() && name[pos] == c) {
+			pos++;
+			return true;
+		}
+		return false;
+	};
+
+	// .Ymd-HMS[-index].
+	log->stamp = 0;
+	log->index = 0;
+	if (!expect('.') || !digits(8, &log->stamp) || !expect('-') ||
+		!digits(6, &log->stamp))
+	{
+		return false;
+	}
+	if (expect('-') && !digits(0, &log->index)) {
+		return false;
+	}
+	if (!expect('.')) {
+		return false;
+	}
+
+	// hostname.pid.log[.gz]
+	std::string rest = name.substr(pos);
+	log->compressed = ends_with(rest, ".gz", CompareCase::SENSITIVE);
+	if (log->compressed) {
+		rest.resize(rest.size() - 3);
+	}
+	if (!ends_with(rest, ".log", CompareCase::SENSITIVE)) {
+		return false;
+	}
+	rest.resize(rest.size() - 4);
+
+	size_t dot = rest.rfind('.');
+	if (dot == std::string::npos || dot == 0 || dot + 1 == rest.size()) {
+		return false;
+	}
+	for (size_t i = dot + 1; i < rest.size(); i++) {
+		if (!is_ascii_digit(rest[i])) {
+			return false;
+		}
+	}
+	log->owner = std::move(rest);
+	return true;
+}
+
+#if defined(ANT_HAS_ZLIB)
+// Compresses |from| into the gzip |to|.
+bool gzip_file(const FilePath& from, const FilePath& to)
+{
+	File src(from, File::FLAG_OPEN | File::FLAG_READ);
+	if (!src.is_valid()) {
+		return false;
+	}
+	gzFile gz = ::gzopen(to.value().c_str(), "wb");
+	if (!gz) {
+		return false;
+	}
+
+	bool ok = true;
+	char buf[64*1024];
+	for (;;) {
+		int n = src.read_at_current_pos(buf, sizeof buf);
+		if (n <= 0) {
+			ok = n == 0;
+			break;
+		}
+		if (::gzwrite(gz, buf, static_cast<unsigned>(n)) != n) {
+			ok = false;
+			break;
+		}
+	}
+	if (::gzclose(gz) != Z_OK) {
+		ok = false;
+	}
+
+	if (!ok) {
+		delete_file(to, false);
+	}
+	return ok;
+}
+#endif	// defined(ANT_HAS_ZLIB)
+
 }	// namespace anonymous
 
 LogFile::LogFile(const FilePath& path,
@@ -60,12 +227,38 @@ LogFile::LogFile(const FilePath& path,
 	: path_(path)
 	, rotate_size_b_(rotate_size_b)
 	, check_every_n_(check_every_n)
+	, next_path_(get_next_filename(path))
 {
 	DCHECK(!path_.ends_with_separator());
+
 	rotate(true);
 }
 
-LogFile::~LogFile() = default;
+LogFile::~LogFile()
+{
+	if (!helper_) {
+		return;
+	}
+
+	// Finish the rotated files.
+	helper_->joinall();
+
+	// The pre-opened file is not used.
+	AutoLock locked(lock_);
+	if (next_file_) {
+		next_file_.reset();
+		delete_file(next_path_, false);
+	}
+}
+
+void LogFile::set_compress(bool on)
+{
+#if defined(ANT_HAS_ZLIB)
+	compress_ = on;
+#else
+	LOG_IF(WARNING, on) << "LogFile::set_compress is ignored, built without zlib";
+#endif
+}
 
 void LogFile::append(const StringPiece& message)
 {
@@ -94,36 +287,216 @@ void LogFile::append_unlocked(const char* message, int len)
 			rotate();
 		}
 	}
-	DCHECK(file_->write_at_current_pos(message, len) == len);
+
+	// Do not write inside DCHECK, it is not evaluated in release mode.
+	int n = file_->write_at_current_pos(message, len);
+	DCHECK(n == len);
 }
 
 void LogFile::rotate(bool force)
 {
-	auto do_rotate_with_locked = [this](const TimeStamp& curr) {
-		lock_.assert_acquired();
-		flush();
+	TimeStamp curr = TimeStamp::now();
+	if (!force) {
+		// One new day, or the rotate interval.
+		if (curr.utc_midnight() <= last_rotate_ &&
+			(rotate_interval_.is_null() || curr - last_rotate_ < rotate_interval_))
+		{
+			flush();
+			return;
+		}
+	}
+
+	// Rotated again in the same second.
+	const int64_t second = curr.to_time_t();
+	rotate_index_ = second == rotate_second_? rotate_index_ + 1: 0;
+	rotate_second_ = second;
 
-		File* file = new File(get_log_filename(path_), File::FLAG_OPEN_ALWAYS |
-													   File::FLAG_APPEND);
-		
+	FilePath filename = get_log_filename(path_, curr, rotate_index_);
+
+	std::unique_ptr<File> next;
+	{
+		AutoLock locked(lock_);
+		next = std::move(next_file_);
+		if (next) {
+			next_taken_ = true;
+		}
+	}
+
+	std::shared_ptr<File> rotated(std::move(file_));
+	FilePath rotated_filename = filename_;
+
+	const bool swapped = !!next;
+	if (swapped) {
+		// Swaps in the pre-opened file, it is renamed by the helper.
+		file_ = std::move(next);
+		written_.store(0);
+	} else {
+		// The first file, or the helper is behind.
+		File* file = new File(filename, File::FLAG_OPEN_ALWAYS |
+										File::FLAG_APPEND);
 		DCHECK(file->error_details() == File::FILE_OK);
 		written_.store(file->get_length());
 
 		file_.reset(file);
-		last_rotate_ = curr;
-	};
+	}
+	filename_ = filename;
+	last_rotate_ = curr;
 
-	TimeStamp curr = TimeStamp::now();
-	if (force) {
+	// The first file has nothing to finish. The helper (and the next file)
+	// is started at the first rotation, a LogFile that is never rotated has
+	// no thread nor file of it.
+	if (!rotated) {
+		return;
+	}
+	if (!helper_) {
+		helper_.reset(new ThreadPool(1, "logfile"));
+		helper_->start();
+	}
+	helper_->run_task(std::bind(&LogFile::finish_rotated_file, this,
+		rotated, rotated_filename, filename, swapped));
+}
+
+void LogFile::prepare_next_file()
+{
+	{
 		AutoLock locked(lock_);
-		do_rotate_with_locked(curr);
-	} else {
-		// one new day.
+		// It is not renamed yet, the next file is opened after that.
+		if (next_file_ || next_taken_) {
+			return;
+		}
+	}
+
+	File* file = new File(next_path_, File::FLAG_CREATE_ALWAYS |
+									  File::FLAG_WRITE);
+	if (!file->is_valid()) {
+		::fprintf(stderr, "LogFile::prepare_next_file open %s failed\n",
+				  next_path_.value().c_str());
+		delete file;
+		return;
+	}
+
+	AutoLock locked(lock_);
+	next_file_.reset(file);
+}
+
+void LogFile::finish_rotated_file(std::shared_ptr<File> file, const FilePath& rotated,
+								  const FilePath& filename, bool swapped)
+{
+	// The errors of the helper are written to stderr, not LOG(), this file
+	// may be the sink of the logging, and append() is not thread safe.
+
+	// The swapped in file gets its name, before the next one is opened.
+	if (swapped) {
+		if (!move_file(next_path_, filename)) {
+			::fprintf(stderr, "LogFile::finish_rotated_file rename %s to %s failed\n",
+					  next_path_.value().c_str(), filename.value().c_str());
+		}
 		AutoLock locked(lock_);
-		if (curr.utc_midnight() > last_rotate_) {
-			do_rotate_with_locked(curr);
-		} else {
-			flush();
+		next_taken_ = false;
+	}
+
+	if (file) {
+		file->flush();
+		file->close();
+		file.reset();
+
+#if defined(ANT_HAS_ZLIB)
+		if (compress_) {
+			FilePath gz = rotated.add_extension("gz");
+			if (gzip_file(rotated, gz)) {
+				delete_file(rotated, false);
+			} else {
+				::fprintf(stderr, "LogFile::finish_rotated_file compress %s failed\n",
+						  rotated.value().c_str());
+			}
+		}
+#endif	// defined(ANT_HAS_ZLIB)
+	}
+
+	remove_stale_next_files();
+	remove_expired_files(filename);
+
+	prepare_next_file();
+}
+
+void LogFile::remove_stale_next_files()
+{
+	const std::string prefix = path_.basename().value();
+	FileEnumerator enums(path_.dirname(), false, FileEnumerator::FILES, prefix + ".next.*");
+	for (FilePath path = enums.next(); !path.empty(); path = enums.next()) {
+		if (is_stale_next_filename(path.basename().value(), prefix)) {
+			delete_file(path, false);
+		}
+	}
+}
+
+void LogFile::remove_expired_files(const FilePath& current)
+{
+	if (max_files_ <= 0 && max_total_size_b_ <= 0) {
+		return;
+	}
+
+	// The log files of the basename (rotated, compressed, and the ones of
+	// the other processes), the newest first. They are ordered by the time
+	// of rotation in the name: the mtime of a compressed file is the time
+	// it was compressed, and the rotations are usually in the same second.
+	struct LogInfo
+	{
+		FilePath path;
+		LogName name;
+		int64_t size;
+	};
+	std::vector<LogInfo> logs;
+
+	const std::string prefix = path_.basename().value();
+	FileEnumerator enums(path_.dirname(), false, FileEnumerator::FILES, prefix + ".*");
+	for (FilePath path = enums.next(); !path.empty(); path = enums.next()) {
+		LogName name;
+		if (!parse_log_filename(path.basename().value(), prefix, &name)) {
+			continue;
+		}
+		FileEnumerator::FileInfo info = enums.get_info();
+		logs.push_back({path, std::move(name), info.get_size()});
+	}
+	std::sort(logs.begin(), logs.end(), [](const LogInfo& lhs, const LogInfo& rhs) {
+		if (lhs.name.stamp != rhs.name.stamp) {
+			return lhs.name.stamp > rhs.name.stamp;
+		}
+		if (lhs.name.index != rhs.name.index) {
+			return lhs.name.index > rhs.name.index;
+		}
+		return lhs.path.value() > rhs.path.value();
+	});
+
+	// Our files newer than |current| are rotated after it, they are not
+	// finished by the helper yet (it is behind). The newest uncompressed
+	// file of the other processes is their current file. They are never
+	// removed, nor is |current|.
+	LogName self;
+	parse_log_filename(current.basename().value(), prefix, &self);
+
+	bool ahead = true;
+	std::set<std::string> owners;
+	int files = 0;
+	int64_t total_size = 0;
+	for (const LogInfo& log : logs) {
+		files++;
+		total_size += log.size;
+		if (log.name.owner == self.owner) {
+			if (log.path.basename() == current.basename()) {
+				ahead = false;
+				continue;
+			}
+			if (ahead) {
+				continue;
+			}
+		} else if (!log.name.compressed && owners.insert(log.name.owner).second) {
+			continue;
+		}
+		if ((max_files_ > 0 && files > max_files_) ||
+			(max_total_size_b_ > 0 && total_size > max_total_size_b_))
+		{
+			delete_file(log.path, false);
 		}
 	}
 }
@@ -3,100 +3,70 @@
 
 #include "LogStream.h"
 #include "TimeStamp.h"
+#include "strings/StringNumberConversions.h"
 
-#include <algorithm>
 #include <ostream>
 #include <sstream>
 #include <stddef.h>
 #include <string.h>
-#include <stdio.h>	// snprintf
 
 namespace annety
 {
-namespace
-{
-const char kDigitMaps[] = "9876543210123456789";
-const char kDigitHexMaps[] = "0123456789ABCDEF";
-
-// Efficient Integer to String Conversions, by Matthew Wilson.
-template<typename T>
-size_t convert(char buf[], T value)
-{
-	T i = value;
-	char* p = buf;
-
-	const char* digits = kDigitMaps + 9;
-	do {
-		int lsd = static_cast<int>(i % 10);
-		i /= 10;
-		*p++ = digits[lsd];
-	} while (i != 0);
-
-	if (value < 0) {
-		*p++ = '-';
-	}
-
-	*p = '\0';
-	std::reverse(buf, p);
-	return p - buf;
-}
-
-template<>
-size_t convert<uintptr_t>(char buf[], uintptr_t value)
-{
-	uintptr_t i = value;
-	char* p = buf;
-
-	const char* digitsHex = kDigitHexMaps;
-	do {
-		int lsd = static_cast<int>(i % 16);
-		i /= 16;
-		*p++ = digitsHex[lsd];
-	} while (i != 0);
-
-	*p = '\0';
-	std::reverse(buf, p);
-	return p - buf;
-}
-
-}  // namespace anonymous
-
 template<typename T>
 LogStream& LogStream::format_number(T v)
 {
-	char buf[kMaxNumericSize+1];
-	size_t len = convert(buf, v);
-	buffer_.append(buf, len);
+	// Formats into the buffer directly, unless it is nearly full.
+	buffer_.ensure_writable_bytes(kMaxNumericSize);
+	if (buffer_.writable_bytes() >= kMaxNumericSize) {
+		buffer_.has_written(format_integer(buffer_.begin_write(), v));
+	} else {
+		char buf[kMaxNumericSize];
+		buffer_.append(buf, format_integer(buf, v));
+	}
 	return *this;
 }
 
+// The shortest digits that round trip.
 template <>
-LogStream& LogStream::format_number<uintptr_t>(uintptr_t v)
+LogStream& LogStream::format_number<double>(double v)
 {
-	char buf[kMaxNumericSize+3] {'0', 'x'};
-	size_t len = convert(buf+2, v);
-	buffer_.append(buf, len+2);
+	buffer_.ensure_writable_bytes(kMaxNumericSize);
+	if (buffer_.writable_bytes() >= kMaxNumericSize) {
+		buffer_.has_written(format_double(buffer_.begin_write(), v));
+	} else {
+		char buf[kMaxNumericSize];
+		buffer_.append(buf, format_double(buf, v));
+	}
 	return *this;
 }
 
-// todo. replace this with Grisu3 by Florian Loitsch.
+// The shortest digits that round trip as a float (not as the widened double).
 template <>
-LogStream& LogStream::format_number<double>(double v)
-{
-	char buf[kMaxNumericSize+1];
-	size_t len = ::snprintf(buf, kMaxNumericSize+1, "%.12g", v);
-	buffer_.append(buf, len);
+LogStream& LogStream::format_number<float>(float v)
+{
+	buffer_.ensure_writable_bytes(kMaxNumericSize);
+	if (buffer_.writable_bytes() >= kMaxNumericSize) {
+		buffer_.has_written(format_float(buffer_.begin_write(), v));
+	} else {
+		char buf[kMaxNumericSize];
+		buffer_.append(buf, format_float(buf, v));
+	}
 	return *this;
 }
 
+// Not a specialization of format_number<uintptr_t>(), which is the same
+// type as unsigned long (size_t), they are formatted in decimal.
 LogStream& LogStream::operator<<(const void* p)
 {
-	return format_number(reinterpret_cast<uintptr_t>(p));
+	char buf[kMaxNumericSize] {'0', 'x'};
+	size_t len = format_hex(buf+2, reinterpret_cast<uintptr_t>(p));
+	buffer_.append(buf, len+2);
+	return *this;
 }
 
 LogStream& LogStream::operator<<(float v)
 {
-	return *this << static_cast<double>(v);
+	return format_number(v);
 }
 
 LogStream& LogStream::operator<<(short v)
@@ -23,16 +23,17 @@
 namespace annety
 {
 namespace {
-const char* const kLogSeverityNames[] = {"TRACE", "DEBUG", "INFO", "WARNING", "ERROR", "FATAL"};
+// The severity names with a trailing space, for the prefix of record.
+const StringPiece kLogSeverityNames[] = {"TRACE ", "DEBUG ", "INFO ", "WARNING ", "ERROR ", "FATAL "};
 static_assert(LOG_NUM_SEVERITIES == arraysize(kLogSeverityNames),
 			"Incorrect number of kLogSeverityNames");
 
-const char* log_severity_name(int severity)
+StringPiece log_severity_prefix(int severity)
 {
 	if (severity >= 0 && severity < LOG_NUM_SEVERITIES) {
 		return kLogSeverityNames[severity];
 	}
-	return "UNKNOWN";
+	return "UNKNOWN ";
 }
 
 void defaultOutput(const char* msg, int len)
@@ -56,9 +57,67 @@ LogFFlushHandlerFunction g_log_fflush_handler = &defaultFlush;
 // 0=TRACE 1=INFO 2=WARNING 3=ERROR 4=FATAL
 LogSeverity g_min_log_severity = 0;
 
+// The records are timed by TimeStamp::now_coarse().
+bool g_log_coarse_time = false;
+
 // logging cache colums
 thread_local int64_t tls_last_second{0};
 thread_local char tls_format_ymdhis[32]{'\0'};
+thread_local int tls_format_ymdhis_len{0};
+thread_local char tls_format_tid[32]{'\0'};
+thread_local int tls_format_tid_len{0};
+
+// The reused buffer of the records of thread. A record takes it away, and
+// gives it back after the output. A nested record (logging in the stream of
+// another record) gets an own buffer.
+thread_local ByteBuffer* tls_log_buffer{nullptr};
+thread_local bool tls_log_buffer_taken{false};
+thread_local bool tls_log_buffer_exited{false};
+
+// Deletes the buffer when the thread exits, the later records (such as the
+// destructors of the other thread_local objects) get the own buffers.
+struct LogBufferDeleter
+{
+	~LogBufferDeleter()
+	{
+		delete tls_log_buffer;
+		tls_log_buffer = nullptr;
+		tls_log_buffer_exited = true;
+	}
+};
+thread_local LogBufferDeleter tls_log_buffer_deleter;
+
+ByteBuffer acquire_log_buffer()
+{
+	if (UNLIKELY(tls_log_buffer_taken || tls_log_buffer_exited)) {
+		return ByteBuffer(LogStream::kMaxBufferSize);
+	}
+	if (UNLIKELY(!tls_log_buffer)) {
+		// Registers the deleter of thread.
+		ALLOW_UNUSED_LOCAL(&tls_log_buffer_deleter);
+		tls_log_buffer = new ByteBuffer(LogStream::kMaxBufferSize);
+	}
+	tls_log_buffer_taken = true;
+	return std::move(*tls_log_buffer);
+}
+
+void release_log_buffer(ByteBuffer&& buffer)
+{
+	if (tls_log_buffer_taken && tls_log_buffer) {
+		*tls_log_buffer = std::move(buffer);
+		tls_log_buffer_taken = false;
+	}
+}
+
+// Writes the |width| decimal digits of |value| with the leading zeros.
+void format_fixed_digits(char* buf, int width, int value)
+{
+	for (int i = width - 1; i >= 0; --i) {
+		buf[i] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	}
+}
+
 }	// namespace anonymous
 
 void set_min_log_severity(LogSeverity severity)
@@ -69,6 +128,20 @@ LogSeverity get_min_log_severity()
 {
 	return g_min_log_severity;
 }
+void set_log_coarse_time(bool on)
+{
+	g_log_coarse_time = on;
+}
+bool get_log_coarse_time()
+{
+	return g_log_coarse_time;
+}
+StringPiece log_severity_name(int severity)
+{
+	StringPiece prefix = log_severity_prefix(severity);
+	return StringPiece(prefix.data(), prefix.size() - 1);
+}
+
 bool should_logging_message(LogSeverity severity)
 {
 	return severity >= g_min_log_severity;
@@ -88,7 +161,7 @@ LogFFlushHandlerFunction set_log_fflush_handler(LogFFlushHandlerFunction handler
 }
 
 LogMessage::Impl::Impl(int line, const Filename& file, LogSeverity sev, int err)
-	: line_(line), file_(file), severity_(sev), errno_(err)
+	: stream_(acquire_log_buffer()), line_(line), file_(file), severity_(sev), errno_(err)
 {
 	begin();
 	
@@ -100,7 +173,7 @@ LogMessage::Impl::Impl(int line, const Filename& file, LogSeverity sev, int err)
 
 LogMessage::Impl::Impl(int line, const Filename& file, LogSeverity sev, 
 						const std::string& msg, int err) 
-	: line_(line), file_(file), severity_(sev), errno_(err)
+	: stream_(acquire_log_buffer()), line_(line), file_(file), severity_(sev), errno_(err)
 {
 	begin();
 	stream_ << "Check failed: " << msg << ".";
@@ -111,16 +184,21 @@ LogMessage::Impl::Impl(int line, const Filename& file, LogSeverity sev,
 	}
 }
 
+LogMessage::Impl::~Impl()
+{
+	release_log_buffer(stream_.take_buffer());
+}
+
 void LogMessage::Impl::begin()
 {
-	// time exploded string
+	// time exploded string, it is formatted once per second.
 	TimeDelta td = time_ - TimeStamp();
 	if (td.in_seconds() != tls_last_second) {
 		TimeStamp::Exploded local_exploded;
 		time_.to_local_explode(&local_exploded);
 
-		sstring_printf(tls_format_ymdhis, sizeof tls_format_ymdhis, 
-					"%04d-%02d-%02d %02d:%02d:%02d",
+		tls_format_ymdhis_len = sstring_printf(tls_format_ymdhis, sizeof tls_format_ymdhis, 
+					"%04d-%02d-%02d %02d:%02d:%02d.",
 					local_exploded.year,
 					local_exploded.month,
 					local_exploded.day_of_month,
@@ -131,14 +209,25 @@ void LogMessage::Impl::begin()
 
 		tls_last_second = td.in_seconds();
 	}
-	stream_ << string_printf("%s.%06d ", tls_format_ymdhis, 
-				static_cast<int>(td.internal_value() % TimeStamp::kMicrosecondsPerSecond));
+	stream_.append(tls_format_ymdhis, tls_format_ymdhis_len);
+
+	char micros[8];
+	format_fixed_digits(micros, 6, 
+		static_cast<int>(td.internal_value() % TimeStamp::kMicrosecondsPerSecond));
+	micros[6] = ' ';
+	stream_.append(micros, 7);
 	
 	// tid string
-	stream_ << threads::tid_string() << " ";
+	if (UNLIKELY(tls_format_tid_len == 0)) {
+		StringPiece tid = threads::tid_string();
+		tls_format_tid_len = sstring_printf(tls_format_tid, sizeof tls_format_tid, 
+					"%.*s ", static_cast<int>(tid.size()), tid.data());
+	}
+	stream_.append(tls_format_tid, tls_format_tid_len);
 
 	// severity string
-	stream_ << log_severity_name(severity_) << " ";
+	StringPiece severity = log_severity_prefix(severity_);
+	stream_.append(severity.data(), severity.size());
 }
 
 void LogMessage::Impl::endl()
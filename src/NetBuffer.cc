@@ -4,24 +4,29 @@
 #include "NetBuffer.h"
 #include "SocketsUtil.h"
 
+#include <memory>
 #include <errno.h>
 
 namespace annety
 {
-ssize_t NetBuffer::read_fd(int fd, int* err)
+namespace
+{
+const size_t kSpillSize = 65536;
+
+}	// namespace anonymous
+
+ssize_t NetBuffer::read_fd(int fd, int* err, char* spill, size_t spill_len)
 {
 	const size_t writable = writable_bytes();
 
-	char extrabuf[65536];
 	struct iovec vec[2];
 	vec[0].iov_base = begin_write();
 	vec[0].iov_len = writable;
-	vec[1].iov_base = extrabuf;
-	vec[1].iov_len = sizeof extrabuf;
+	vec[1].iov_base = spill;
+	vec[1].iov_len = spill_len;
 
-	// when there is enough space in this buffer, don't read into extrabuf.
-	// when extrabuf is used, we read 128k-1 bytes at most.
-	const int iovcnt = (writable < sizeof extrabuf) ? 2 : 1;
+	// when there is enough space in this buffer, don't read into spill.
+	const int iovcnt = (writable < spill_len) ? 2 : 1;
 
 	// Use vec[0] first, and then vec[1]
 	const ssize_t n = sockets::readv(fd, vec, iovcnt);
@@ -33,15 +38,19 @@ ssize_t NetBuffer::read_fd(int fd, int* err)
 		has_written(n);
 	} else {
 		has_written(writable);
-		append(extrabuf, n - writable);
+		append(spill, n - writable);
 	}
-
-	// FIXME: readv again.
-	// if (n == writable + sizeof extrabuf) {
-	// 	goto line_12;
-	// }
-	
 	return n;
 }
 
+ssize_t NetBuffer::read_fd(int fd, int* err)
+{
+	// Instead of the 64k bytes stack of every call.
+	thread_local static std::unique_ptr<char[]> tls_spill;
+	if (!tls_spill) {
+		tls_spill.reset(new char[kSpillSize]);
+	}
+	return read_fd(fd, err, tls_spill.get(), kSpillSize);
+}
+
 }	// namespace annety
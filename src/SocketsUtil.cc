@@ -157,18 +157,21 @@ int accept(int servfd, struct sockaddr_in6* dst, bool nonblock, bool cloexec)
 								// 		- the client terminates the connection. SVR4 implementation.
 			case ECONNABORTED:	// 103:	Software caused connection abort
 								//		- the client terminates the connection. POSIX implementation.
-				// expected errors.
+			case ENFILE:		// 23:	File table overflow.
+								//		- system limit of open files, like as EMFILE.
+			case ENOMEM:		// 12:	Out of memory.
+			case ENOBUFS:		// 105:	No buffer space available.
+								//		- the socket buffers are limited, transient.
+				// expected errors, they are reported by the caller (which 
+				// knows whether they are worth a log line).
 				errno = err;
 				break;
 
-			case ENOMEM:		// 12:	Out of memory.
 			case EFAULT:		// 14:	Bad address.
 			case EINVAL:		// 22:	Invalid argument.
-			case ENFILE:		// 23:	File table overflow.
 			case EBADF:			// 77:	File descriptor in bad state.
 			case ENOTSOCK:		// 88:	Socket operation on non-socket.
 			case EOPNOTSUPP:	// 95:	Operation not supported on transport endpoint.
-			case ENOBUFS:		// 105:	No buffer space available.
 				// unexpected errors.
 				PLOG(FATAL) << "unexpected error of ::accept4";
 				break;
@@ -178,8 +181,6 @@ int accept(int servfd, struct sockaddr_in6* dst, bool nonblock, bool cloexec)
 				break;
 		}
 	}
-	
-	PLOG_IF(ERROR, connfd < 0) << "::accept failed";
 
 	return connfd;
 }
@@ -366,9 +367,10 @@ int set_reuse_addr(int servfd, bool on)
 #endif
 }
 
+// The load balancing between the listen sockets is supported since Linux
+// kernel 3.9.
 int set_reuse_port(int servfd, bool on)
 {
-#ifndef OS_LINUX
 #ifdef SO_REUSEPORT
 	int opt = on ? 1 : 0;
 	socklen_t optlen = static_cast<socklen_t>(sizeof opt);
@@ -383,11 +385,6 @@ int set_reuse_port(int servfd, bool on)
 	}
 	return -1;
 #endif
-
-#else
-	// FIXME: Supported since Linux kernel 3.9
-	return 0;
-#endif
 }
 
 // After enabling SO_KEEPALIVE, if there is no data exchange on this socket within 2 hours, 
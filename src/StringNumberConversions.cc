@@ -0,0 +1,610 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// By: wlmwang
+// Date: Oct 17 2026
+
+#include "strings/StringNumberConversions.h"
+#include "Macros.h"		// arraysize
+#include "Logging.h"
+
+#include <string.h>		// ::memcpy,::memset
+#include <stdio.h>		// ::snprintf
+#include <stdlib.h>		// ::strtod,::atoi
+
+namespace annety
+{
+namespace
+{
+const char kDigitPairs[] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+const char kDigitHexMaps[] = "0123456789ABCDEF";
+
+int count_digits(uint64_t v)
+{
+	int n = 1;
+	for (;;) {
+		if (v < 10) {
+			return n;
+		}
+		if (v < 100) {
+			return n + 1;
+		}
+		if (v < 1000) {
+			return n + 2;
+		}
+		if (v < 10000) {
+			return n + 3;
+		}
+		v /= 10000u;
+		n += 4;
+	}
+}
+
+// Grisu3---------------------------------------------------
+
+// "Printing Floating-Point Numbers Quickly and Accurately with Integers",
+// by Florian Loitsch. Port of the double-conversion library.
+
+// The floating-point number f * 2^e, with 64 bits of the significand.
+struct DiyFp
+{
+	uint64_t f;
+	int e;
+};
+
+DiyFp diyfp_minus(const DiyFp& a, const DiyFp& b)
+{
+	DCHECK(a.e == b.e && a.f >= b.f);
+	return DiyFp{a.f - b.f, a.e};
+}
+
+// The upper 64 bits of the product (rounded).
+DiyFp diyfp_times(const DiyFp& a, const DiyFp& b)
+{
+	const uint64_t kM32 = 0xFFFFFFFFu;
+	const uint64_t a_hi = a.f >> 32, a_lo = a.f & kM32;
+	const uint64_t b_hi = b.f >> 32, b_lo = b.f & kM32;
+
+	const uint64_t hi_hi = a_hi * b_hi;
+	const uint64_t hi_lo = a_hi * b_lo;
+	const uint64_t lo_hi = a_lo * b_hi;
+	const uint64_t lo_lo = a_lo * b_lo;
+
+	uint64_t tmp = (lo_lo >> 32) + (hi_lo & kM32) + (lo_hi & kM32);
+	tmp += 1u << 31;	// round
+
+	return DiyFp{hi_hi + (hi_lo >> 32) + (lo_hi >> 32) + (tmp >> 32), a.e + b.e + 64};
+}
+
+DiyFp diyfp_normalize(DiyFp v)
+{
+	DCHECK(v.f != 0);
+	while (!(v.f & (static_cast<uint64_t>(1) << 63))) {
+		v.f <<= 1;
+		v.e--;
+	}
+	return v;
+}
+
+// The cached powers of ten, 10^k = f * 2^e (f is normalized and rounded).
+struct CachedPower
+{
+	uint64_t f;
+	int e;
+	int k;
+};
+
+const int kCachedPowersMinDecExp = -300;
+const int kCachedPowersDecStep = 8;
+
+const CachedPower kCachedPowers[] = {
+	{0xAB70FE17C79AC6CA, -1060, -300},
+	{0xFF77B1FCBEBCDC4F, -1034, -292},
+	{0xBE5691EF416BD60C, -1007, -284},
+	{0x8DD01FAD907FFC3C,  -980, -276},
+	{0xD3515C2831559A83,  -954, -268},
+	{0x9D71AC8FADA6C9B5,  -927, -260},
+	{0xEA9C227723EE8BCB,  -901, -252},
+	{0xAECC49914078536D,  -874, -244},
+	{0x823C12795DB6CE57,  -847, -236},
+	{0xC21094364DFB5637,  -821, -228},
+	{0x9096EA6F3848984F,  -794, -220},
+	{0xD77485CB25823AC7,  -768, -212},
+	{0xA086CFCD97BF97F4,  -741, -204},
+	{0xEF340A98172AACE5,  -715, -196},
+	{0xB23867FB2A35B28E,  -688, -188},
+	{0x84C8D4DFD2C63F3B,  -661, -180},
+	{0xC5DD44271AD3CDBA,  -635, -172},
+	{0x936B9FCEBB25C996,  -608, -164},
+	{0xDBAC6C247D62A584,  -582, -156},
+	{0xA3AB66580D5FDAF6,  -555, -148},
+	{0xF3E2F893DEC3F126,  -529, -140},
+	{0xB5B5ADA8AAFF80B8,  -502, -132},
+	{0x87625F056C7C4A8B,  -475, -124},
+	{0xC9BCFF6034C13053,  -449, -116},
+	{0x964E858C91BA2655,  -422, -108},
+	{0xDFF9772470297EBD,  -396, -100},
+	{0xA6DFBD9FB8E5B88F,  -369,  -92},
+	{0xF8A95FCF88747D94,  -343,  -84},
+	{0xB94470938FA89BCF,  -316,  -76},
+	{0x8A08F0F8BF0F156B,  -289,  -68},
+	{0xCDB02555653131B6,  -263,  -60},
+	{0x993FE2C6D07B7FAC,  -236,  -52},
+	{0xE45C10C42A2B3B06,  -210,  -44},
+	{0xAA242499697392D3,  -183,  -36},
+	{0xFD87B5F28300CA0E,  -157,  -28},
+	{0xBCE5086492111AEB,  -130,  -20},
+	{0x8CBCCC096F5088CC,  -103,  -12},
+	{0xD1B71758E219652C,   -77,   -4},
+	{0x9C40000000000000,   -50,    4},
+	{0xE8D4A51000000000,   -24,   12},
+	{0xAD78EBC5AC620000,     3,   20},
+	{0x813F3978F8940984,    30,   28},
+	{0xC097CE7BC90715B3,    56,   36},
+	{0x8F7E32CE7BEA5C70,    83,   44},
+	{0xD5D238A4ABE98068,   109,   52},
+	{0x9F4F2726179A2245,   136,   60},
+	{0xED63A231D4C4FB27,   162,   68},
+	{0xB0DE65388CC8ADA8,   189,   76},
+	{0x83C7088E1AAB65DB,   216,   84},
+	{0xC45D1DF942711D9A,   242,   92},
+	{0x924D692CA61BE758,   269,  100},
+	{0xDA01EE641A708DEA,   295,  108},
+	{0xA26DA3999AEF774A,   322,  116},
+	{0xF209787BB47D6B85,   348,  124},
+	{0xB454E4A179DD1877,   375,  132},
+	{0x865B86925B9BC5C2,   402,  140},
+	{0xC83553C5C8965D3D,   428,  148},
+	{0x952AB45CFA97A0B3,   455,  156},
+	{0xDE469FBD99A05FE3,   481,  164},
+	{0xA59BC234DB398C25,   508,  172},
+	{0xF6C69A72A3989F5C,   534,  180},
+	{0xB7DCBF5354E9BECE,   561,  188},
+	{0x88FCF317F22241E2,   588,  196},
+	{0xCC20CE9BD35C78A5,   614,  204},
+	{0x98165AF37B2153DF,   641,  212},
+	{0xE2A0B5DC971F303A,   667,  220},
+	{0xA8D9D1535CE3B396,   694,  228},
+	{0xFB9B7CD9A4A7443C,   720,  236},
+	{0xBB764C4CA7A44410,   747,  244},
+	{0x8BAB8EEFB6409C1A,   774,  252},
+	{0xD01FEF10A657842C,   800,  260},
+	{0x9B10A4E5E9913129,   827,  268},
+	{0xE7109BFBA19C0C9D,   853,  276},
+	{0xAC2820D9623BF429,   880,  284},
+	{0x80444B5E7AA7CF85,   907,  292},
+	{0xBF21E44003ACDD2D,   933,  300},
+	{0x8E679C2F5E44FF8F,   960,  308},
+	{0xD433179D9C8CB841,   986,  316},
+	{0x9E19DB92B4E31BA9,  1013,  324},
+};
+
+// The range of the binary exponent of the scaled w, the integral part of
+// it fits into 32 bits.
+const int kAlpha = -60;
+const int kGamma = -32;
+
+// Returns the cached power c of ten (c.k), which makes the product of c
+// and the DiyFp of binary exponent |e| in [kAlpha, kGamma].
+const CachedPower& get_cached_power(int e)
+{
+	const int f = kAlpha - e - 1;
+	// ceil(f * log10(2))
+	const int k = (f * 78913) / (1 << 18) + static_cast<int>(f > 0);
+	const int index = (-kCachedPowersMinDecExp + k + (kCachedPowersDecStep - 1)) /
+						kCachedPowersDecStep;
+	DCHECK(index >= 0 && static_cast<size_t>(index) < arraysize(kCachedPowers));
+
+	const CachedPower& cached = kCachedPowers[index];
+	DCHECK(kAlpha <= cached.e + e + 64 && kGamma >= cached.e + e + 64);
+	return cached;
+}
+
+// Returns the largest power of ten <= |n|, |*exponent_plus_one| is the
+// number of digits of |n|.
+uint32_t biggest_power_ten(uint32_t n, int* exponent_plus_one)
+{
+	static const uint32_t kPowersOfTen[] = {
+		1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+		100000000, 1000000000
+	};
+
+	int i = 9;
+	while (i > 0 && n < kPowersOfTen[i]) {
+		i--;
+	}
+	*exponent_plus_one = n == 0? 0: i + 1;
+	return kPowersOfTen[i];
+}
+
+// Moves the last digit of |buff| closer to w, and returns false if the
+// digits can not be proved that they are the shortest and closest ones.
+bool round_weed(char* buff, int len, uint64_t distance_too_high_w,
+				uint64_t unsafe_interval, uint64_t rest, uint64_t ten_kappa,
+				uint64_t unit)
+{
+	const uint64_t small_distance = distance_too_high_w - unit;
+	const uint64_t big_distance = distance_too_high_w + unit;
+
+	while (rest < small_distance &&
+		   unsafe_interval - rest >= ten_kappa &&
+		   (rest + ten_kappa < small_distance ||
+			small_distance - rest >= rest + ten_kappa - small_distance)) {
+		buff[len - 1]--;
+		rest += ten_kappa;
+	}
+
+	if (rest < big_distance &&
+		unsafe_interval - rest >= ten_kappa &&
+		(rest + ten_kappa < big_distance ||
+		 big_distance - rest > rest + ten_kappa - big_distance)) {
+		return false;
+	}
+
+	return (2 * unit <= rest) && (rest <= unsafe_interval - 4 * unit);
+}
+
+// Generates the shortest digits in (low, high), which are the closest to w.
+bool digit_gen(const DiyFp& low, const DiyFp& w, const DiyFp& high,
+			   char* buff, int* len, int* kappa)
+{
+	DCHECK(low.e == w.e && w.e == high.e);
+	DCHECK(kAlpha <= w.e && w.e <= kGamma);
+
+	uint64_t unit = 1;
+	const DiyFp too_low{low.f - unit, low.e};
+	const DiyFp too_high{high.f + unit, high.e};
+	DiyFp unsafe_interval = diyfp_minus(too_high, too_low);
+
+	const DiyFp one{static_cast<uint64_t>(1) << -w.e, w.e};
+	uint32_t integrals = static_cast<uint32_t>(too_high.f >> -one.e);
+	uint64_t fractionals = too_high.f & (one.f - 1);
+
+	uint32_t divisor = biggest_power_ten(integrals, kappa);
+	*len = 0;
+
+	while (*kappa > 0) {
+		const uint32_t digit = integrals / divisor;
+		buff[(*len)++] = static_cast<char>('0' + digit);
+		integrals %= divisor;
+		(*kappa)--;
+
+		const uint64_t rest = (static_cast<uint64_t>(integrals) << -one.e) + fractionals;
+		if (rest < unsafe_interval.f) {
+			return round_weed(buff, *len, diyfp_minus(too_high, w).f,
+				unsafe_interval.f, rest, static_cast<uint64_t>(divisor) << -one.e, unit);
+		}
+		divisor /= 10;
+	}
+
+	for (;;) {
+		fractionals *= 10;
+		unit *= 10;
+		unsafe_interval.f *= 10;
+
+		const uint32_t digit = static_cast<uint32_t>(fractionals >> -one.e);
+		buff[(*len)++] = static_cast<char>('0' + digit);
+		fractionals &= one.f - 1;
+		(*kappa)--;
+
+		if (fractionals < unsafe_interval.f) {
+			return round_weed(buff, *len, diyfp_minus(too_high, w).f * unit,
+				unsafe_interval.f, fractionals, one.f, unit);
+		}
+	}
+}
+
+// The digits of the positive finite number of |significand| and |biased_e|,
+// which are the fields of the IEEE format of |significand_size| bits and
+// |exponent_bias|, v = digits * 10^(*dexp).
+bool grisu3(uint64_t significand, int biased_e, int significand_size, 
+			int exponent_bias, char* buff, int* len, int* dexp)
+{
+	const uint64_t kHiddenBit = static_cast<uint64_t>(1) << significand_size;
+	const int kExponentBias = exponent_bias + significand_size;
+	const int kDenormalExponent = -kExponentBias + 1;
+
+	DiyFp w;
+	if (biased_e == 0) {
+		w = DiyFp{significand, kDenormalExponent};
+	} else {
+		w = DiyFp{significand + kHiddenBit, biased_e - kExponentBias};
+	}
+
+	// The boundaries m- and m+, the lower one is closer when the significand
+	// is a power of two (and it is not the smallest normal).
+	const DiyFp m_plus = diyfp_normalize(DiyFp{(w.f << 1) + 1, w.e - 1});
+	DiyFp m_minus;
+	if (significand == 0 && biased_e > 1) {
+		m_minus = DiyFp{(w.f << 2) - 1, w.e - 2};
+	} else {
+		m_minus = DiyFp{(w.f << 1) - 1, w.e - 1};
+	}
+	m_minus.f <<= m_minus.e - m_plus.e;
+	m_minus.e = m_plus.e;
+	w = diyfp_normalize(w);
+
+	const CachedPower& cached = get_cached_power(m_plus.e);
+	const DiyFp c{cached.f, cached.e};
+
+	const DiyFp scaled_w = diyfp_times(w, c);
+	const DiyFp scaled_minus = diyfp_times(m_minus, c);
+	const DiyFp scaled_plus = diyfp_times(m_plus, c);
+
+	int kappa = 0;
+	const bool ok = digit_gen(scaled_minus, scaled_w, scaled_plus, buff, len, &kappa);
+	*dexp = kappa - cached.k;
+	return ok;
+}
+
+// The slow path, the shortest (correctly rounded) digits of printf that
+// round trip. The |v| of float is round tripped by strtof(), up to 9 digits.
+void shortest_printf(double v, bool single, char* buff, int* len, int* dexp)
+{
+	const int kMaxPrecision = single? 9: 17;
+
+	char tmp[32];
+	int precision = 1;
+	for (; precision < kMaxPrecision; ++precision) {
+		::snprintf(tmp, sizeof(tmp), "%.*e", precision - 1, v);
+		if (single? ::strtof(tmp, nullptr) == static_cast<float>(v): 
+					::strtod(tmp, nullptr) == v) {
+			break;
+		}
+	}
+	if (precision == kMaxPrecision) {
+		::snprintf(tmp, sizeof(tmp), "%.*e", precision - 1, v);
+	}
+
+	// "d.ddde+XX"
+	const char* p = tmp;
+	*len = 0;
+	buff[(*len)++] = *p++;
+	if (*p == '.') {
+		for (++p; *p != 'e'; ++p) {
+			buff[(*len)++] = *p;
+		}
+	}
+	*dexp = ::atoi(p + 1) - (*len - 1);
+}
+
+char* write_exponent(char* p, int e)
+{
+	*p++ = 'e';
+	if (e < 0) {
+		*p++ = '-';
+		e = -e;
+	} else {
+		*p++ = '+';
+	}
+
+	if (e >= 100) {
+		*p++ = static_cast<char>('0' + e / 100);
+		e %= 100;
+	}
+	::memcpy(p, kDigitPairs + e * 2, 2);
+	return p + 2;
+}
+
+// Writes digits * 10^dexp in the notation of printf("%.{precision}g"), the
+// trailing zeros are removed.
+char* write_digits(char* p, const char* digits, int len, int dexp, int precision)
+{
+	while (len > 1 && digits[len - 1] == '0') {
+		len--;
+		dexp++;
+	}
+	DCHECK(len > 0 && len <= precision);
+
+	// The decimal exponent of the first digit.
+	const int e = dexp + len - 1;
+
+	if (e < -4 || e >= precision) {
+		// d.ddde+XX
+		*p++ = digits[0];
+		if (len > 1) {
+			*p++ = '.';
+			::memcpy(p, digits + 1, len - 1);
+			p += len - 1;
+		}
+		p = write_exponent(p, e);
+	} else if (e >= len - 1) {
+		// ddd000
+		::memcpy(p, digits, len);
+		p += len;
+		::memset(p, '0', e - (len - 1));
+		p += e - (len - 1);
+	} else if (e >= 0) {
+		// dd.ddd
+		::memcpy(p, digits, e + 1);
+		p += e + 1;
+		*p++ = '.';
+		::memcpy(p, digits + e + 1, len - (e + 1));
+		p += len - (e + 1);
+	} else {
+		// 0.000ddd
+		*p++ = '0';
+		*p++ = '.';
+		::memset(p, '0', -e - 1);
+		p += -e - 1;
+		::memcpy(p, digits, len);
+		p += len;
+	}
+	return p;
+}
+
+}	// namespace anonymous
+
+size_t format_uint64(char* buff, uint64_t v)
+{
+	const int n = count_digits(v);
+	char* p = buff + n;
+
+	while (v >= 100) {
+		const size_t i = static_cast<size_t>(v % 100) * 2;
+		v /= 100;
+		*--p = kDigitPairs[i + 1];
+		*--p = kDigitPairs[i];
+	}
+	if (v >= 10) {
+		const size_t i = static_cast<size_t>(v) * 2;
+		*--p = kDigitPairs[i + 1];
+		*--p = kDigitPairs[i];
+	} else {
+		*--p = static_cast<char>('0' + v);
+	}
+
+	DCHECK(p == buff);
+	return n;
+}
+
+size_t format_int64(char* buff, int64_t v)
+{
+	if (v < 0) {
+		*buff = '-';
+		// The negation of INT64_MIN is well defined in unsigned.
+		return 1 + format_uint64(buff + 1, 0 - static_cast<uint64_t>(v));
+	}
+	return format_uint64(buff, static_cast<uint64_t>(v));
+}
+
+size_t format_hex(char* buff, uint64_t v)
+{
+	int n = 1;
+	for (uint64_t t = v >> 4; t != 0; t >>= 4) {
+		n++;
+	}
+
+	char* p = buff + n;
+	do {
+		*--p = kDigitHexMaps[v & 0xF];
+		v >>= 4;
+	} while (v != 0);
+
+	return n;
+}
+
+size_t format_double(char* buff, double v)
+{
+	char* p = buff;
+
+	uint64_t bits;
+	::memcpy(&bits, &v, sizeof(bits));
+	if (bits >> 63) {
+		*p++ = '-';
+		v = -v;
+	}
+
+	if (v != v) {
+		::memcpy(p, "nan", 3);
+		return p + 3 - buff;
+	}
+	if (v > 1.7976931348623157e308) {
+		::memcpy(p, "inf", 3);
+		return p + 3 - buff;
+	}
+	if (v == 0) {
+		*p++ = '0';
+		return p - buff;
+	}
+
+	char digits[32];
+	int len = 0, dexp = 0;
+	const uint64_t significand = bits & ((static_cast<uint64_t>(1) << 52) - 1);
+	const int biased_e = static_cast<int>((bits >> 52) & 0x7FF);
+	if (!grisu3(significand, biased_e, 52, 0x3FF, digits, &len, &dexp)) {
+		shortest_printf(v, false, digits, &len, &dexp);
+	}
+	p = write_digits(p, digits, len, dexp, 17);
+
+	DCHECK(static_cast<size_t>(p - buff) <= kMaxDoubleFormatSize);
+	return p - buff;
+}
+
+size_t format_float(char* buff, float v)
+{
+	char* p = buff;
+
+	uint32_t bits;
+	::memcpy(&bits, &v, sizeof(bits));
+	if (bits >> 31) {
+		*p++ = '-';
+		v = -v;
+	}
+
+	if (v != v) {
+		::memcpy(p, "nan", 3);
+		return p + 3 - buff;
+	}
+	if (v > 3.40282347e38f) {
+		::memcpy(p, "inf", 3);
+		return p + 3 - buff;
+	}
+	if (v == 0) {
+		*p++ = '0';
+		return p - buff;
+	}
+
+	char digits[32];
+	int len = 0, dexp = 0;
+	const uint32_t significand = bits & ((1u << 23) - 1);
+	const int biased_e = static_cast<int>((bits >> 23) & 0xFF);
+	if (!grisu3(significand, biased_e, 23, 0x7F, digits, &len, &dexp)) {
+		shortest_printf(v, true, digits, &len, &dexp);
+	}
+	p = write_digits(p, digits, len, dexp, 9);
+
+	DCHECK(static_cast<size_t>(p - buff) <= kMaxFloatFormatSize);
+	return p - buff;
+}
+
+std::string number_to_string(int value)
+{
+	char buff[kMaxIntegerFormatSize];
+	return std::string(buff, format_integer(buff, value));
+}
+
+std::string number_to_string(unsigned int value)
+{
+	char buff[kMaxIntegerFormatSize];
+	return std::string(buff, format_integer(buff, value));
+}
+
+std::string number_to_string(long value)
+{
+	char buff[kMaxIntegerFormatSize];
+	return std::string(buff, format_integer(buff, value));
+}
+
+std::string number_to_string(unsigned long value)
+{
+	char buff[kMaxIntegerFormatSize];
+	return std::string(buff, format_integer(buff, value));
+}
+
+std::string number_to_string(long long value)
+{
+	char buff[kMaxIntegerFormatSize];
+	return std::string(buff, format_integer(buff, value));
+}
+
+std::string number_to_string(unsigned long long value)
+{
+	char buff[kMaxIntegerFormatSize];
+	return std::string(buff, format_integer(buff, value));
+}
+
+std::string number_to_string(double value)
+{
+	char buff[kMaxDoubleFormatSize];
+	return std::string(buff, format_double(buff, value));
+}
+
+}	// namespace annety
@@ -6,13 +6,20 @@
 // Date: Jun 04 2019
 
 #include "strings/StringUtil.h"
+#include "build/CompilerSpecific.h"
 #include "Logging.h"
 
 #include <stddef.h>
+#include <string.h>		// ::memchr,::memcmp
 #include <algorithm>	// std::equal,std::min
 #include <vector>
 #include <string>		// std::string,std::char_traits
 
+#if defined(ARCH_CPU_X86_64) && defined(COMPILER_GCC)
+#define ANT_FIND_SIMD 1
+#include <immintrin.h>	// _mm_cmpeq_epi8,_mm256_cmpeq_epi8
+#endif
+
 namespace annety
 {
 const char kWhitespace[] = {
@@ -263,6 +270,128 @@ bool ends_with(StringPiece str,
 	return ends_with_T(str, search_for, case_sensitivity);
 }
 
+// Find----------------------------------------------------
+namespace
+{
+// |len| >= |k| >= 2, returns the offset of |needle| in |str|, or npos.
+size_t find_scalar(const char* str, size_t len, const char* needle, size_t k)
+{
+	const char* curr = str;
+	const char* last = str + len - k;
+	while (curr <= last) {
+		const void* hit = ::memchr(curr, needle[0], last - curr + 1);
+		if (!hit) {
+			break;
+		}
+		curr = static_cast<const char*>(hit);
+		if (::memcmp(curr + 1, needle + 1, k - 1) == 0) {
+			return curr - str;
+		}
+		curr++;
+	}
+	return StringPiece::npos;
+}
+
+#if defined(ANT_FIND_SIMD)
+// The block of candidates [i, i+16) is matched by its first bytes (at i) and
+// its last bytes (at i+k-1), the bits of mask are the candidates that both
+// bytes are matched.
+// See: http://0x80.pl/articles/simd-strfind.html
+size_t find_sse2(const char* str, size_t len, const char* needle, size_t k)
+{
+	const __m128i first = _mm_set1_epi8(needle[0]);
+	const __m128i last = _mm_set1_epi8(needle[k - 1]);
+
+	size_t i = 0;
+	for (; i + k + 15 <= len; i += 16) {
+		const __m128i block_first = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(str + i));
+		const __m128i block_last = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(str + i + k - 1));
+		unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+				_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last)));
+		while (mask != 0) {
+			const size_t bit = __builtin_ctz(mask);
+			if (k == 2 || ::memcmp(str + i + bit + 1, needle + 1, k - 2) == 0) {
+				return i + bit;
+			}
+			mask &= mask - 1;
+		}
+	}
+
+	// The tail is shorter than a block.
+	size_t n = i + k <= len ? find_scalar(str + i, len - i, needle, k) : StringPiece::npos;
+	return n != StringPiece::npos ? i + n : StringPiece::npos;
+}
+
+__attribute__((target("avx2")))
+size_t find_avx2(const char* str, size_t len, const char* needle, size_t k)
+{
+	const __m256i first = _mm256_set1_epi8(needle[0]);
+	const __m256i last = _mm256_set1_epi8(needle[k - 1]);
+
+	size_t i = 0;
+	for (; i + k + 31 <= len; i += 32) {
+		const __m256i block_first = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(str + i));
+		const __m256i block_last = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(str + i + k - 1));
+		unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(
+				_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last))));
+		while (mask != 0) {
+			const size_t bit = __builtin_ctz(mask);
+			if (k == 2 || ::memcmp(str + i + bit + 1, needle + 1, k - 2) == 0) {
+				return i + bit;
+			}
+			mask &= mask - 1;
+		}
+	}
+
+	// The tail is shorter than a block.
+	size_t n = i + k <= len ? find_sse2(str + i, len - i, needle, k) : StringPiece::npos;
+	return n != StringPiece::npos ? i + n : StringPiece::npos;
+}
+#endif	// ANT_FIND_SIMD
+
+using find_func_t = size_t(*)(const char*, size_t, const char*, size_t);
+
+find_func_t select_find()
+{
+#if defined(ANT_FIND_SIMD)
+	if (__builtin_cpu_supports("avx2")) {
+		return find_avx2;
+	}
+	return find_sse2;
+#else
+	return find_scalar;
+#endif
+}
+
+}	// namespace anonymous
+
+size_t find_substring(StringPiece str, StringPiece needle, size_t pos)
+{
+	if (pos > str.size() || needle.size() > str.size() - pos) {
+		return StringPiece::npos;
+	}
+	if (needle.empty()) {
+		return pos;
+	}
+
+	const char* begin = str.data() + pos;
+	const size_t len = str.size() - pos;
+	if (needle.size() == 1) {
+		// The memchr() of libc is vectorized already.
+		const void* hit = ::memchr(begin, needle[0], len);
+		return hit ? static_cast<const char*>(hit) - str.data() : StringPiece::npos;
+	}
+
+	// Selected once by the cpu features.
+	static const find_func_t func = select_find();
+	size_t n = func(begin, len, needle.data(), needle.size());
+	return n != StringPiece::npos ? pos + n : StringPiece::npos;
+}
+
 // Trim----------------------------------------------------
 namespace
 {
@@ -0,0 +1,339 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#include "TcpClientPool.h"
+#include "Logging.h"
+#include "SocketsUtil.h"
+#include "EndPoint.h"
+#include "TcpClient.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "EventLoopPool.h"
+#include "strings/StringPrintf.h"
+#include "containers/Bind.h"
+#include "synchronization/CountDownLatch.h"
+
+#include <utility>
+#include <limits.h>		// INT_MAX
+#include <string.h>		// ::memcmp
+
+namespace annety
+{
+namespace internal {
+static bool same_endpoint(const EndPoint& lhs, const EndPoint& rhs)
+{
+	if (lhs.family() != rhs.family()) {
+		return false;
+	}
+	if (lhs.family() == AF_INET) {
+		const struct sockaddr_in* l = sockets::sockaddr_in_cast(lhs.get_sockaddr());
+		const struct sockaddr_in* r = sockets::sockaddr_in_cast(rhs.get_sockaddr());
+		return l->sin_port == r->sin_port &&
+			l->sin_addr.s_addr == r->sin_addr.s_addr;
+	} else {
+		const struct sockaddr_in6* l = sockets::sockaddr_in6_cast(lhs.get_sockaddr());
+		const struct sockaddr_in6* r = sockets::sockaddr_in6_cast(rhs.get_sockaddr());
+		return l->sin6_port == r->sin6_port &&
+			::memcmp(&l->sin6_addr, &r->sin6_addr, sizeof l->sin6_addr) == 0;
+	}
+}
+
+}	// namespace internal
+
+// TcpClientPool::Lease
+TcpClientPool::Lease::Lease(Slot* slot, TcpConnectionPtr conn)
+	: slot_(slot)
+	, conn_(std::move(conn))
+{
+	slot_->outstanding.fetch_add(1, std::memory_order_relaxed);
+}
+
+TcpClientPool::Lease::~Lease()
+{
+	release();
+}
+
+TcpClientPool::Lease::Lease(Lease&& rhs) noexcept
+	: slot_(rhs.slot_)
+	, conn_(std::move(rhs.conn_))
+{
+	rhs.slot_ = nullptr;
+}
+
+TcpClientPool::Lease& TcpClientPool::Lease::operator=(Lease&& rhs) noexcept
+{
+	if (this != &rhs) {
+		release();
+		slot_ = rhs.slot_;
+		conn_ = std::move(rhs.conn_);
+		rhs.slot_ = nullptr;
+	}
+	return *this;
+}
+
+void TcpClientPool::Lease::release()
+{
+	if (slot_) {
+		slot_->outstanding.fetch_sub(1, std::memory_order_relaxed);
+		slot_ = nullptr;
+	}
+	conn_.reset();
+}
+
+void TcpClientPool::Lease::fail()
+{
+	if (conn_) {
+		LOG(WARNING) << "TcpClientPool::Lease::fail the connection ["
+			<< conn_->name() << "] is broken, reconnect it now";
+
+		// The TcpClient will reconnect it by the Connector.
+		conn_->force_close();
+	}
+	release();
+}
+
+// TcpClientPool::Slot
+TcpClientPool::Slot::Slot(EventLoop* l, TcpClientPtr c)
+	: loop(l)
+	, client(std::move(c)) {}
+
+TcpClientPool::Slot::~Slot() = default;
+
+// TcpClientPool
+TcpClientPool::TcpClientPool(EventLoop* loop, const std::string& name)
+	: owner_loop_(loop)
+	, name_(name)
+	, workers_(new EventLoopPool(loop, name))
+	, connect_cb_(default_connect_callback)
+	, close_cb_(default_close_callback)
+	, message_cb_(default_message_callback)
+{
+	CHECK(loop);
+
+	LOG(DEBUG) << "TcpClientPool::TcpClientPool [" << name_ << "] is constructing";
+}
+
+void TcpClientPool::initialize()
+{
+	DCHECK(!initilize_);
+	initilize_ = true;
+}
+
+TcpClientPool::~TcpClientPool()
+{
+	DCHECK(initilize_);
+
+	owner_loop_->check_in_own_loop();
+
+	// Destroy the clients and the connections in their own loop.
+	for (auto& upstream : upstreams_) {
+		for (auto& slot : upstream->slots) {
+			Slot* s = slot.get();
+			CountDownLatch latch(1);
+			s->loop->run_in_own_loop([s, &latch]() {
+				s->conn.reset();
+				s->client.reset();
+				latch.count_down();
+			});
+			latch.wait();
+		}
+	}
+
+	LOG(DEBUG) << "TcpClientPool::~TcpClientPool [" << name_ << "] is destructing";
+}
+
+void TcpClientPool::add_endpoint(const EndPoint& addr)
+{
+	DCHECK(initilize_);
+	DCHECK(upstreams_.empty() || upstreams_.back()->slots.empty());
+
+	upstreams_.emplace_back(new Upstream());
+	upstreams_.back()->addr = addr;
+}
+
+void TcpClientPool::set_connection_num(int num_conns)
+{
+	DCHECK(initilize_);
+
+	CHECK(0 < num_conns);
+	num_conns_ = num_conns;
+}
+
+void TcpClientPool::set_thread_num(int num_threads)
+{
+	DCHECK(initilize_);
+
+	CHECK(0 <= num_threads);
+	workers_->set_thread_num(num_threads);
+}
+
+void TcpClientPool::set_loops(const std::vector<EventLoop*>& loops)
+{
+	DCHECK(initilize_);
+	DCHECK(!workers_->started());
+
+	loops_ = loops;
+}
+
+void TcpClientPool::start()
+{
+	DCHECK(initilize_);
+
+	if (started_.test_and_set()) {
+		return;
+	}
+
+	if (loops_.empty()) {
+		// Starting all event loop thread pool.
+		workers_->start(thread_init_cb_);
+		loops_ = workers_->get_all_loops();
+	}
+	int num_conns = num_conns_ > 0? num_conns_: static_cast<int>(loops_.size());
+
+	// The callbacks are bound with the weak pointer, the connections may
+	// outlive the pool.
+	using containers::_1;
+	using containers::make_weak_bind;
+
+	size_t next = 0;
+	for (auto& upstream : upstreams_) {
+		for (int i = 0; i < num_conns; ++i) {
+			// round-robin
+			EventLoop* loop = loops_[next++ % loops_.size()];
+
+			TcpClientPtr client = make_tcp_client(loop, upstream->addr,
+										name_ + string_printf("#%d", i));
+			Slot* slot = new Slot(loop, client);
+			upstream->slots.emplace_back(slot);
+
+			client->set_connect_callback(
+				make_weak_bind(&TcpClientPool::handle_connect, shared_from_this(), slot, _1));
+			client->set_close_callback(
+				make_weak_bind(&TcpClientPool::handle_close, shared_from_this(), slot, _1));
+			client->set_message_callback(message_cb_);
+			client->set_write_complete_callback(write_complete_cb_);
+
+			// Reconnect by the Connector of client.
+			client->enable_retry();
+			client->connect();
+		}
+	}
+
+	LOG(INFO) << "TcpClientPool::start [" << name_ << "] connect "
+		<< num_conns << " connections to each of " << upstreams_.size()
+		<< " endpoints on " << loops_.size() << " loops";
+}
+
+void TcpClientPool::stop()
+{
+	DCHECK(initilize_);
+
+	for (auto& upstream : upstreams_) {
+		for (auto& slot : upstream->slots) {
+			slot->client->stop();
+		}
+	}
+}
+
+TcpClientPool::Lease TcpClientPool::lease(const EndPoint& addr)
+{
+	for (auto& upstream : upstreams_) {
+		if (internal::same_endpoint(upstream->addr, addr)) {
+			return select(upstream.get());
+		}
+	}
+	LOG(ERROR) << "TcpClientPool::lease [" << name_ << "] has no endpoint "
+		<< addr.to_ip_port();
+	return Lease();
+}
+
+TcpClientPool::Lease TcpClientPool::lease()
+{
+	return select(nullptr);
+}
+
+int TcpClientPool::connected_count() const
+{
+	return connected_.load(std::memory_order_relaxed);
+}
+
+TcpClientPool::Lease TcpClientPool::select(const Upstream* upstream)
+{
+	// The `conn` of the calling loop is only stored by this thread.
+	EventLoop* loop = EventLoop::get_current_loop();
+	if (loop) {
+		Slot* slot = select_slot(upstream, loop);
+		if (slot && slot->conn) {
+			return Lease(slot, slot->conn);
+		}
+	}
+
+	Slot* slot = select_slot(upstream, nullptr);
+	if (slot) {
+		TcpConnectionPtr conn = std::atomic_load(&slot->conn);
+		if (conn) {
+			return Lease(slot, std::move(conn));
+		}
+	}
+	return Lease();
+}
+
+TcpClientPool::Slot* TcpClientPool::select_slot(const Upstream* upstream, const EventLoop* loop) const
+{
+	Slot* best = nullptr;
+	int least = INT_MAX;
+	for (auto& u : upstreams_) {
+		if (upstream && upstream != u.get()) {
+			continue;
+		}
+		for (auto& slot : u->slots) {
+			if (!slot->connected.load(std::memory_order_acquire) ||
+				(loop && slot->loop != loop))
+			{
+				continue;
+			}
+			int outstanding = slot->outstanding.load(std::memory_order_relaxed);
+			if (outstanding < least) {
+				least = outstanding;
+				best = slot.get();
+			}
+		}
+	}
+	return best;
+}
+
+void TcpClientPool::handle_connect(Slot* slot, const TcpConnectionPtr& conn)
+{
+	slot->loop->check_in_own_loop();
+
+	std::atomic_store(&slot->conn, conn);
+	slot->connected.store(true, std::memory_order_release);
+	connected_.fetch_add(1, std::memory_order_relaxed);
+
+	connect_cb_(conn);
+}
+
+void TcpClientPool::handle_close(Slot* slot, const TcpConnectionPtr& conn)
+{
+	slot->loop->check_in_own_loop();
+
+	if (slot->conn == conn) {
+		slot->connected.store(false, std::memory_order_release);
+		std::atomic_store(&slot->conn, TcpConnectionPtr());
+		connected_.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	close_cb_(conn);
+}
+
+// Constructs an object of type TcpClientPoolPtr and wraps it.
+TcpClientPoolPtr make_tcp_client_pool(EventLoop* loop, const std::string& name)
+{
+	CHECK(loop);
+
+	TcpClientPoolPtr pool(new TcpClientPool(loop, name));
+	pool->initialize();
+	return pool;
+}
+
+}	// namespace annety
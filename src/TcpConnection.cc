@@ -4,6 +4,7 @@
 #include "TcpConnection.h"
 #include "Channel.h"
 #include "NetBuffer.h"
+#include "BufferChain.h"
 #include "EndPoint.h"
 #include "EventLoop.h"
 #include "SocketFD.h"
@@ -12,9 +13,40 @@
 #include "containers/Bind.h"
 
 #include <utility>
+#include <algorithm>
+#include <limits.h>		// IOV_MAX
+#include <sys/uio.h>	// struct iovec
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
 
 namespace annety
 {
+namespace
+{
+// The maximum number of iovecs flushed by one writev(2). The iovecs are on
+// the stack (1KB), the rest is flushed by the next writev(2).
+const int kMaxIovecs = IOV_MAX < 64? IOV_MAX: 64;
+
+// Copying the small bytes into the owned tail segment is cheaper than 
+// queuing a new segment.
+const size_t kCoalesceBytes = 256;
+
+// The expected size of a read from socket.
+const size_t kMinReadSize = 256;
+const size_t kInitialReadSize = 1024;
+const size_t kMaxReadSize = 64*1024;
+
+// The max bytes read by one readable event in edge-triggered mode, the rest 
+// is read by a queued handle_read_more(), so a fast sender can not starve 
+// the other connections of loop.
+const size_t kReadBudget = 256*1024;
+
+const double kDefaultInputShrinkDelay = 10.0;
+
+}	// namespace anonymous
+
 namespace internal
 {
 int shutdown(const SelectableFD& sfd, int how = SHUT_WR)
@@ -56,13 +88,18 @@ TcpConnection::TcpConnection(EventLoop* loop,
 	, peer_addr_(peeraddr)
 	, connect_socket_(std::move(sockfd))
 	, connect_channel_(new Channel(owner_loop_, connect_socket_.get()))
-	, input_buffer_(new NetBuffer())
-	, output_buffer_(new NetBuffer())
+	, input_buffer_(new NetBuffer(NetBuffer::kUnLimitSize, 0))
+	, output_buffer_(new BufferChain())
+	, read_size_(kInitialReadSize)
+	, input_shrink_delay_s_(kDefaultInputShrinkDelay)
 {
 	CHECK(loop);
 
 	LOG(DEBUG) << "TcpConnection::TcpConnection the [" <<  name_ << "] connection of"
 		<< " fd=" << connect_socket_->internal_fd() << " is constructing";
+
+	// The read/write handlers drain the socket until EAGAIN in edge-triggered mode.
+	connect_channel_->set_edge_triggered(owner_loop_->is_edge_triggered());
 }
 
 void TcpConnection::initialize()
@@ -158,16 +195,17 @@ void TcpConnection::send(const StringPiece& buffer)
 {
 	DCHECK(initilize_);
 
-	// Compile-time assignment
-	constexpr void(TcpConnection::*const snd)(const StringPiece&) 
-		= &TcpConnection::send_in_loop;
-
 	if (state_.load(std::memory_order_relaxed) == kConnected) {
-		// FIXME: Please use weak_from_this() since C++17.
-		// FIXME: as_string() is too bad.
-		using containers::make_weak_bind;
-		owner_loop_->run_in_own_loop(
-			make_weak_bind(snd, shared_from_this(), buffer.as_string()));
+		if (owner_loop_->is_in_own_loop()) {
+			// Write directly, the caller still owns the data.
+			send_in_loop(buffer);
+		} else {
+			// The data must be copied once since the caller owns it, then 
+			// the storage is moved into the own loop.
+			NetBuffer copied(NetBuffer::kUnLimitSize, buffer.size());
+			copied.append(buffer);
+			send(&copied);
+		}
 	}
 }
 
@@ -178,17 +216,58 @@ void TcpConnection::send(NetBuffer* buffer)
 	CHECK(buffer);
 
 	// Compile-time assignment
-	constexpr void(TcpConnection::*const snd)(const StringPiece&) 
+	constexpr void(TcpConnection::*const snd)(NetBuffer&) 
 		= &TcpConnection::send_in_loop;
 
 	if (state_.load(std::memory_order_relaxed) == kConnected) {
-		// taken_as_string() function will swap the data.
-		//
-		// FIXME: Please use weak_from_this() since C++17.
-		// FIXME: taken_as_string() is too bad.
-		using containers::make_weak_bind;
-		owner_loop_->run_in_own_loop(
-			make_weak_bind(snd, shared_from_this(), buffer->taken_as_string()));
+		if (owner_loop_->is_in_own_loop()) {
+			send_in_loop(*buffer);
+		} else {
+			// Swap the storage of |buffer| into the functor, no byte copy.
+			NetBuffer taken;
+			taken.swap(*buffer);
+
+			// FIXME: Please use weak_from_this() since C++17.
+			using containers::make_weak_bind;
+			owner_loop_->queue_in_own_loop(
+				make_weak_bind(snd, shared_from_this(), std::move(taken)));
+		}
+	}
+}
+
+void TcpConnection::send(const std::shared_ptr<const NetBuffer>& message)
+{
+	DCHECK(initilize_);
+
+	CHECK(message);
+	send_shared(message, message->to_string_piece());
+}
+
+void TcpConnection::send(const std::shared_ptr<const std::string>& message)
+{
+	DCHECK(initilize_);
+
+	CHECK(message);
+	send_shared(message, *message);
+}
+
+void TcpConnection::send_shared(std::shared_ptr<const void> holder, const StringPiece& data)
+{
+	// Compile-time assignment
+	constexpr void(TcpConnection::*const snd)(const std::shared_ptr<const void>&, 
+		const StringPiece&) = &TcpConnection::send_in_loop;
+
+	if (state_.load(std::memory_order_relaxed) == kConnected) {
+		if (owner_loop_->is_in_own_loop()) {
+			send_in_loop(holder, data);
+		} else {
+			// Only the reference count is increased, no byte copy.
+			//
+			// FIXME: Please use weak_from_this() since C++17.
+			using containers::make_weak_bind;
+			owner_loop_->queue_in_own_loop(
+				make_weak_bind(snd, shared_from_this(), std::move(holder), data));
+		}
 	}
 }
 
@@ -203,53 +282,209 @@ void TcpConnection::send_in_loop(const void* data, size_t len)
 	
 	CHECK(data);
 
-	ssize_t nwrote = 0;
-	size_t remaining = len;
-	bool fault_error = false;
 	if (state_.load(std::memory_order_relaxed) == kDisconnected) {
 		LOG(WARNING) << "TcpConnection::send_in_loop was disconnected, give up writing";
 		return;
 	}
 
+	ssize_t nwrote = write_in_loop(data, len);
+	if (nwrote < 0) {
+		return;
+	}
+
+	size_t remaining = len - nwrote;
+	if (remaining > 0) {
+		check_high_water_mark(remaining);
+
+		// Copy data to output_buffer_ and enable write event.
+		output_buffer_->append(static_cast<const char*>(data) + nwrote, remaining);
+		if (!corked_ && !connect_channel_->is_write_event()) {
+			connect_channel_->enable_write_event();
+		}
+	}
+}
+
+void TcpConnection::send_in_loop(NetBuffer& buffer)
+{
+	owner_loop_->check_in_own_loop();
+
+	if (buffer.readable_bytes() <= kCoalesceBytes) {
+		send_in_loop(buffer.begin_read(), buffer.readable_bytes());
+		buffer.has_read_all();
+		return;
+	}
+
+	if (state_.load(std::memory_order_relaxed) == kDisconnected) {
+		LOG(WARNING) << "TcpConnection::send_in_loop was disconnected, give up writing";
+		return;
+	}
+
+	ssize_t nwrote = write_in_loop(buffer.begin_read(), buffer.readable_bytes());
+	if (nwrote < 0) {
+		return;
+	}
+
+	buffer.has_read(nwrote);
+	if (buffer.readable_bytes() > 0) {
+		check_high_water_mark(buffer.readable_bytes());
+
+		// Move the storage of remaining data into output_buffer_ rather 
+		// than copying, and enable write event.
+		output_buffer_->append(std::move(buffer));
+		if (!corked_ && !connect_channel_->is_write_event()) {
+			connect_channel_->enable_write_event();
+		}
+	}
+}
+
+void TcpConnection::send_in_loop(const std::shared_ptr<const void>& holder, 
+								 const StringPiece& data)
+{
+	owner_loop_->check_in_own_loop();
+
+	if (state_.load(std::memory_order_relaxed) == kDisconnected) {
+		LOG(WARNING) << "TcpConnection::send_in_loop was disconnected, give up writing";
+		return;
+	}
+
+	ssize_t nwrote = write_in_loop(data.data(), data.size());
+	if (nwrote < 0) {
+		return;
+	}
+
+	size_t remaining = data.size() - nwrote;
+	if (remaining > 0) {
+		check_high_water_mark(remaining);
+
+		// Share the remaining data in output_buffer_ and enable write event.
+		output_buffer_->append(holder, StringPiece(data.data() + nwrote, remaining));
+		if (!corked_ && !connect_channel_->is_write_event()) {
+			connect_channel_->enable_write_event();
+		}
+	}
+}
+
+ssize_t TcpConnection::write_in_loop(const void* data, size_t len)
+{
 	// If no thing in output buffer, try writing directly.
-	if (!connect_channel_->is_write_event() && output_buffer_->readable_bytes() == 0) {
-		nwrote = connect_socket_->write(data, len);
-		if (nwrote >= 0) {
-			remaining = len - nwrote;
-			if (remaining == 0 && write_complete_cb_) {
-				// Call the user write complete callback. Async callback.
-				owner_loop_->queue_in_own_loop(
-					std::bind(write_complete_cb_, shared_from_this()));
-			}
-		} else {
-			// Write failed.
-			nwrote = 0;
-			if (errno != EAGAIN && errno != EWOULDBLOCK) {
-				PLOG(ERROR) << "TcpConnection::send_in_loop has failed";
-				if (errno == EPIPE || errno == ECONNRESET) {
-					// The peer endpoint has closed.
-					fault_error = true;
-				}
+	// The corked bytes are queued, until uncork().
+	if (corked_ || connect_channel_->is_write_event() || 
+		output_buffer_->readable_bytes() > 0)
+	{
+		return 0;
+	}
+
+	ssize_t nwrote = connect_socket_->write(data, len);
+	if (nwrote >= 0) {
+		if (static_cast<size_t>(nwrote) == len && write_complete_cb_) {
+			// Call the user write complete callback. Async callback.
+			owner_loop_->queue_in_own_loop(
+				std::bind(write_complete_cb_, shared_from_this()));
+		}
+	} else {
+		// Write failed.
+		nwrote = 0;
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			PLOG(ERROR) << "TcpConnection::write_in_loop has failed";
+			if (errno == EPIPE || errno == ECONNRESET) {
+				// The peer endpoint has closed.
+				nwrote = -1;
 			}
 		}
 	}
+	return nwrote;
+}
 
-	DCHECK(remaining <= len);
-	if (!fault_error && remaining > 0) {
-		size_t history = output_buffer_->readable_bytes();
-		if (history + remaining >= high_water_mark_ && history < high_water_mark_ 
-			&& high_water_mark_cb_)
-		{
-			// Call the user high watermark callback. Async callback.
-			owner_loop_->queue_in_own_loop(
-				std::bind(high_water_mark_cb_, shared_from_this(), history + remaining));
+void TcpConnection::check_high_water_mark(size_t remaining)
+{
+	size_t history = output_buffer_->readable_bytes();
+	if (history + remaining >= high_water_mark_ && history < high_water_mark_ 
+		&& high_water_mark_cb_)
+	{
+		// Call the user high watermark callback. Async callback.
+		owner_loop_->queue_in_own_loop(
+			std::bind(high_water_mark_cb_, shared_from_this(), history + remaining));
+	}
+}
+
+void TcpConnection::cork()
+{
+	DCHECK(initilize_);
+
+	owner_loop_->check_in_own_loop();
+	corked_++;
+}
+
+void TcpConnection::uncork()
+{
+	DCHECK(initilize_);
+
+	owner_loop_->check_in_own_loop();
+	DCHECK(corked_ > 0);
+
+	if (--corked_ == 0) {
+		flush_in_loop();
+	}
+}
+
+void TcpConnection::flush_in_loop()
+{
+	// The writable event will flush it.
+	if (connect_channel_->is_write_event() || output_buffer_->readable_bytes() == 0) {
+		return;
+	}
+	if (state_.load(std::memory_order_relaxed) == kDisconnected) {
+		LOG(WARNING) << "TcpConnection::flush_in_loop was disconnected, give up writing";
+		return;
+	}
+
+	drain_output(true);
+}
+
+void TcpConnection::drain_output(bool until_eagain)
+{
+	// Flush the output chain by writev(2), at most kMaxIovecs segments once.
+	struct iovec iov[kMaxIovecs];
+	ssize_t n = 0;
+	do {
+		int iovcnt = output_buffer_->peek_iovec(iov, kMaxIovecs);
+		n = sockets::writev(connect_socket_->internal_fd(), iov, iovcnt);
+		if (n > 0) {
+			output_buffer_->has_read(n);
+		}
+	} while (n > 0 && output_buffer_->readable_bytes() > 0 && until_eagain);
+
+	if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+		PLOG(ERROR) << "TcpConnection::drain_output has failed";
+		if (errno == EPIPE || errno == ECONNRESET) {
+			// The peer endpoint has closed, it is closed by the readable 
+			// (or hangup) event. Stop the busy loop of writable event.
+			if (connect_channel_->is_write_event()) {
+				connect_channel_->disable_write_event();
+			}
+			return;
 		}
+	}
 
-		// FIXME: Copy data to output_buffer_ and enable write event.
-		output_buffer_->append(static_cast<const char*>(data) + nwrote, remaining);
+	if (output_buffer_->readable_bytes() > 0) {
 		if (!connect_channel_->is_write_event()) {
 			connect_channel_->enable_write_event();
 		}
+	} else {
+		// Disable the writable event. Otherwise the file descriptor will 
+		// have a busy loop with writable event.
+		if (connect_channel_->is_write_event()) {
+			connect_channel_->disable_write_event();
+		}
+		if (write_complete_cb_) {
+			// Call the user write complete callback. Async callback.
+			owner_loop_->queue_in_own_loop(
+				std::bind(write_complete_cb_, shared_from_this()));
+		}
+		if (state_.load(std::memory_order_relaxed) == kDisconnecting) {
+			// After the output buffer is sent, then handling shutdown.
+			shutdown_in_loop();
+		}
 	}
 }
 
@@ -273,8 +508,8 @@ void TcpConnection::shutdown_in_loop()
 {
 	owner_loop_->check_in_own_loop();
 	
-	// There is still data not sent completely.
-	if (!connect_channel_->is_write_event()) {
+	// There is still data not sent completely (or be corked).
+	if (!connect_channel_->is_write_event() && output_buffer_->readable_bytes() == 0) {
 		// Close write channel.
 		internal::shutdown(*connect_socket_);
 	}
@@ -441,18 +676,59 @@ void TcpConnection::handle_read(TimeStamp received_ms)
 
 	ScopedClearLastError last_error;
 
-	// Wrapper the ::read() system call.
-	ssize_t n = input_buffer_->read_fd(connect_socket_->internal_fd());
-	if (n > 0) {
+	// Wrapper the ::readv() system call.
+	// In edge-triggered mode (or read_until_eagain_), keep reading until 
+	// EAGAIN (or EOF) or the read budget. In edge-triggered mode, there will
+	// be no more readable event of the remaining bytes.
+	int saved_errno = 0;
+	ssize_t n = 0, total = 0;
+	bool more = false;
+	do {
+		// Reserve the expected size, the rest is read into the spill buffer.
+		input_buffer_->ensure_writable_bytes(read_size_);
+
+		n = input_buffer_->read_fd(connect_socket_->internal_fd(), &saved_errno, 
+				owner_loop_->spill_buffer(), EventLoop::kSpillBufferSize);
+		if (n > 0) {
+			total += n;
+			adjust_read_size(static_cast<size_t>(n));
+		}
+		more = n > 0 && (connect_channel_->is_edge_triggered() || read_until_eagain_);
+	} while (more && static_cast<size_t>(total) < kReadBudget);
+
+	if (more && connect_channel_->is_edge_triggered()) {
+		// The budget is exhausted, read the rest after the other events.
+		using containers::make_weak_bind;
+		owner_loop_->queue_in_own_loop(
+			make_weak_bind(&TcpConnection::handle_read_more, shared_from_this()));
+	}
+
+	if (total > 0) {
+		last_read_ms_ = received_ms;
+
 		// Call the user message callback.
 		message_cb_(shared_from_this(), input_buffer_.get(), received_ms);
-	} else if (n == 0) {
+
+		// The idle input buffer will be released.
+		if (input_shrink_delay_s_ > 0 && !input_shrink_pending_ && 
+			input_buffer_->readable_bytes() == 0)
+		{
+			input_shrink_pending_ = true;
+			
+			using containers::make_weak_bind;
+			owner_loop_->run_after(input_shrink_delay_s_, 
+				make_weak_bind(&TcpConnection::shrink_input_buffer, shared_from_this()));
+		}
+	}
+
+	if (n == 0) {
 		LOG(DEBUG) << "TcpConnection::handle_read the conntion fd=" 
 			<< connect_socket_->internal_fd() 
 			<< " is going to closing";
 
 		handle_close();
-	} else {
+	} else if (n < 0 && saved_errno != EAGAIN && saved_errno != EWOULDBLOCK) {
+		errno = saved_errno;
 		PLOG(ERROR) << "TcpConnection::handle_read the conntion fd=" 
 			<< connect_socket_->internal_fd() 
 			<< " has been occurred error";
@@ -460,33 +736,70 @@ void TcpConnection::handle_read(TimeStamp received_ms)
 	}
 }
 
+void TcpConnection::handle_read_more()
+{
+	// The connection was closed, or the reading was stopped (start_read() 
+	// re-arms the edge).
+	if (state_.load(std::memory_order_relaxed) == kDisconnected || 
+		!connect_channel_->is_read_event())
+	{
+		return;
+	}
+	handle_read(TimeStamp::now());
+}
+
+void TcpConnection::adjust_read_size(size_t n)
+{
+	if (n >= read_size_) {
+		read_size_ = std::min(read_size_ * 2, kMaxReadSize);
+		read_shrinking_ = false;
+	} else if (n < read_size_ / 2 && read_size_ > kMinReadSize) {
+		// Halve it after two small reads in a row.
+		if (read_shrinking_) {
+			read_size_ = std::max(read_size_ / 2, kMinReadSize);
+		}
+		read_shrinking_ = !read_shrinking_;
+	} else {
+		read_shrinking_ = false;
+	}
+}
+
+void TcpConnection::shrink_input_buffer()
+{
+	owner_loop_->check_in_own_loop();
+
+	input_shrink_pending_ = false;
+	if (state_.load(std::memory_order_relaxed) != kConnected || 
+		input_buffer_->readable_bytes() > 0)
+	{
+		return;
+	}
+
+	// Read again since the timer was added, wait for the rest of delay.
+	TimeDelta idle = owner_loop_->loop_time() - last_read_ms_;
+	TimeDelta delay = TimeDelta::from_seconds_d(input_shrink_delay_s_);
+	if (idle < delay) {
+		input_shrink_pending_ = true;
+
+		using containers::make_weak_bind;
+		owner_loop_->run_after(delay - idle, 
+			make_weak_bind(&TcpConnection::shrink_input_buffer, shared_from_this()));
+		return;
+	}
+
+	input_buffer_->shrink();
+	read_size_ = kInitialReadSize;
+	read_shrinking_ = false;
+}
+
 void TcpConnection::handle_write()
 {
 	owner_loop_->check_in_own_loop();
 
 	if (connect_channel_->is_write_event()) {
-		ssize_t n = connect_socket_->write(output_buffer_->begin_read(),
-										   output_buffer_->readable_bytes());
-		if (n > 0) {
-			output_buffer_->has_read(n);
-			if (output_buffer_->readable_bytes() == 0) {
-				// Disable the writable event. Otherwise the file descriptor will 
-				// have a busy loop with writable event.
-				connect_channel_->disable_write_event();
-
-				if (write_complete_cb_) {
-					// Call the user write complete callback. Async callback.
-					owner_loop_->queue_in_own_loop(
-						std::bind(write_complete_cb_, shared_from_this()));
-				}
-				if (state_.load(std::memory_order_relaxed) == kDisconnecting) {
-					// After the output buffer is sent, then handling shutdown.
-					shutdown_in_loop();
-				}
-			}
-		} else {
-			PLOG(ERROR) << "TcpConnection::handle_write has failed";
-		}
+		// In edge-triggered mode, keep writing until the output buffer is 
+		// empty or EAGAIN.
+		drain_output(connect_channel_->is_edge_triggered());
 	} else {
 		LOG(DEBUG) << "TcpConnection::handle_write the conntion fd=" 
 			<< connect_socket_->internal_fd()
@@ -12,6 +12,7 @@
 #include "EventLoopPool.h"
 #include "strings/StringPrintf.h"
 #include "containers/Bind.h"
+#include "synchronization/CountDownLatch.h"
 
 #include <utility>
 
@@ -25,6 +26,13 @@ static struct sockaddr_in6 get_local_addr(const SelectableFD& sfd)
 	return sockets::get_local_addr(sfd.internal_fd());
 }
 
+static void connect_established(const std::vector<TcpConnectionPtr>& conns)
+{
+	for (const TcpConnectionPtr& conn : conns) {
+		conn->connect_established();
+	}
+}
+
 }	// namespace internal
 
 TcpServer::TcpServer(EventLoop* loop, 
@@ -35,6 +43,8 @@ TcpServer::TcpServer(EventLoop* loop,
 	: owner_loop_(loop)
 	, name_(name)
 	, ip_port_(addr.to_ip_port())
+	, listen_addr_(addr)
+	, nodelay_(nodelay)
 	, acceptor_(new Acceptor(loop, addr, reuseport, nodelay))
 	, workers_(new EventLoopPool(loop, name))
 	, connect_cb_(default_connect_callback)
@@ -51,30 +61,32 @@ void TcpServer::initialize()
 {
 	DCHECK(!initilize_);
 	initilize_ = true;
-
-	// FIXME: Please use weak_from_this() since C++17.
-	// Must use weak bind. Otherwise, there is a circular reference problem 
-	// of smart pointer (`acceptor_` storages this shared_ptr).
-	// 1. but the server instance usually do not need to be destroyed.
-	// 2. make_weak_bind() is not good for right-value yet.
-	using std::placeholders::_1;
-	using std::placeholders::_2;
-	acceptor_->set_new_connect_callback(
-		std::bind(&TcpServer::new_connection, this, _1, _2)); // not safe
 }
 
+TcpServer::Shard::Shard(EventLoop* l, std::unique_ptr<Acceptor> a)
+	: loop(l)
+	, acceptor(std::move(a)) {}
+
+TcpServer::Shard::~Shard() = default;
+
 TcpServer::~TcpServer()
 {
 	DCHECK(initilize_);
 
 	owner_loop_->check_in_own_loop();
 
-	// Destroy all client connections.
-	for (auto& item : connections_) {
-		TcpConnectionPtr conn(item.second);
-		item.second.reset();
-		conn->get_owner_loop()->run_in_own_loop(
-			std::bind(&TcpConnection::connect_destroyed, conn));
+	// Destroy the acceptors and all client connections in their own loop.
+	for (auto& shard : shards_) {
+		if (shard->loop == owner_loop_) {
+			destroy_shard(shard.get());
+		} else {
+			CountDownLatch latch(1);
+			shard->loop->run_in_own_loop([this, &shard, &latch]() {
+				destroy_shard(shard.get());
+				latch.count_down();
+			});
+			latch.wait();
+		}
 	}
 
 	LOG(DEBUG) << "TcpServer::~TcpServer [" << name_ 
@@ -89,6 +101,57 @@ void TcpServer::set_thread_num(int num_threads)
 	workers_->set_thread_num(num_threads);
 }
 
+void TcpServer::set_multi_acceptor(bool on)
+{
+	DCHECK(initilize_);
+	DCHECK(!workers_->started());
+
+	multi_acceptor_ = on;
+}
+
+void TcpServer::set_accept_batch(int batch)
+{
+	DCHECK(initilize_);
+	DCHECK(!workers_->started());
+
+	accept_batch_ = batch;
+}
+
+int64_t TcpServer::accepted_count() const
+{
+	AutoLock locked(shards_lock_);
+	int64_t count = 0;
+	for (const auto& shard : shards_) {
+		count += shard->accepted + (shard->acceptor? shard->acceptor->accepted_count(): 0);
+	}
+	return count;
+}
+
+int64_t TcpServer::rejected_count() const
+{
+	AutoLock locked(shards_lock_);
+	int64_t count = 0;
+	for (const auto& shard : shards_) {
+		count += shard->rejected + (shard->acceptor? shard->acceptor->rejected_count(): 0);
+	}
+	return count;
+}
+
+int64_t TcpServer::emfile_count() const
+{
+	AutoLock locked(shards_lock_);
+	int64_t count = 0;
+	for (const auto& shard : shards_) {
+		count += shard->emfile + (shard->acceptor? shard->acceptor->emfile_count(): 0);
+	}
+	return count;
+}
+
+std::vector<EventLoop*> TcpServer::get_all_loops() const
+{
+	return workers_->get_all_loops();
+}
+
 void TcpServer::listen()
 {
 	DCHECK(initilize_);
@@ -97,23 +160,64 @@ void TcpServer::listen()
 		// Starting all event loop thread pool.
 		workers_->start(thread_init_cb_);
 
-		// Setting listening socket in current thread.
-		DCHECK(!acceptor_->is_listen());
-		acceptor_->listen();
+		{
+			// The metrics read the shards in any thread.
+			AutoLock locked(shards_lock_);
+			if (!multi_acceptor_) {
+				shards_.emplace_back(new Shard(owner_loop_, std::move(acceptor_)));
+			} else {
+				std::vector<EventLoop*> loops = workers_->get_all_loops();
+				if (loops.size() != 1 || loops[0] != owner_loop_) {
+					// Close the listen socket of the owner loop, and bind again
+					// with SO_REUSEPORT on every worker loop.
+					acceptor_.reset();
+				}
+				for (EventLoop* loop : loops) {
+					std::unique_ptr<Acceptor> acceptor(std::move(acceptor_));
+					if (!acceptor) {
+						acceptor.reset(new Acceptor(loop, listen_addr_, true, nodelay_));
+					}
+					shards_.emplace_back(new Shard(loop, std::move(acceptor)));
+				}
+			}
+		}
+
+		// FIXME: Please use weak_from_this() since C++17.
+		// Must use weak bind. Otherwise, there is a circular reference problem 
+		// of smart pointer (`acceptor` storages this shared_ptr).
+		// 1. but the server instance usually do not need to be destroyed.
+		// 2. make_weak_bind() is not good for right-value yet.
+		using std::placeholders::_1;
+		using std::placeholders::_2;
+		for (auto& shard : shards_) {
+			Acceptor* acceptor = shard->acceptor.get();
+			acceptor->set_new_connect_callback(
+				std::bind(&TcpServer::new_connection, this, shard.get(), _1, _2)); // not safe
+			acceptor->set_accept_batch_callback(
+				std::bind(&TcpServer::establish_connections, this, shard.get())); // not safe
+			if (accept_batch_ > 0) {
+				acceptor->set_accept_batch(accept_batch_);
+			}
+
+			// Setting listening socket in the accepting loop thread.
+			DCHECK(!acceptor->is_listen());
+			shard->loop->run_in_own_loop(std::bind(&Acceptor::listen, acceptor));
+		}
 	}
 }
 
-void TcpServer::new_connection(SelectableFDPtr&& peerfd, const EndPoint& peeraddr)
+void TcpServer::new_connection(Shard* shard, SelectableFDPtr&& peerfd, const EndPoint& peeraddr)
 {
-	owner_loop_->check_in_own_loop();
+	shard->loop->check_in_own_loop();
 
-	// Get one EventLoop thread for NIO.
-	EventLoop* worker = workers_->get_next_loop();
+	// Get one EventLoop thread for NIO, or keep it in the accepting loop.
+	EventLoop* worker = multi_acceptor_? shard->loop: workers_->get_next_loop();
 
 	EndPoint localaddr(internal::get_local_addr(*peerfd));
 
+	int conn_id = next_conn_id_.fetch_add(1, std::memory_order_relaxed);
 	std::string name = name_ + string_printf("#%s#%d", 
-								ip_port_.c_str(), next_conn_id_++);
+								ip_port_.c_str(), conn_id);
 
 	LOG(INFO) << "TcpServer::new_connection [" << name_
 		<< "] accept new connection [" << name
@@ -137,33 +241,58 @@ void TcpServer::new_connection(SelectableFDPtr&& peerfd, const EndPoint& peeradd
 	using containers::_1;
 	using containers::make_weak_bind;
 	conn->set_finish_callback(
-			make_weak_bind(&TcpServer::remove_connection, shared_from_this(), _1));
+			make_weak_bind(&TcpServer::remove_connection, shared_from_this(), shard, _1));
 
 	// Storages all client connections.
-	connections_[name] = conn;
-	
+	shard->connections[name] = conn;
+
+	// Established at the end of the accepting batch.
+	shard->pending.push_back(std::move(conn));
+}
+
+void TcpServer::establish_connections(Shard* shard)
+{
+	shard->loop->check_in_own_loop();
+
+	// Group the connections of batch by their loops.
+	std::vector<std::pair<EventLoop*, std::vector<TcpConnectionPtr>>> groups;
+	for (TcpConnectionPtr& conn : shard->pending) {
+		EventLoop* worker = conn->get_owner_loop();
+		auto it = groups.begin();
+		while (it != groups.end() && it->first != worker) {
+			++it;
+		}
+		if (it == groups.end()) {
+			groups.emplace_back(worker, std::vector<TcpConnectionPtr>());
+			it = groups.end() - 1;
+		}
+		it->second.push_back(std::move(conn));
+	}
+	shard->pending.clear();
+
 	// Run in the `conn` own loop, because `server` and `conn` may not be the 
 	// same thread. --- the `server` thread call this.
-	// The `conn` will be copied by std::bind(). So conn.use_count() will 
-	// become 3.
-	worker->run_in_own_loop(
-		std::bind(&TcpConnection::connect_established, conn));
+	// The `conns` will be moved into the functor, one post per worker.
+	for (auto& group : groups) {
+		group.first->run_in_own_loop(
+			std::bind(&internal::connect_established, std::move(group.second)));
+	}
 }
 
-void TcpServer::remove_connection(const TcpConnectionPtr& conn)
+void TcpServer::remove_connection(Shard* shard, const TcpConnectionPtr& conn)
 {
-	// Run in the `server` own loop, because `conn` and `server` may not be 
+	// Run in the `shard` own loop, because `conn` and `shard` may not be 
 	// the same thread. --- the `conn` thread call this.
 	// The `conn` will be copied by std::bind(). So conn.use_count() will 
 	// become 4.
 	using containers::make_weak_bind;
-	owner_loop_->run_in_own_loop(
-		make_weak_bind(&TcpServer::remove_connection_in_loop, shared_from_this(), conn));
+	shard->loop->run_in_own_loop(
+		make_weak_bind(&TcpServer::remove_connection_in_loop, shared_from_this(), shard, conn));
 }
 
-void TcpServer::remove_connection_in_loop(const TcpConnectionPtr& conn)
+void TcpServer::remove_connection_in_loop(Shard* shard, const TcpConnectionPtr& conn)
 {
-	owner_loop_->check_in_own_loop();
+	shard->loop->check_in_own_loop();
 
 	LOG(INFO) << "TcpServer::remove_connection_in_loop [" << name_
 		<< "] remove the connection [" << conn->name() << "]";
@@ -171,7 +300,7 @@ void TcpServer::remove_connection_in_loop(const TcpConnectionPtr& conn)
 	// conn.use_count() now is 2, after erase will become 1.
 	// conn +1
 	// ConnectionMap +1
-	size_t n = connections_.erase(conn->name());
+	size_t n = shard->connections.erase(conn->name());
 	DCHECK(n == 1);
 
 	// Can't remove `conn` here immediately, because we are inside channel's 
@@ -183,6 +312,31 @@ void TcpServer::remove_connection_in_loop(const TcpConnectionPtr& conn)
 		std::bind(&TcpConnection::connect_destroyed, conn));
 }
 
+void TcpServer::destroy_shard(Shard* shard)
+{
+	shard->loop->check_in_own_loop();
+
+	{
+		// Keep the metrics of the acceptor.
+		AutoLock locked(shards_lock_);
+		if (shard->acceptor) {
+			shard->accepted += shard->acceptor->accepted_count();
+			shard->rejected += shard->acceptor->rejected_count();
+			shard->emfile += shard->acceptor->emfile_count();
+			shard->acceptor.reset();
+		}
+	}
+
+	// Destroy all client connections.
+	for (auto& item : shard->connections) {
+		TcpConnectionPtr conn(item.second);
+		item.second.reset();
+		conn->get_owner_loop()->run_in_own_loop(
+			std::bind(&TcpConnection::connect_destroyed, conn));
+	}
+	shard->connections.clear();
+}
+
 // Constructs an object of type TcpServerPtr and wraps it.
 TcpServerPtr make_tcp_server(EventLoop* loop, 
 	const EndPoint& addr, 
@@ -6,6 +6,7 @@
 #include "Exceptions.h"
 
 #include <string>
+#include <utility>
 #include <functional>
 
 namespace annety
@@ -86,6 +87,12 @@ size_t ThreadPool::get_task_size() const
 	return thread_main_cbs_.size();
 }
 
+bool ThreadPool::running() const
+{
+	AutoLock locked(lock_);
+	return running_;
+}
+
 bool ThreadPool::full() const
 {
 	lock_.assert_acquired();
@@ -117,6 +124,28 @@ void ThreadPool::run_task(const TaskCallback& cb, int repeat_count)
 	}
 }
 
+bool ThreadPool::try_run_task(TaskCallback&& cb)
+{
+	DCHECK(running_) 
+		<< "ThreadPool::try_run_task is calling with no outstanding threads";
+
+	if (threads_.empty()) {
+		TaskCallback task(std::move(cb));
+		if (task) {
+			task();
+		}
+		return true;
+	}
+
+	AutoLock locked(lock_);
+	if (full()) {
+		return false;
+	}
+	thread_main_cbs_.push_back(std::move(cb));
+	empty_cv_.signal();
+	return true;
+}
+
 void ThreadPool::loop()
 {
 	try {
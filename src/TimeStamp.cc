@@ -37,6 +37,13 @@ TimeStamp TimeNowIgnoreTZ()
 					tv.tv_sec * TimeStamp::kMicrosecondsPerSecond + 
 					tv.tv_usec);
 }
+int64_t clock_now_us(clockid_t clock)
+{
+	struct timespec ts;
+	CHECK(::clock_gettime(clock, &ts) == 0);
+	return ts.tv_sec * TimeStamp::kMicrosecondsPerSecond + 
+			ts.tv_nsec / TimeStamp::kNanosecondsPerMicrosecond;
+}
 }	// namespace anonymous
 
 // TimeZone ------------------------------------------------------------------
@@ -114,6 +121,26 @@ TimeStamp TimeStamp::now()
 	return TimeNowIgnoreTZ();
 }
 
+// static
+TimeStamp TimeStamp::now_coarse()
+{
+#if defined(CLOCK_REALTIME_COARSE)
+	return TimeStamp(clock_now_us(CLOCK_REALTIME_COARSE));
+#else
+	return TimeNowIgnoreTZ();
+#endif
+}
+
+// static
+TimeStamp TimeStamp::now_monotonic()
+{
+	// The offset from the monotonic clock to the UTC time, at the first call.
+	static const int64_t offset_us = 
+		TimeNowIgnoreTZ().us_ - clock_now_us(CLOCK_MONOTONIC);
+
+	return TimeStamp(clock_now_us(CLOCK_MONOTONIC) + offset_us);
+}
+
 // static
 TimeStamp TimeStamp::from_time_t(const time_t& tt)
 {
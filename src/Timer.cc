@@ -31,6 +31,14 @@ Timer::~Timer()
 		<<  ", expired:" << expired_ <<"] is destructing";
 }
 
+void Timer::reuse(TimerCallback cb, TimeStamp expired, TimeDelta interval)
+{
+	expired_ = expired;
+	interval_ = interval;
+	cb_ = std::move(cb);
+	sequence_ = globalSequence++;
+}
+
 void Timer::restart(TimeStamp curr)
 {
 	if (repeat()) {
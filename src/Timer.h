@@ -30,11 +30,24 @@ public:
 	void restart(TimeStamp curr);
 	void run() const { cb_();}
 
+	// Reuse the timer with a new sequence, the old TimerId is invalid.
+	void reuse(TimerCallback cb, TimeStamp expired, TimeDelta interval);
+
+	// Release the resources held by the callback.
+	void release() { cb_ = nullptr;}
+
 private:
+	friend class WheelTimerPool;
+
 	TimeStamp expired_;
-	const TimeDelta interval_;
-	const TimerCallback cb_;
-	const int64_t sequence_;
+	TimeDelta interval_;
+	TimerCallback cb_;
+	int64_t sequence_;
+
+	// Intrusive list node of WheelTimerPool, O(1) cancel.
+	Timer* prev_{nullptr};
+	Timer* next_{nullptr};
+	int slot_{-1};
 
 	DISALLOW_COPY_AND_ASSIGN(Timer);
 };
@@ -6,12 +6,14 @@
 #include "EventLoop.h"
 #include "Channel.h"
 #include "TimerFD.h"
-#include "Timer.h"
-
-#include <algorithm>
 
 namespace annety
 {
+namespace {
+// The `timerfd` is disarmed when the delta is zero, wake up a little later.
+const TimeDelta kMinResetDelta = TimeDelta::from_microseconds(100);
+}	// namespace anonymous
+
 TimerPool::TimerPool(EventLoop* loop)
 	: owner_loop_(loop)
 	, timer_socket_(new TimerFD(true, true))
@@ -35,87 +37,13 @@ TimerPool::~TimerPool()
 
 	timer_channel_->disable_all_event();
 	timer_channel_->remove();
-
-	for (const EntryTimer& timer : timers_) {
-		// FIXME: no delete when smart point
-		delete timer.second;
-	}
-}
-
-TimerId TimerPool::add_timer(TimerCallback cb, TimeStamp expired, double interval_s)
-{
-	Timer* timer = new Timer(std::move(cb), expired, TimeDelta::from_seconds_d(interval_s));
-	
-	owner_loop_->run_in_own_loop(
-		std::bind(&TimerPool::add_timer_in_own_loop, this, timer));
-	
-	return TimerId(timer, timer->sequence());
-}
-
-void TimerPool::cancel_timer(TimerId timer_id)
-{
-	owner_loop_->run_in_own_loop(
-		std::bind(&TimerPool::cancel_timer_in_own_loop, this, timer_id));
-}
-
-void TimerPool::add_timer_in_own_loop(Timer* timer)
-{
-	owner_loop_->check_in_own_loop();
-	DCHECK(timers_.size() == active_timers_.size());
-
-	// Save the timer
-	bool earliest_changed = save(timer);
-
-	// If there is a earliest expiration timer, reset the `timerfd` 
-	// expiration time.
-	if (earliest_changed) {
-		reset(timer->expired());
-	}
-}
-
-void TimerPool::cancel_timer_in_own_loop(TimerId timer_id)
-{
-	owner_loop_->check_in_own_loop();
-	DCHECK(timers_.size() == active_timers_.size());
-
-	ActiveTimer timer(timer_id.timer_, timer_id.sequence_);
-	ActiveTimerSet::iterator it = active_timers_.find(timer);
-	if (it != active_timers_.end()) {
-		// erase from timers_		
-		{
-			size_t n = timers_.erase(EntryTimer(it->first->expired(), it->first));
-			DCHECK(n == 1);
-			// FIXME: no delete when smart point
-			delete it->first;
-		}
-
-		// erase from active_timers_
-		{
-			active_timers_.erase(it);
-		}
-	} else if (calling_expired_timers_) {
-		// Timer specified by timer_id maybe is calling now.
-		// Insert the timer to canceling timers queue.
-		canceling_timers_.insert(timer);
-	}
-	
-	DLOG(TRACE) << "TimerPool::cancel_timer_in_own_loop " << (it != active_timers_.end());
-	DCHECK(timers_.size() == active_timers_.size());
-
-	// reset the `timerfd` expiration time.
-	if (!timers_.empty()) {
-		reset(timers_.begin()->second->expired());
-	} else {
-		reset(TimeStamp());
-	}
 }
 
 void TimerPool::handle_read()
 {
 	owner_loop_->check_in_own_loop();
-	DCHECK(timers_.size() == active_timers_.size());
 
-	TimeStamp curr = TimeStamp::now();
+	TimeStamp curr = TimeStamp::now_monotonic();
 	{
 		// On Linux platform, kernel will write an unsigned 8-byte integer (uint64_t) 
 		// containing the number of expirations that have occurred.
@@ -129,75 +57,8 @@ void TimerPool::handle_read()
 		DLOG(TRACE) << "TimerPool::handle_read " << one << " at " << curr;
 	}
 
-	// Fill the expired timers list and call timer callback.
-	{
-		EntryTimerList expired_timers;
-		fill_expired_timers(curr, expired_timers);
-
-		calling_expired_timers_ = true;
-		canceling_timers_.clear();
-
-		// safe to callback outside critical section
-		for (const EntryTimer& it : expired_timers) {
-			it.second->run();
-		}
-		calling_expired_timers_ = false;
-
-		// delete or reset expired, such as interval timers.
-		update(curr, expired_timers);
-	}
-}
-
-void TimerPool::fill_expired_timers(TimeStamp time, EntryTimerList& expired_timers)
-{
-	owner_loop_->check_in_own_loop();
-	DCHECK(timers_.size() == active_timers_.size());
-
-	EntryTimer sentry(time, reinterpret_cast<Timer*>(UINTPTR_MAX));
-	EntryTimerSet::iterator it = timers_.lower_bound(sentry);
-	DCHECK(it == timers_.end() || it->first > time);
-
-	// Get and erase expired-timers from timers_ container
-	std::copy(timers_.begin(), it, std::back_inserter(expired_timers));
-	timers_.erase(timers_.begin(), it);
-
-	// Erase expired-timers from active_timers_ container
-	for (const EntryTimer& it : expired_timers) {
-		ActiveTimer timer(it.second, it.second->sequence());
-		size_t n = active_timers_.erase(timer);
-		DCHECK(n == 1);
-	}
-
-	DCHECK(timers_.size() == active_timers_.size());
-}
-
-void TimerPool::update(TimeStamp time, const EntryTimerList& expired_timers)
-{
-	owner_loop_->check_in_own_loop();
-	DCHECK(timers_.size() == active_timers_.size());
-
-	for (const EntryTimer& it : expired_timers) {
-		ActiveTimer timer(it.second, it.second->sequence());
-		if (it.second->repeat() && 
-			canceling_timers_.find(timer) == canceling_timers_.end())
-		{
-			// It is a interval timer, and is not canceling timer.
-			// Timer being cancelled will not be added again.
-			it.second->restart(time);
-			save(it.second);
-		} else {
-			// FIXME: move to a free list
-			// FIXME: no delete when smart point
-			delete it.second;
-		}
-	}
-
-	// reset the `timerfd` expiration time.
-	if (!timers_.empty()) {
-		reset(timers_.begin()->second->expired());
-	} else {
-		reset(TimeStamp());
-	}
+	// Call the expired timers.
+	handle_expired(curr);
 }
 
 #if !defined(OS_LINUX)
@@ -210,10 +71,10 @@ void TimerPool::check_timer(TimeStamp expired)
 void TimerPool::check_timer_in_own_loop(TimeStamp expired)
 {
 	owner_loop_->check_in_own_loop();
-	DCHECK(timers_.size() == active_timers_.size());
 
 	bool have_expired_timer = false;
-	if (!timers_.empty() && timers_.begin()->first <= expired) {
+	TimeStamp earliest = earliest_expired();
+	if (earliest.is_valid() && earliest <= expired) {
 		have_expired_timer = true;
 	}
 	DLOG(TRACE) << "TimerPool::check_timer_in_own_loop " << have_expired_timer;
@@ -242,7 +103,10 @@ void TimerPool::reset(TimeStamp expired)
 	
 	if (expired.is_valid()) {
 		// `delta` is a offset value from current time
-		TimeDelta delta = expired - TimeStamp::now();
+		TimeDelta delta = expired - owner_loop_->loop_monotonic_time();
+		if (delta < kMinResetDelta) {
+			delta = kMinResetDelta;
+		}
 
 #if defined(OS_LINUX)
 		// FIXME: down-cast should use implicit_cast
@@ -265,33 +129,4 @@ void TimerPool::reset(TimeStamp expired)
 	}
 }
 
-bool TimerPool::save(Timer* timer)
-{
-	owner_loop_->check_in_own_loop();
-	DCHECK(timers_.size() == active_timers_.size());
-
-	// Is it the minimum timer (expired).
-	bool earliest_changed = false;
-	if (timers_.empty() || timers_.begin()->first > timer->expired()) {
-		earliest_changed = true;
-	}
-
-	// save to timers_
-	{
-		// std::pair<EntryTimerSet::iterator, bool> result;
-		auto result = timers_.insert(EntryTimer(timer->expired(), timer));
-		DCHECK(result.second);
-	}
-
-	// save to active_timers_
-	{
-		// std::pair<ActiveTimerSet::iterator, bool> result;
-		auto result = active_timers_.insert(ActiveTimer(timer, timer->sequence()));
-		DCHECK(result.second);
-	}
-	DCHECK(timers_.size() == active_timers_.size());
-
-	return earliest_changed;
-}
-
 }	// namespace annety
@@ -9,13 +9,7 @@
 #include "TimerId.h"
 #include "CallbackForward.h"
 
-#include <set>
-#include <vector>
-#include <utility>
-#include <string>
-#include <atomic>
 #include <memory>
-#include <functional>
 
 namespace annety
 {
@@ -24,24 +18,27 @@ class Channel;
 class Timer;
 class TimerId;
 
-// Timer pool, all timers share a `timerfd`.
+// Base class of timer pool, all timers share a `timerfd`.
 // Cannot be sure that the timer callback will be called on time, because 
 // the `timerfd` event may be blocked by other events.
 //
 // We only use the one-shot wakeup of `timerfd`, and the repeat timer will 
 // be reset when the timer timeout.
 //
+// The expired times are on the monotonic clock (TimeStamp::now_monotonic()),
+// the same as the CLOCK_MONOTONIC of `timerfd`.
+//
 // This class owns the SelectableFD and Channel lifetime.
 class TimerPool
 {
 public:
 	explicit TimerPool(EventLoop* loop);
-	~TimerPool();
+	virtual ~TimerPool();
 	
 	// Usually be called from other threads.
 	// *Thread safe*
-	TimerId add_timer(TimerCallback cb, TimeStamp expired, double interval_s);
-	void cancel_timer(TimerId timer_id);
+	virtual TimerId add_timer(TimerCallback cb, TimeStamp expired, double interval_s) = 0;
+	virtual void cancel_timer(TimerId timer_id) = 0;
 
 #if !defined(OS_LINUX)
 	// On non-Linux platforms, Use the traditional poller timeout to implement 
@@ -49,31 +46,25 @@ public:
 	void check_timer(TimeStamp expired);
 #endif
 
-private:
-	// FIXME: use unique_ptr<Timer> instead of raw pointers.
-	// This requires heterogeneous comparison lookup (N3465) from C++14
-
-	// The EntryTimer structure is used to add multiple timers with 
-	// the same expiration time to the std::set.
-	//
-	// Timer list. sorted by expired first, then by pointer address.
-	using EntryTimer = std::pair<TimeStamp, Timer*>;
-	using EntryTimerSet = std::set<EntryTimer>;
-	using EntryTimerList = std::vector<EntryTimer>;
+protected:
+	// Call the expired timers, the `timerfd` has been read.
+	// *Not thread safe*, but run in own loop thread.
+	virtual void handle_expired(TimeStamp curr) = 0;
 
-	// The ActiveTimer structure is used to quickly find a timer from
-	// the std::set using TimerId.
-	//
-	// Active list, sorted by pointer address first, then by sequence. 
-	// for cancel(), the timer fast search.
-	using ActiveTimer = std::pair<Timer*, int64_t>;
-	using ActiveTimerSet = std::set<ActiveTimer>;
+#if !defined(OS_LINUX)
+	// The earliest wakeup time of `timerfd`, invalid if no timer.
+	// *Not thread safe*, but run in own loop thread.
+	virtual TimeStamp earliest_expired() const = 0;
+#endif
 
+	// Reset the `timerfd` expiration time.
 	// *Not thread safe*, but run in own loop thread.
-	void add_timer_in_own_loop(Timer* timer);
-	void cancel_timer_in_own_loop(TimerId timer_id);
+	void reset(TimeStamp expired);
+
+protected:
+	EventLoop* owner_loop_{nullptr};
 
-	void fill_expired_timers(TimeStamp time, EntryTimerList& expired_timers);
+private:
 	void handle_read();
 
 #if !defined(OS_LINUX)
@@ -82,28 +73,11 @@ private:
 	void check_timer_in_own_loop(TimeStamp expired);
 #endif
 	
-	// *Not thread safe*, but run in own loop thread.
-	bool save(Timer* timer);
-	void update(TimeStamp time, const EntryTimerList& expired_timers);
-	void reset(TimeStamp expired);
-
 private:
-	EventLoop* owner_loop_{nullptr};
-	std::atomic<bool> calling_expired_timers_{false};
-
 	SelectableFDPtr timer_socket_;
 	std::unique_ptr<Channel> timer_channel_;
 
-	// Timer list. sorted by expired first, then by pointer address.
-	EntryTimerSet timers_;
-
-	// Active list, sorted by pointer address first, then by sequence. 
-	// for cancel(), the timer fast search.
-	ActiveTimerSet active_timers_;
-
-	// canceling timers.
-	// for cancel()
-	ActiveTimerSet canceling_timers_;
+	DISALLOW_COPY_AND_ASSIGN(TimerPool);
 };
 
 }	// namespace annety
@@ -0,0 +1,202 @@
+// By: wlmwang
+// Date: Jul 05 2019
+
+#include "TreeTimerPool.h"
+#include "Logging.h"
+#include "EventLoop.h"
+#include "Timer.h"
+
+#include <algorithm>
+
+namespace annety
+{
+TreeTimerPool::TreeTimerPool(EventLoop* loop)
+	: TimerPool(loop) {}
+
+TreeTimerPool::~TreeTimerPool()
+{
+	for (const EntryTimer& timer : timers_) {
+		// FIXME: no delete when smart point
+		delete timer.second;
+	}
+}
+
+TimerId TreeTimerPool::add_timer(TimerCallback cb, TimeStamp expired, double interval_s)
+{
+	Timer* timer = new Timer(std::move(cb), expired, TimeDelta::from_seconds_d(interval_s));
+	
+	owner_loop_->run_in_own_loop(
+		std::bind(&TreeTimerPool::add_timer_in_own_loop, this, timer));
+	
+	return TimerId(timer, timer->sequence());
+}
+
+void TreeTimerPool::cancel_timer(TimerId timer_id)
+{
+	owner_loop_->run_in_own_loop(
+		std::bind(&TreeTimerPool::cancel_timer_in_own_loop, this, timer_id));
+}
+
+void TreeTimerPool::add_timer_in_own_loop(Timer* timer)
+{
+	owner_loop_->check_in_own_loop();
+	DCHECK(timers_.size() == active_timers_.size());
+
+	// Save the timer
+	bool earliest_changed = save(timer);
+
+	// If there is a earliest expiration timer, reset the `timerfd` 
+	// expiration time.
+	if (earliest_changed) {
+		reset(timer->expired());
+	}
+}
+
+void TreeTimerPool::cancel_timer_in_own_loop(TimerId timer_id)
+{
+	owner_loop_->check_in_own_loop();
+	DCHECK(timers_.size() == active_timers_.size());
+
+	ActiveTimer timer(timer_id.timer_, timer_id.sequence_);
+	ActiveTimerSet::iterator it = active_timers_.find(timer);
+	if (it != active_timers_.end()) {
+		// erase from timers_		
+		{
+			size_t n = timers_.erase(EntryTimer(it->first->expired(), it->first));
+			DCHECK(n == 1);
+			// FIXME: no delete when smart point
+			delete it->first;
+		}
+
+		// erase from active_timers_
+		{
+			active_timers_.erase(it);
+		}
+	} else if (calling_expired_timers_) {
+		// Timer specified by timer_id maybe is calling now.
+		// Insert the timer to canceling timers queue.
+		canceling_timers_.insert(timer);
+	}
+	
+	DLOG(TRACE) << "TreeTimerPool::cancel_timer_in_own_loop " << (it != active_timers_.end());
+	DCHECK(timers_.size() == active_timers_.size());
+
+	// reset the `timerfd` expiration time.
+	if (!timers_.empty()) {
+		reset(timers_.begin()->second->expired());
+	} else {
+		reset(TimeStamp());
+	}
+}
+
+void TreeTimerPool::handle_expired(TimeStamp curr)
+{
+	owner_loop_->check_in_own_loop();
+	DCHECK(timers_.size() == active_timers_.size());
+
+	// Fill the expired timers list and call timer callback.
+	EntryTimerList expired_timers;
+	fill_expired_timers(curr, expired_timers);
+
+	calling_expired_timers_ = true;
+	canceling_timers_.clear();
+
+	// safe to callback outside critical section
+	for (const EntryTimer& it : expired_timers) {
+		it.second->run();
+	}
+	calling_expired_timers_ = false;
+
+	// delete or reset expired, such as interval timers.
+	update(curr, expired_timers);
+}
+
+void TreeTimerPool::fill_expired_timers(TimeStamp time, EntryTimerList& expired_timers)
+{
+	owner_loop_->check_in_own_loop();
+	DCHECK(timers_.size() == active_timers_.size());
+
+	EntryTimer sentry(time, reinterpret_cast<Timer*>(UINTPTR_MAX));
+	EntryTimerSet::iterator it = timers_.lower_bound(sentry);
+	DCHECK(it == timers_.end() || it->first > time);
+
+	// Get and erase expired-timers from timers_ container
+	std::copy(timers_.begin(), it, std::back_inserter(expired_timers));
+	timers_.erase(timers_.begin(), it);
+
+	// Erase expired-timers from active_timers_ container
+	for (const EntryTimer& it : expired_timers) {
+		ActiveTimer timer(it.second, it.second->sequence());
+		size_t n = active_timers_.erase(timer);
+		DCHECK(n == 1);
+	}
+
+	DCHECK(timers_.size() == active_timers_.size());
+}
+
+void TreeTimerPool::update(TimeStamp time, const EntryTimerList& expired_timers)
+{
+	owner_loop_->check_in_own_loop();
+	DCHECK(timers_.size() == active_timers_.size());
+
+	for (const EntryTimer& it : expired_timers) {
+		ActiveTimer timer(it.second, it.second->sequence());
+		if (it.second->repeat() && 
+			canceling_timers_.find(timer) == canceling_timers_.end())
+		{
+			// It is a interval timer, and is not canceling timer.
+			// Timer being cancelled will not be added again.
+			it.second->restart(time);
+			save(it.second);
+		} else {
+			// FIXME: move to a free list
+			// FIXME: no delete when smart point
+			delete it.second;
+		}
+	}
+
+	// reset the `timerfd` expiration time.
+	if (!timers_.empty()) {
+		reset(timers_.begin()->second->expired());
+	} else {
+		reset(TimeStamp());
+	}
+}
+
+#if !defined(OS_LINUX)
+TimeStamp TreeTimerPool::earliest_expired() const
+{
+	return timers_.empty()? TimeStamp(): timers_.begin()->first;
+}
+#endif	// !defined(OS_LINUX)
+
+bool TreeTimerPool::save(Timer* timer)
+{
+	owner_loop_->check_in_own_loop();
+	DCHECK(timers_.size() == active_timers_.size());
+
+	// Is it the minimum timer (expired).
+	bool earliest_changed = false;
+	if (timers_.empty() || timers_.begin()->first > timer->expired()) {
+		earliest_changed = true;
+	}
+
+	// save to timers_
+	{
+		// std::pair<EntryTimerSet::iterator, bool> result;
+		auto result = timers_.insert(EntryTimer(timer->expired(), timer));
+		DCHECK(result.second);
+	}
+
+	// save to active_timers_
+	{
+		// std::pair<ActiveTimerSet::iterator, bool> result;
+		auto result = active_timers_.insert(ActiveTimer(timer, timer->sequence()));
+		DCHECK(result.second);
+	}
+	DCHECK(timers_.size() == active_timers_.size());
+
+	return earliest_changed;
+}
+
+}	// namespace annety
@@ -0,0 +1,89 @@
+// By: wlmwang
+// Date: Jul 04 2019
+
+#ifndef ANT_TREE_TIMER_POOL_H_
+#define ANT_TREE_TIMER_POOL_H_
+
+#include "Macros.h"
+#include "TimeStamp.h"
+#include "TimerPool.h"
+
+#include <set>
+#include <vector>
+#include <utility>
+#include <atomic>
+
+namespace annety
+{
+// Timer pool of balanced tree (std::set), O(log(N)) insert/cancel.
+//
+// This class does not owns the EventLoop lifetime.
+class TreeTimerPool : public TimerPool
+{
+public:
+	explicit TreeTimerPool(EventLoop* loop);
+	~TreeTimerPool() override;
+
+	// Usually be called from other threads.
+	// *Thread safe*
+	TimerId add_timer(TimerCallback cb, TimeStamp expired, double interval_s) override;
+	void cancel_timer(TimerId timer_id) override;
+
+protected:
+	// *Not thread safe*, but run in own loop thread.
+	void handle_expired(TimeStamp curr) override;
+
+#if !defined(OS_LINUX)
+	TimeStamp earliest_expired() const override;
+#endif
+
+private:
+	// FIXME: use unique_ptr<Timer> instead of raw pointers.
+	// This requires heterogeneous comparison lookup (N3465) from C++14
+
+	// The EntryTimer structure is used to add multiple timers with
+	// the same expiration time to the std::set.
+	//
+	// Timer list. sorted by expired first, then by pointer address.
+	using EntryTimer = std::pair<TimeStamp, Timer*>;
+	using EntryTimerSet = std::set<EntryTimer>;
+	using EntryTimerList = std::vector<EntryTimer>;
+
+	// The ActiveTimer structure is used to quickly find a timer from
+	// the std::set using TimerId.
+	//
+	// Active list, sorted by pointer address first, then by sequence.
+	// for cancel(), the timer fast search.
+	using ActiveTimer = std::pair<Timer*, int64_t>;
+	using ActiveTimerSet = std::set<ActiveTimer>;
+
+	// *Not thread safe*, but run in own loop thread.
+	void add_timer_in_own_loop(Timer* timer);
+	void cancel_timer_in_own_loop(TimerId timer_id);
+
+	void fill_expired_timers(TimeStamp time, EntryTimerList& expired_timers);
+
+	// *Not thread safe*, but run in own loop thread.
+	bool save(Timer* timer);
+	void update(TimeStamp time, const EntryTimerList& expired_timers);
+
+private:
+	std::atomic<bool> calling_expired_timers_{false};
+
+	// Timer list. sorted by expired first, then by pointer address.
+	EntryTimerSet timers_;
+
+	// Active list, sorted by pointer address first, then by sequence.
+	// for cancel(), the timer fast search.
+	ActiveTimerSet active_timers_;
+
+	// canceling timers.
+	// for cancel()
+	ActiveTimerSet canceling_timers_;
+
+	DISALLOW_COPY_AND_ASSIGN(TreeTimerPool);
+};
+
+}	// namespace annety
+
+#endif	// ANT_TREE_TIMER_POOL_H_
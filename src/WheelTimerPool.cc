@@ -0,0 +1,287 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#include "WheelTimerPool.h"
+#include "Logging.h"
+#include "EventLoop.h"
+#include "Timer.h"
+
+#include <utility>
+
+namespace annety
+{
+WheelTimerPool::WheelTimerPool(EventLoop* loop, TimeDelta tick)
+	: TimerPool(loop)
+	, tick_us_(tick.in_microseconds())
+	, slots_(kSlotSize, nullptr)
+{
+	CHECK_GT(tick_us_, 0);
+}
+
+WheelTimerPool::~WheelTimerPool()
+{
+	for (Timer* head : slots_) {
+		while (head) {
+			Timer* next = head->next_;
+			delete head;
+			head = next;
+		}
+	}
+	for (Timer* timer : free_timers_) {
+		delete timer;
+	}
+}
+
+TimerId WheelTimerPool::add_timer(TimerCallback cb, TimeStamp expired, double interval_s)
+{
+	TimeDelta interval = TimeDelta::from_seconds_d(interval_s);
+
+	if (owner_loop_->is_in_own_loop()) {
+		// Reuse the pooled timer node.
+		Timer* timer = nullptr;
+		if (!free_timers_.empty()) {
+			timer = free_timers_.back();
+			free_timers_.pop_back();
+			timer->reuse(std::move(cb), expired, interval);
+		} else {
+			timer = new Timer(std::move(cb), expired, interval);
+		}
+		add_timer_in_own_loop(timer);
+		return TimerId(timer, timer->sequence());
+	}
+
+	Timer* timer = new Timer(std::move(cb), expired, interval);
+	TimerId timer_id(timer, timer->sequence());
+	owner_loop_->queue_in_own_loop(
+		std::bind(&WheelTimerPool::add_timer_in_own_loop, this, timer));
+	return timer_id;
+}
+
+void WheelTimerPool::cancel_timer(TimerId timer_id)
+{
+	if (owner_loop_->is_in_own_loop()) {
+		cancel_timer_in_own_loop(timer_id);
+	} else {
+		owner_loop_->queue_in_own_loop(
+			std::bind(&WheelTimerPool::cancel_timer_in_own_loop, this, timer_id));
+	}
+}
+
+void WheelTimerPool::add_timer_in_own_loop(Timer* timer)
+{
+	owner_loop_->check_in_own_loop();
+
+	// The wheel is empty, move forward to current time.
+	if (size_ == 0) {
+		int64_t now = owner_loop_->loop_monotonic_time().internal_value() / tick_us_;
+		if (now > current_) {
+			current_ = now;
+		}
+	}
+
+	int64_t tick = link(timer);
+	if (tick < armed_) {
+		armed_ = tick;
+		reset(to_time(armed_));
+	}
+}
+
+void WheelTimerPool::cancel_timer_in_own_loop(TimerId timer_id)
+{
+	owner_loop_->check_in_own_loop();
+
+	// The timer node is never deleted until the pool destructs, so it is
+	// safe to check the sequence.
+	Timer* timer = timer_id.timer_;
+	if (!timer || timer->sequence() != timer_id.sequence_) {
+		return;
+	}
+
+	if (timer->slot_ >= 0) {
+		unlink(timer);
+		free_timer(timer);
+	} else if (timer->slot_ == kSlotExpired) {
+		// Timer is calling now, it will not be called (or added again).
+		timer->slot_ = kSlotCanceled;
+	}
+
+	// The `timerfd` is not reset, it wakes up (at most) once for nothing.
+}
+
+void WheelTimerPool::handle_expired(TimeStamp curr)
+{
+	owner_loop_->check_in_own_loop();
+
+	// Collect all expired timers of ticks, cascade at the end of every round.
+	std::vector<Timer*> expired_timers;
+	int64_t target = curr.internal_value() / tick_us_;
+	while (current_ <= target && size_ > 0) {
+		int index = static_cast<int>(current_ & (kRootSize - 1));
+		if (index == 0) {
+			for (int level = 1; level < kLevels; ++level) {
+				if (cascade(level, static_cast<int>(
+						(current_ >> (kRootBits + (level - 1) * kLevelBits)) & (kLevelSize - 1))))
+				{
+					break;
+				}
+			}
+		}
+
+		Timer* timer = slots_[index];
+		slots_[index] = nullptr;
+		while (timer) {
+			Timer* next = timer->next_;
+			timer->prev_ = timer->next_ = nullptr;
+			timer->slot_ = kSlotExpired;
+			expired_timers.push_back(timer);
+			size_--;
+			timer = next;
+		}
+		current_++;
+	}
+	if (current_ <= target) {
+		current_ = target + 1;
+	}
+
+	// Call timers in a batch. Timer being cancelled is skipped.
+	for (Timer* timer : expired_timers) {
+		if (timer->slot_ == kSlotExpired) {
+			timer->run();
+		}
+	}
+
+	// Free or add again, such as interval timers.
+	for (Timer* timer : expired_timers) {
+		if (timer->slot_ == kSlotExpired && timer->repeat()) {
+			timer->restart(curr);
+			timer->slot_ = kSlotNone;
+			link(timer);
+		} else {
+			free_timer(timer);
+		}
+	}
+
+	rearm();
+}
+
+#if !defined(OS_LINUX)
+TimeStamp WheelTimerPool::earliest_expired() const
+{
+	return armed_ == INT64_MAX? TimeStamp(): to_time(armed_);
+}
+#endif	// !defined(OS_LINUX)
+
+int64_t WheelTimerPool::link(Timer* timer)
+{
+	DCHECK_EQ(timer->slot_, kSlotNone);
+
+	// Never expire early, round up the tick.
+	int64_t tick = to_tick(timer->expired());
+	if (tick < current_) {
+		tick = current_;
+	}
+
+	int slot = 0;
+	int64_t delta = tick - current_;
+	if (delta < kRootSize) {
+		slot = static_cast<int>(tick & (kRootSize - 1));
+	} else {
+		int level = 1;
+		while (level < kLevels && delta >= (int64_t{1} << (kRootBits + level * kLevelBits))) {
+			level++;
+		}
+		if (level == kLevels) {
+			// Too long, it will be cascaded again.
+			level = kLevels - 1;
+			tick = current_ + (int64_t{1} << (kRootBits + level * kLevelBits)) - 1;
+		}
+		int shift = kRootBits + (level - 1) * kLevelBits;
+		slot = kRootSize + (level - 1) * kLevelSize +
+			static_cast<int>((tick >> shift) & (kLevelSize - 1));
+	}
+
+	timer->prev_ = nullptr;
+	timer->next_ = slots_[slot];
+	if (timer->next_) {
+		timer->next_->prev_ = timer;
+	}
+	slots_[slot] = timer;
+	timer->slot_ = slot;
+	size_++;
+
+	return tick;
+}
+
+void WheelTimerPool::unlink(Timer* timer)
+{
+	DCHECK_GE(timer->slot_, 0);
+
+	if (timer->prev_) {
+		timer->prev_->next_ = timer->next_;
+	} else {
+		slots_[timer->slot_] = timer->next_;
+	}
+	if (timer->next_) {
+		timer->next_->prev_ = timer->prev_;
+	}
+	timer->prev_ = timer->next_ = nullptr;
+	timer->slot_ = kSlotNone;
+	size_--;
+}
+
+int WheelTimerPool::cascade(int level, int index)
+{
+	int slot = kRootSize + (level - 1) * kLevelSize + index;
+
+	Timer* timer = slots_[slot];
+	slots_[slot] = nullptr;
+	while (timer) {
+		Timer* next = timer->next_;
+		timer->prev_ = timer->next_ = nullptr;
+		timer->slot_ = kSlotNone;
+		size_--;
+		link(timer);
+		timer = next;
+	}
+	return index;
+}
+
+void WheelTimerPool::free_timer(Timer* timer)
+{
+	timer->release();
+	timer->slot_ = kSlotNone;
+	free_timers_.push_back(timer);
+}
+
+void WheelTimerPool::rearm()
+{
+	if (size_ == 0) {
+		armed_ = INT64_MAX;
+		reset(TimeStamp());
+		return;
+	}
+
+	// Wake up at the first non-empty slot of this round, or at the end
+	// of round to cascade.
+	int64_t tick = current_;
+	if ((current_ & (kRootSize - 1)) != 0) {
+		int64_t end = (current_ | (kRootSize - 1)) + 1;
+		while (tick < end && !slots_[tick & (kRootSize - 1)]) {
+			tick++;
+		}
+	}
+	armed_ = tick;
+	reset(to_time(armed_));
+}
+
+int64_t WheelTimerPool::to_tick(TimeStamp time) const
+{
+	return (time.internal_value() + tick_us_ - 1) / tick_us_;
+}
+
+TimeStamp WheelTimerPool::to_time(int64_t tick) const
+{
+	return TimeStamp() + TimeDelta::from_microseconds(tick * tick_us_);
+}
+
+}	// namespace annety
@@ -0,0 +1,98 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#ifndef ANT_WHEEL_TIMER_POOL_H_
+#define ANT_WHEEL_TIMER_POOL_H_
+
+#include "Macros.h"
+#include "TimeStamp.h"
+#include "TimerPool.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace annety
+{
+// Timer pool of hierarchical timing wheel, O(1) insert/cancel.
+//
+// There are 4 levels of wheel: 256 slots of |tick| in the first level,
+// and 64 slots of the lower level round in the others (about 18 hours
+// when the tick is 1ms). The longer timers are put in the last slot, and
+// then cascaded again. Timers expire on the tick boundary, never early.
+//
+// The `timerfd` wakes up at the first non-empty slot of the first level,
+// or at the end of round to cascade, all expired timers run in a batch.
+//
+// Timer nodes are pooled, the TimerId is validated by its sequence. The
+// nodes are reused in own loop thread only (e.g. reset the idle timeout
+// of connection), so no locking is required.
+//
+// This class does not owns the EventLoop lifetime.
+class WheelTimerPool : public TimerPool
+{
+public:
+	explicit WheelTimerPool(EventLoop* loop,
+							TimeDelta tick = TimeDelta::from_milliseconds(1));
+	~WheelTimerPool() override;
+
+	// Usually be called from other threads.
+	// *Thread safe*
+	TimerId add_timer(TimerCallback cb, TimeStamp expired, double interval_s) override;
+	void cancel_timer(TimerId timer_id) override;
+
+protected:
+	// *Not thread safe*, but run in own loop thread.
+	void handle_expired(TimeStamp curr) override;
+
+#if !defined(OS_LINUX)
+	TimeStamp earliest_expired() const override;
+#endif
+
+private:
+	static const int kRootBits = 8;
+	static const int kLevelBits = 6;
+	static const int kLevels = 4;
+	static const int kRootSize = 1 << kRootBits;
+	static const int kLevelSize = 1 << kLevelBits;
+	static const int kSlotSize = kRootSize + (kLevels - 1) * kLevelSize;
+
+	// Timer::slot_ of not in wheel.
+	static const int kSlotNone = -1;
+	static const int kSlotExpired = -2;
+	static const int kSlotCanceled = -3;
+
+	// *Not thread safe*, but run in own loop thread.
+	void add_timer_in_own_loop(Timer* timer);
+	void cancel_timer_in_own_loop(TimerId timer_id);
+
+	// Link |timer| into the slot of its expired tick, returns the tick.
+	int64_t link(Timer* timer);
+	void unlink(Timer* timer);
+
+	// Move timers of the level slot to lower levels.
+	int cascade(int level, int index);
+
+	void free_timer(Timer* timer);
+	void rearm();
+
+	int64_t to_tick(TimeStamp time) const;
+	TimeStamp to_time(int64_t tick) const;
+
+private:
+	const int64_t tick_us_;
+
+	// The next tick to be processed.
+	int64_t current_{0};
+	// The tick that `timerfd` will wake up.
+	int64_t armed_{INT64_MAX};
+
+	size_t size_{0};
+	std::vector<Timer*> slots_;
+	std::vector<Timer*> free_timers_;
+
+	DISALLOW_COPY_AND_ASSIGN(WheelTimerPool);
+};
+
+}	// namespace annety
+
+#endif	// ANT_WHEEL_TIMER_POOL_H_
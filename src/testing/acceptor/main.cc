@@ -0,0 +1,135 @@
+
+#include "EventLoop.h"
+#include "TcpServer.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+
+#include <atomic>
+#include <vector>
+#include <iostream>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+
+using namespace annety;
+using namespace std;
+
+// Benchmark of the accept batch.
+// 1. kConns connections are pending in the backlog, reports the time that 
+//    the server (kWorkers worker loops) takes to accept and establish all
+//    of them, with the batch size 1 (one per wakeup) and 64.
+// 2. The file descriptors are exhausted (RLIMIT_NOFILE), reports the 
+//    accepted/rejected/EMFILE counters, the pending connections are closed 
+//    by the `idle_fd_` trick.
+namespace {
+const uint16_t kPort = 1672;
+const int kWorkers = 4;
+const int kConns = 1000;
+const int kRejectConns = 100;
+
+std::vector<int> connect_all(int count)
+{
+	struct sockaddr_in addr;
+	::memset(&addr, 0, sizeof addr);
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(kPort);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	std::vector<int> fds;
+	for (int i = 0; i < count; ++i) {
+		int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+		CHECK(::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof addr) == 0);
+		fds.push_back(fd);
+	}
+	return fds;
+}
+
+void run(int batch)
+{
+	EventLoop loop;
+	std::atomic<int> established{0};
+	std::atomic<int> closed{0};
+
+	TcpServerPtr server = make_tcp_server(&loop, EndPoint(kPort), "BatchServer", false, true);
+	server->set_connect_callback([&](const TcpConnectionPtr&) {
+		if (established.fetch_add(1) + 1 == kConns) {
+			loop.quit();
+		}
+	});
+	server->set_close_callback([&](const TcpConnectionPtr&) {
+		if (closed.fetch_add(1) + 1 == kConns) {
+			// Wait for the connections to be removed from server.
+			loop.run_after(0.1, [&]() { loop.quit();});
+		}
+	});
+	server->set_thread_num(kWorkers);
+	server->set_accept_batch(batch);
+	server->listen();
+
+	std::vector<int> fds = connect_all(kConns);
+
+	TimeStamp start = TimeStamp::now();
+	loop.loop();
+	TimeDelta elapsed = TimeStamp::now() - start;
+
+	cout << "batch " << batch << "\t" << elapsed.in_microseconds_f() / kConns << "us/conn\t"
+		<< "accepted " << server->accepted_count() << endl;
+
+	for (int fd : fds) {
+		::close(fd);
+	}
+	loop.loop();
+}
+
+void run_emfile()
+{
+	EventLoop loop;
+
+	TcpServerPtr server = make_tcp_server(&loop, EndPoint(kPort), "BatchServer", false, true);
+	server->set_close_callback([](const TcpConnectionPtr&) {});
+	server->set_thread_num(kWorkers);
+	server->listen();
+
+	std::vector<int> fds = connect_all(kRejectConns);
+
+	// No more file descriptor.
+	struct rlimit old_limit, limit;
+	::getrlimit(RLIMIT_NOFILE, &old_limit);
+	limit = old_limit;
+	limit.rlim_cur = fds.back() + 1;
+	::setrlimit(RLIMIT_NOFILE, &limit);
+
+	loop.run_after(0.2, [&]() { loop.quit();});
+	loop.loop();
+
+	::setrlimit(RLIMIT_NOFILE, &old_limit);
+
+	// The rejected connections are closed by peer.
+	int closed = 0;
+	for (int fd : fds) {
+		char buf[1];
+		if (::recv(fd, buf, sizeof buf, MSG_DONTWAIT) == 0) {
+			closed++;
+		}
+		::close(fd);
+	}
+
+	cout << "emfile\t\taccepted " << server->accepted_count() 
+		<< "\trejected " << server->rejected_count()
+		<< "\temfile " << server->emfile_count()
+		<< "\tclosed by peer " << closed << endl;
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_FATAL);
+
+	run(1);
+	run(64);
+	run_emfile();
+}
@@ -0,0 +1,91 @@
+
+#include "Logging.h"
+#include "LogFile.h"
+#include "AsyncLogging.h"
+#include "TimeStamp.h"
+#include "threading/Thread.h"
+#include "synchronization/MutexLock.h"
+
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+using namespace annety;
+using namespace std;
+
+// Benchmark of the synchronous LogFile and the AsyncLogging backend.
+// kThreads threads call LOG(INFO) kMessages times, reports messages/sec
+// and the p50/p99/max latency of the caller.
+namespace {
+const int kThreads = 4;
+const int kMessages = 200000;
+
+MutexLock g_lock;
+std::unique_ptr<LogFile> g_log_file;
+std::unique_ptr<AsyncLogging> g_async_log;
+
+void sync_output(const char* msg, int len)
+{
+	// LogFile is not thread safe.
+	AutoLock locked(g_lock);
+	g_log_file->append(msg, len);
+}
+
+void async_output(const char* msg, int len)
+{
+	g_async_log->append(msg, len);
+}
+
+void run(const char* name)
+{
+	std::vector<std::vector<double>> costs(kThreads);
+	std::vector<std::unique_ptr<Thread>> threads;
+
+	TimeStamp start = TimeStamp::now();
+	for (int i = 0; i < kThreads; ++i) {
+		std::vector<double>* cost = &costs[i];
+		threads.emplace_back(new Thread([cost]() {
+			cost->reserve(kMessages);
+			for (int j = 0; j < kMessages; ++j) {
+				TimeStamp t = TimeStamp::now();
+				LOG(INFO) << "1234567890 abcdefghijklmnopqrstuvwxyz " << j;
+				cost->push_back((TimeStamp::now() - t).in_microseconds_f());
+			}
+		}, "bench"));
+		threads.back()->start();
+	}
+	for (auto& td : threads) {
+		td->join();
+	}
+	TimeDelta elapsed = TimeStamp::now() - start;
+
+	std::vector<double> all;
+	for (auto& c : costs) {
+		all.insert(all.end(), c.begin(), c.end());
+	}
+	std::sort(all.begin(), all.end());
+
+	cout << name << "\t" << static_cast<int64_t>(all.size() / elapsed.in_seconds_f())
+		<< " msg/s\tp50 " << all[all.size() / 2]
+		<< "us\tp99 " << all[all.size() * 99 / 100]
+		<< "us\tmax " << all.back() << "us" << endl;
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	g_log_file.reset(new LogFile(FilePath("sync"), 1024*1024*1024));
+	set_log_output_handler(sync_output);
+	run("sync");
+	g_log_file.reset();
+
+	g_async_log.reset(new AsyncLogging(FilePath("async"), 1024*1024*1024));
+	g_async_log->start();
+	set_log_output_handler(async_output);
+	run("async");
+	g_async_log->stop();
+
+	cout << "async dropped " << g_async_log->dropped_count() << endl;
+}
@@ -0,0 +1,102 @@
+#include "Logging.h"
+#include "BinaryLogging.h"
+#include "TimeStamp.h"
+#include "files/FilePath.h"
+#include "files/FileEnumerator.h"
+#include "files/FileUtil.h"
+
+#include <string>
+#include <iostream>
+#include <unistd.h>
+
+using namespace annety;
+using namespace std;
+
+// The cost of a record in the logging thread, with an int, an int64, a 
+// double, a string and a TimeStamp.
+// 1. LOG(INFO): formatted into text (the output handler only counts bytes).
+// 2. BLOG(INFO): the raw bytes are pushed into the ring of thread, the
+//    backend writes the binary logs into /tmp/binlog_testing.*
+// Then the binary logs are decoded, the lines must be equal to the records
+// (two rounds).
+namespace {
+const int kRecords = 1000 * 1000;
+const char kPath[] = "/tmp/binlog_testing";
+
+int64_t g_bytes = 0;
+
+void count_output(const char* msg, int len)
+{
+	g_bytes += len;
+}
+
+void report(const char* name, TimeStamp start)
+{
+	TimeDelta elapsed = TimeStamp::now() - start;
+	cout << name << "\t" << elapsed.in_microseconds_f() * 1000 / kRecords << "ns/record" << endl;
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	const std::string name = "EchoServer#127.0.0.1:1669#1";
+	const double ratio = 0.75;
+	const TimeStamp when = TimeStamp::now();
+
+	LogOutputHandlerFunction saved = set_log_output_handler(count_output);
+	{
+		TimeStamp start = TimeStamp::now();
+		for (int i = 0; i < kRecords; ++i) {
+			LOG(INFO) << "handle_read [" << name << "] fd=" << 17 << " bytes=" 
+				<< static_cast<int64_t>(i) << " ratio=" << ratio << " at " << when;
+		}
+		report("LOG(INFO)", start);
+	}
+	set_log_output_handler(saved);
+
+	{
+		// Large enough ring, no record is dropped.
+		BinaryLogging blog(FilePath(kPath), 1024*1024*1024, 0.01, 3.0, 128*1024*1024);
+		blog.start();
+
+		// The first round touches the pages of ring.
+		for (int r = 0; r < 2; ++r) {
+			TimeStamp start = TimeStamp::now();
+			for (int i = 0; i < kRecords; ++i) {
+				BLOG(INFO, "handle_read [{}] fd={} bytes={} ratio={} at {}", 
+					name, 17, static_cast<int64_t>(i), ratio, when);
+			}
+			if (r == 1) {
+				report("BLOG(INFO)", start);
+			}
+			::usleep(200 * 1000);
+		}
+		blog.stop();
+	}
+
+	// Decode and remove the binary logs.
+	int64_t lines = 0;
+	std::string sample;
+	FileEnumerator files(FilePath("/tmp"), false, FileEnumerator::FILES, "binlog_testing.*");
+	for (FilePath file = files.next(); !file.empty(); file = files.next()) {
+		std::string data;
+		CHECK(read_file_to_string(file, &data));
+
+		BinaryLogDecoder decoder;
+		std::string text;
+		TimeStamp start = TimeStamp::now();
+		CHECK(decoder.decode(data.data(), data.size(), &text) == static_cast<ssize_t>(data.size()));
+		TimeDelta elapsed = TimeStamp::now() - start;
+
+		for (char c : text) {
+			lines += c == '\n';
+		}
+		sample = text.substr(0, text.find('\n') + 1);
+		cout << "decode\t" << elapsed.in_microseconds_f() * 1000 / (2 * kRecords) << "ns/record\t(" 
+			<< data.size() / (2 * kRecords) << " bytes/record binary)" << endl;
+		delete_file(file, false);
+	}
+	cout << "lines " << lines << "/" << 2 * kRecords << ", dropped " << BinaryLogging::dropped_count() << endl;
+	cout << sample;
+}
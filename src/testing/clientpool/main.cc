@@ -0,0 +1,188 @@
+
+#include "EventLoop.h"
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "TcpClientPool.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+#include "threading/Thread.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+using namespace annety;
+using namespace std;
+
+// Benchmark of the backend fan-out requests, an echo server in the same 
+// process.
+// 1. connect: every request connects a new TcpClient.
+// 2. pool: every request leases a warm connection of TcpClientPool.
+// 3. lease: the cost of getting the connection from another thread, 
+//    TcpClient::connection() (MutexLock) vs TcpClientPool::lease().
+namespace {
+const uint16_t kPort = 1672;
+const int kConnections = 4;
+const int kConnectRequests = 2000;
+const int kPoolRequests = 100000;
+const int kLeases = 10000000;
+
+const std::string kMessage(64, 'x');
+
+TcpServerPtr make_echo_server(EventLoop* loop)
+{
+	TcpServerPtr server = make_tcp_server(loop, EndPoint(kPort), "EchoServer", false, true);
+	server->set_message_callback([](const TcpConnectionPtr& conn, NetBuffer* buf, TimeStamp) {
+		conn->send(buf);
+	});
+	server->listen();
+	return server;
+}
+
+void run_connect()
+{
+	EventLoop loop;
+	TcpServerPtr server = make_echo_server(&loop);
+
+	int requests = 0;
+	TimeStamp start = TimeStamp::now();
+	
+	// The disconnected clients are destroyed at the end.
+	std::vector<TcpClientPtr> clients;
+	std::function<void()> request = [&]() {
+		TcpClientPtr client = make_tcp_client(&loop, EndPoint("127.0.0.1", kPort), "ConnectClient");
+		client->set_connect_callback([](const TcpConnectionPtr& conn) {
+			conn->set_tcp_nodelay(true);
+			conn->send(kMessage);
+		});
+		client->set_message_callback([&](const TcpConnectionPtr& conn, NetBuffer* buf, TimeStamp) {
+			if (buf->readable_bytes() < kMessage.size()) {
+				return;
+			}
+			buf->has_read_all();
+			clients.back()->disconnect();
+			if (++requests == kConnectRequests) {
+				TimeDelta elapsed = TimeStamp::now() - start;
+				cout << "connect\t" << elapsed.in_microseconds_f() / kConnectRequests << " us/request" << endl;
+				loop.run_after(0.1, [&]() { loop.quit();});
+			} else {
+				loop.queue_in_own_loop([&]() { request();});
+			}
+		});
+		client->connect();
+		clients.push_back(client);
+	};
+	request();
+
+	loop.loop();
+}
+
+void run_pool()
+{
+	EventLoop loop;
+	TcpServerPtr server = make_echo_server(&loop);
+
+	int requests = 0;
+	TimeStamp start;
+	TcpClientPool::Lease lease;
+
+	TcpClientPoolPtr pool = make_tcp_client_pool(&loop, "ClientPool");
+	pool->add_endpoint(EndPoint("127.0.0.1", kPort));
+	pool->set_connection_num(kConnections);
+
+	std::function<void()> request = [&]() {
+		lease = pool->lease();
+		CHECK(lease);
+		lease.connection()->send(kMessage);
+	};
+	pool->set_connect_callback([&](const TcpConnectionPtr& conn) {
+		conn->set_tcp_nodelay(true);
+		if (pool->connected_count() == kConnections) {
+			start = TimeStamp::now();
+			request();
+		}
+	});
+	pool->set_message_callback([&](const TcpConnectionPtr& conn, NetBuffer* buf, TimeStamp) {
+		if (buf->readable_bytes() < kMessage.size()) {
+			return;
+		}
+		buf->has_read_all();
+		lease.release();
+		if (++requests == kPoolRequests) {
+			TimeDelta elapsed = TimeStamp::now() - start;
+			cout << "pool\t" << elapsed.in_microseconds_f() / kPoolRequests << " us/request" << endl;
+			pool->stop();
+			loop.run_after(0.1, [&]() { loop.quit();});
+		} else {
+			request();
+		}
+	});
+	pool->start();
+
+	loop.loop();
+}
+
+void run_lease()
+{
+	EventLoop loop;
+	TcpServerPtr server = make_echo_server(&loop);
+
+	TcpClientPtr client = make_tcp_client(&loop, EndPoint("127.0.0.1", kPort), "LeaseClient");
+	client->connect();
+
+	TcpClientPoolPtr pool = make_tcp_client_pool(&loop, "LeasePool");
+	pool->add_endpoint(EndPoint("127.0.0.1", kPort));
+	pool->set_connection_num(kConnections);
+	pool->set_connect_callback([&](const TcpConnectionPtr&) {
+		if (pool->connected_count() < kConnections) {
+			return;
+		}
+
+		// The leases of the own loop.
+		TimeStamp start = TimeStamp::now();
+		for (int i = 0; i < kLeases; ++i) {
+			TcpClientPool::Lease lease = pool->lease();
+		}
+		TimeDelta local = TimeStamp::now() - start;
+
+		// The leases of another thread.
+		TimeDelta elapsed[2];
+		Thread thr([&]() {
+			TimeStamp start = TimeStamp::now();
+			for (int i = 0; i < kLeases; ++i) {
+				TcpConnectionPtr conn = client->connection();
+			}
+			elapsed[0] = TimeStamp::now() - start;
+
+			start = TimeStamp::now();
+			for (int i = 0; i < kLeases; ++i) {
+				TcpClientPool::Lease lease = pool->lease();
+			}
+			elapsed[1] = TimeStamp::now() - start;
+		}, "lease");
+		thr.start();
+		thr.join();
+
+		cout << "client.connection\t" << elapsed[0].in_microseconds_f() * 1000 / kLeases << " ns/op" << endl;
+		cout << "pool.lease (thread)\t" << elapsed[1].in_microseconds_f() * 1000 / kLeases << " ns/op" << endl;
+		cout << "pool.lease (loop)\t" << local.in_microseconds_f() * 1000 / kLeases << " ns/op" << endl;
+
+		client->disconnect();
+		pool->stop();
+		loop.run_after(0.1, [&]() { loop.quit();});
+	});
+	pool->start();
+
+	loop.loop();
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_WARNING);
+
+	run_connect();
+	run_pool();
+	run_lease();
+}
@@ -0,0 +1,59 @@
+#include "EventLoop.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+
+#include <iostream>
+#include <time.h>
+
+using namespace annety;
+using namespace std;
+
+// Calls per second of the clock sources.
+// 1. now: gettimeofday(2).
+// 2. now_coarse: CLOCK_REALTIME_COARSE.
+// 3. now_monotonic: CLOCK_MONOTONIC (the timers).
+// 4. loop_time: the cached time of EventLoop, refreshed once per iteration.
+namespace {
+const int kCalls = 20 * 1000 * 1000;
+
+int64_t g_sum = 0;
+
+template <typename Clock>
+void bench(const char* name, Clock clock)
+{
+	TimeStamp start = TimeStamp::now();
+	for (int i = 0; i < kCalls; ++i) {
+		g_sum += clock().internal_value();
+	}
+	double s = (TimeStamp::now() - start).in_seconds_f();
+	cout << "  " << name << "\t" << static_cast<int64_t>(kCalls / s) << " calls/s\t"
+		<< s * 1e9 / kCalls << " ns/call" << endl;
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_ERROR);
+
+	struct timespec res;
+#if defined(CLOCK_REALTIME_COARSE)
+	::clock_getres(CLOCK_REALTIME_COARSE, &res);
+	cout << "CLOCK_REALTIME_COARSE resolution " << res.tv_nsec / 1000 << "us" << endl;
+#endif
+
+	bench("now", []() { return TimeStamp::now();});
+	bench("now_coarse", []() { return TimeStamp::now_coarse();});
+	bench("now_monotonic", []() { return TimeStamp::now_monotonic();});
+
+	EventLoop loop;
+	loop.run_after(0.0, [&]() {
+		// Reads the cached time every call (not hoisted out of the loop).
+		const EventLoop* volatile cached = &loop;
+		bench("loop_time", [&]() { return cached->loop_time();});
+		loop.quit();
+	});
+	loop.loop();
+
+	return g_sum == 0;
+}
@@ -0,0 +1,147 @@
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "NetBuffer.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+#include "codec/LengthHeaderCodec.h"
+#include "synchronization/CountDownLatch.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+using namespace annety;
+using namespace std;
+
+// The throughput of a pipelined echo server of LengthHeaderCodec, the client
+// keeps a burst of kPipeline frames (64 bytes payload) in flight.
+// 1. frame: the message callback sends the reply of each frame.
+// 2. batch: the batch message callback sends the replies of a read in the
+//    corked connection (one writev).
+namespace {
+const int kPipeline = 64;
+const size_t kPayload = 64;
+const double kSeconds = 2.0;
+
+class EchoServer
+{
+public:
+	EchoServer(EventLoop* loop, uint16_t port, bool batch)
+		: codec_(loop)
+	{
+		using std::placeholders::_1;
+		using std::placeholders::_2;
+		using std::placeholders::_3;
+
+		server_ = make_tcp_server(loop, EndPoint(port), "EchoServer", false, true);
+		server_->set_message_callback(
+			std::bind(&Codec::recv, &codec_, _1, _2, _3));
+		if (batch) {
+			codec_.set_batch_message_callback(
+				std::bind(&EchoServer::on_batch, this, _1, _2, _3));
+		} else {
+			codec_.set_message_callback(
+				std::bind(&EchoServer::on_message, this, _1, _2, _3));
+		}
+		server_->listen();
+	}
+
+private:
+	void on_message(const TcpConnectionPtr& conn, const StringPiece& payload, TimeStamp)
+	{
+		codec_.send(conn, payload);
+	}
+
+	void on_batch(const TcpConnectionPtr& conn, const std::vector<StringPiece>& payloads, TimeStamp)
+	{
+		for (const StringPiece& payload : payloads) {
+			codec_.send(conn, payload);
+		}
+	}
+
+private:
+	LengthHeaderCodec codec_;
+	TcpServerPtr server_;
+};
+
+void run(const char* name, uint16_t port, bool batch)
+{
+	EventLoop own_loop;
+	EventLoop* loop = &own_loop;
+
+	EventLoopThread server_thread;
+	EventLoop* server_loop = server_thread.start_loop();
+
+	EchoServer* server = nullptr;
+	CountDownLatch listened(1);
+	server_loop->run_in_own_loop([&]() {
+		server = new EchoServer(server_loop, port, batch);
+		listened.count_down();
+	});
+	listened.wait();
+
+	// The burst of the pipelined frames.
+	NetBuffer burst;
+	{
+		LengthHeaderCodec codec(loop);
+		const std::string payload(kPayload, 'p');
+		for (int i = 0; i < kPipeline; ++i) {
+			NetBuffer frame;
+			frame.reserve_prependable(Codec::kPrependSize);
+			frame.append(payload);
+			CHECK(codec.encode(&frame) == 1);
+			burst.append(frame.begin_read(), frame.readable_bytes());
+		}
+	}
+
+	int64_t bursts = 0;
+	bool stopped = false;
+	TcpClientPtr client = make_tcp_client(loop, EndPoint("127.0.0.1", port), "EchoClient");
+	client->set_connect_callback([&](const TcpConnectionPtr& conn) {
+		conn->set_tcp_nodelay(true);
+		conn->send(burst.to_string_piece());
+	});
+	client->set_message_callback([&](const TcpConnectionPtr& conn, NetBuffer* buff, TimeStamp) {
+		while (buff->readable_bytes() >= burst.readable_bytes()) {
+			buff->has_read(burst.readable_bytes());
+			bursts++;
+			if (!stopped) {
+				conn->send(burst.to_string_piece());
+			}
+		}
+	});
+	client->connect();
+
+	TimeStamp start = TimeStamp::now();
+	loop->run_after(kSeconds, [&]() {
+		stopped = true;
+		client->disconnect();
+		loop->run_after(0.1, [&]() { loop->quit();});
+	});
+	loop->loop();
+	TimeDelta elapsed = TimeStamp::now() - start;
+
+	cout << name << "\t" << static_cast<int64_t>(bursts * kPipeline / elapsed.in_seconds_f())
+		<< " frames/s" << endl;
+
+	client.reset();
+
+	CountDownLatch destroyed(1);
+	server_loop->run_in_own_loop([&]() {
+		delete server;
+		destroyed.count_down();
+	});
+	destroyed.wait();
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_ERROR);
+
+	run("frame", 1677, false);
+	run("batch", 1678, true);
+}
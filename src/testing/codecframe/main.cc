@@ -0,0 +1,125 @@
+
+#include "EventLoop.h"
+#include "NetBuffer.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+#include "codec/LengthHeaderCodec.h"
+
+#include <atomic>
+#include <string>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+
+using namespace annety;
+using namespace std;
+
+// The cost of LengthHeaderCodec per frame of 256 bytes payload.
+// 1. decode: Codec::recv() of a buffer of 1000 frames, until the message 
+//    callback.
+// 2. encode: a payload is appended and framed, until it can be sent by 
+//    TcpConnection::send().
+// Reports the time and the heap allocations per frame.
+namespace {
+std::atomic<int64_t> g_allocs{0};
+
+const int kFrames = 1000;
+const int kRounds = 1000;
+const size_t kPayload = 256;
+
+int64_t g_sum = 0;
+
+void on_message(const TcpConnectionPtr&, const StringPiece& payload, TimeStamp)
+{
+	g_sum += payload.size() + payload[0];
+}
+
+void report(const char* name, TimeStamp start, int64_t start_allocs)
+{
+	TimeDelta elapsed = TimeStamp::now() - start;
+	int64_t allocs = g_allocs.load(std::memory_order_relaxed) - start_allocs;
+
+	const int64_t total = static_cast<int64_t>(kFrames) * kRounds;
+	cout << name << "\t" << elapsed.in_microseconds_f() * 1000 / total << "ns/frame\t"
+		<< static_cast<double>(allocs) / total << " allocs/frame\t(" << g_sum << ")" << endl;
+}
+
+}	// namespace anonymous
+
+void* operator new(size_t size)
+{
+	g_allocs.fetch_add(1, std::memory_order_relaxed);
+	void* ptr = ::malloc(size == 0? 1: size);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	::free(ptr);
+}
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_WARNING);
+
+	EventLoop loop;
+	LengthHeaderCodec codec(&loop);
+	codec.set_message_callback(on_message);
+
+	const std::string payload(kPayload, 'p');
+
+	NetBuffer frames;
+	for (int i = 0; i < kFrames; ++i) {
+		NetBuffer frame;
+		frame.reserve_prependable(Codec::kPrependSize);
+		frame.append(payload);
+		CHECK(codec.encode(&frame) == 1);
+		frames.append(frame.begin_read(), frame.readable_bytes());
+	}
+
+	// decode
+	{
+		NetBuffer buff;
+		int64_t start_allocs = 0;
+		TimeStamp start;
+		for (int r = 0; r <= kRounds; ++r) {
+			if (r == 1) {
+				// Warm up the first round.
+				start_allocs = g_allocs.load(std::memory_order_relaxed);
+				start = TimeStamp::now();
+			}
+			buff.append(frames.begin_read(), frames.readable_bytes());
+			codec.recv(TcpConnectionPtr(), &buff, TimeStamp::now());
+			CHECK(buff.readable_bytes() == 0);
+		}
+		report("decode", start, start_allocs);
+	}
+
+	// encode
+	{
+		int64_t start_allocs = 0;
+		TimeStamp start;
+		for (int r = 0; r <= kRounds; ++r) {
+			if (r == 1) {
+				start_allocs = g_allocs.load(std::memory_order_relaxed);
+				start = TimeStamp::now();
+			}
+			for (int i = 0; i < kFrames; ++i) {
+				NetBuffer frame;
+				frame.reserve_prependable(Codec::kPrependSize);
+				frame.append(payload);
+				CHECK(codec.encode(&frame) == 1);
+				g_sum += frame.readable_bytes();
+			}
+		}
+		report("encode", start, start_allocs);
+	}
+}
@@ -0,0 +1,58 @@
+
+#include "Crc32c.h"
+#include "TimeStamp.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdlib.h>
+
+using namespace annety;
+using namespace std;
+
+// The throughput of the checksum at 64B, 4KB and 1MB.
+// 1. crc32_short/crc32_long: the byte-at-a-time tables (IEEE).
+// 2. crc32_ieee: the slicing-by-8 tables (IEEE), it is the same algorithm of
+//    the software fallback of crc32c.
+// 3. crc32c: the runtime dispatched CRC32C (SSE4.2, three streams).
+namespace {
+const size_t kTotalBytes = 256 * 1024 * 1024;
+
+uint32_t g_sum = 0;
+
+template <typename F>
+void run(const char* name, const std::string& data, F func)
+{
+	const size_t rounds = kTotalBytes / data.size();
+
+	TimeStamp start = TimeStamp::now();
+	for (size_t i = 0; i < rounds; ++i) {
+		g_sum += func(data.data(), data.size());
+	}
+	TimeDelta elapsed = TimeStamp::now() - start;
+
+	cout << "  " << name << "\t" 
+		<< static_cast<double>(rounds * data.size()) / elapsed.in_microseconds_f() / 1000 << " GB/s\t"
+		<< elapsed.in_microseconds_f() * 1000 / rounds << " ns/call" << endl;
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	cout << "hardware accelerated: " << Crc32c::is_hardware_accelerated() << endl;
+
+	for (size_t size : {size_t(64), size_t(4096), size_t(1024 * 1024)}) {
+		std::string data(size, 0);
+		for (auto& c : data) {
+			c = static_cast<char>(::rand());
+		}
+
+		cout << size << " bytes" << endl;
+		run("crc32_short", data, [](const char* buff, size_t len) { return Crc32c::crc32_short(buff, len);});
+		run("crc32_long", data, [](const char* buff, size_t len) { return Crc32c::crc32_long(buff, len);});
+		run("crc32_ieee", data, [](const char* buff, size_t len) { return Crc32c::crc32_ieee(buff, len);});
+		run("crc32c", data, [](const char* buff, size_t len) { return Crc32c::crc32c(buff, len);});
+	}
+	cout << "(" << g_sum << ")" << endl;
+}
@@ -0,0 +1,164 @@
+
+#include "EventLoop.h"
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+#include "threading/Thread.h"
+#include "synchronization/CountDownLatch.h"
+
+#include <atomic>
+#include <string>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+
+using namespace annety;
+using namespace std;
+
+// Counts the heap allocations of the event loop hot path.
+// 1. pingpong: one echo session (server and client in one process),
+//    reports the allocations per echoed message.
+// 2. post: a loop thread runs kPosts tasks that are posted from another
+//    thread, each task captures 48 bytes.
+// 3. timer: add and cancel kTimers timers in own loop thread.
+namespace {
+std::atomic<int64_t> g_allocs{0};
+
+const uint16_t kPort = 1670;
+const int kBlockSize = 64;
+const int kWarmup = 1000;
+const int kMessages = 100000;
+const int kPosts = 1000000;
+const int kTimers = 1000000;
+
+void run_pingpong()
+{
+	EventLoop loop;
+
+	TcpServerPtr server = make_tcp_server(&loop, EndPoint(kPort), "FunctorServer", false, true);
+	server->set_message_callback([](const TcpConnectionPtr& conn, NetBuffer* buf, TimeStamp) {
+		conn->send(buf);
+	});
+	server->set_thread_num(1);
+	server->listen();
+
+	int64_t messages = 0;
+	int64_t start_allocs = 0;
+	TimeStamp start;
+	std::string message(kBlockSize, 'x');
+
+	TcpClientPtr client = make_tcp_client(&loop, EndPoint("127.0.0.1", kPort), "FunctorClient");
+	client->set_connect_callback([&](const TcpConnectionPtr& conn) {
+		conn->set_tcp_nodelay(true);
+		conn->send(message);
+	});
+	client->set_message_callback([&](const TcpConnectionPtr& conn, NetBuffer* buf, TimeStamp) {
+		if (++messages == kWarmup) {
+			start_allocs = g_allocs.load(std::memory_order_relaxed);
+			start = TimeStamp::now();
+		} else if (messages == kWarmup + kMessages) {
+			int64_t allocs = g_allocs.load(std::memory_order_relaxed) - start_allocs;
+			TimeDelta elapsed = TimeStamp::now() - start;
+			// The server and the client both echo once per round trip.
+			cout << "pingpong\t" << static_cast<double>(allocs) / (2 * kMessages) << " allocs/echo\t"
+				<< elapsed.in_microseconds_f() / kMessages << "us/rtt" << endl;
+			client->disconnect();
+			loop.run_after(0.1, [&]() { loop.quit();});
+			return;
+		}
+		conn->send(buf);
+	});
+	client->connect();
+
+	loop.loop();
+}
+
+void run_post()
+{
+	EventLoop* loop = nullptr;
+	CountDownLatch started(1);
+	Thread looper([&]() {
+		EventLoop l;
+		loop = &l;
+		started.count_down();
+		l.loop();
+	}, "loop");
+	looper.start();
+	started.wait();
+
+	int64_t done = 0;
+	int64_t a = 1, b = 2, c = 3, d = 4, e = 5;
+	CountDownLatch finished(1);
+
+	int64_t start_allocs = g_allocs.load(std::memory_order_relaxed);
+	TimeStamp start = TimeStamp::now();
+	for (int i = 0; i < kPosts; ++i) {
+		loop->queue_in_own_loop([&done, &finished, a, b, c, d, e]() {
+			done += a + b + c + d + e - 14;
+			if (done == kPosts) {
+				finished.count_down();
+			}
+		});
+	}
+	finished.wait();
+	TimeDelta elapsed = TimeStamp::now() - start;
+	int64_t allocs = g_allocs.load(std::memory_order_relaxed) - start_allocs;
+
+	cout << "post\t\t" << static_cast<double>(allocs) / kPosts << " allocs/post\t"
+		<< elapsed.in_microseconds_f() * 1000 / kPosts << "ns/post" << endl;
+
+	loop->quit();
+	looper.join();
+}
+
+void run_timer()
+{
+	EventLoop loop(EventLoop::kPollerDefault, EventLoop::kTimerWheel);
+
+	int64_t a = 1, b = 2, c = 3, d = 4;
+	int64_t start_allocs = g_allocs.load(std::memory_order_relaxed);
+	TimeStamp start = TimeStamp::now();
+	for (int i = 0; i < kTimers; ++i) {
+		TimerId id = loop.run_after(30.0, [a, b, c, d]() {
+			CHECK(a + b + c + d == 10);
+		});
+		loop.cancel(id);
+	}
+	TimeDelta elapsed = TimeStamp::now() - start;
+	int64_t allocs = g_allocs.load(std::memory_order_relaxed) - start_allocs;
+
+	cout << "timer\t\t" << static_cast<double>(allocs) / kTimers << " allocs/timer\t"
+		<< elapsed.in_microseconds_f() * 1000 / kTimers << "ns/timer" << endl;
+}
+
+}	// namespace anonymous
+
+void* operator new(size_t size)
+{
+	g_allocs.fetch_add(1, std::memory_order_relaxed);
+	void* ptr = ::malloc(size == 0? 1: size);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	::free(ptr);
+}
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_WARNING);
+
+	run_pingpong();
+	run_post();
+	run_timer();
+}
@@ -0,0 +1,72 @@
+#include "Logging.h"
+#include "TimeStamp.h"
+
+#include <atomic>
+#include <string>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+
+using namespace annety;
+using namespace std;
+
+// The cost of formatting a LOG(INFO) record of a few fields, the output 
+// handler only counts the bytes (no I/O).
+// Reports the time and the heap allocations per record.
+namespace {
+std::atomic<int64_t> g_allocs{0};
+
+const int kRecords = 1000 * 1000;
+
+int64_t g_bytes = 0;
+
+void count_output(const char* msg, int len)
+{
+	g_bytes += len;
+}
+
+}	// namespace anonymous
+
+void* operator new(size_t size)
+{
+	g_allocs.fetch_add(1, std::memory_order_relaxed);
+	void* ptr = ::malloc(size == 0? 1: size);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	::free(ptr);
+}
+
+int main(int argc, char* argv[])
+{
+	set_log_output_handler(count_output);
+
+	const std::string name = "EchoServer#127.0.0.1:1669#1";
+	
+	// Warm up the caches of thread.
+	LOG(INFO) << "warm up";
+
+	int64_t start_allocs = g_allocs.load(std::memory_order_relaxed);
+	TimeStamp start = TimeStamp::now();
+	for (int i = 0; i < kRecords; ++i) {
+		LOG(INFO) << "TcpConnection::handle_read [" << name << "] fd=" << 17 
+			<< " bytes=" << i << " ok";
+	}
+	TimeDelta elapsed = TimeStamp::now() - start;
+	int64_t allocs = g_allocs.load(std::memory_order_relaxed) - start_allocs;
+
+	set_log_output_handler(nullptr);
+	cout << "LOG(INFO)\t" << elapsed.in_microseconds_f() * 1000 / kRecords << "ns/record\t"
+		<< static_cast<double>(allocs) / kRecords << " allocs/record\t(" 
+		<< g_bytes / (kRecords + 1) << " bytes/record)" << endl;
+}
@@ -0,0 +1,85 @@
+#include "LogFile.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+#include "files/FilePath.h"
+#include "files/FileUtil.h"
+#include "files/FileEnumerator.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+
+using namespace annety;
+using namespace std;
+
+// The latency of LogFile::append() across the rotations, 256 bytes lines
+// into 4MB segments. The rotated segments are compressed, and 4 files are
+// kept. Reports the worst append, and the worst append of rotation.
+namespace {
+const int kLines = 400 * 1000;
+const int kLineSize = 256;
+const off_t kRotateSize = 4 * 1024 * 1024;
+const int kMaxFiles = 4;
+
+int count_files(const FilePath& dir)
+{
+	int n = 0;
+	FileEnumerator enums(dir, false, FileEnumerator::FILES, "rotate.*");
+	for (FilePath name = enums.next(); !name.empty(); name = enums.next()) {
+		n++;
+	}
+	return n;
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_ERROR);
+
+	FilePath dir("rotate-logs");
+	delete_file(dir, true);
+	create_directory(dir);
+
+	std::string line(kLineSize - 1, 'x');
+	line += '\n';
+
+	std::vector<double> latencies;
+	std::vector<double> rotations;
+	latencies.reserve(kLines);
+	{
+		LogFile output(dir.append("rotate"), kRotateSize, 1 << 30);
+		output.set_max_files(kMaxFiles);
+		output.set_compress(true);
+
+		FilePath filename = output.filename();
+		for (int i = 0; i < kLines; ++i) {
+			TimeStamp start = TimeStamp::now();
+			output.append(line);
+			double us = (TimeStamp::now() - start).in_microseconds_f();
+			latencies.push_back(us);
+
+			if (!(output.filename() == filename)) {
+				filename = output.filename();
+				rotations.push_back(us);
+			}
+			// Pauses every 10000 lines, the helper catches up.
+			if (i % 10000 == 0) {
+				::usleep(10 * 1000);
+			}
+		}
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+	cout << "append\tp50 " << latencies[latencies.size() / 2] << "us"
+		<< "\tp99.99 " << latencies[latencies.size() * 9999 / 10000] << "us"
+		<< "\tmax " << latencies.back() << "us" << endl;
+	if (!rotations.empty()) {
+		cout << "rotate\t" << rotations.size() << " times"
+			<< "\tmax " << *std::max_element(rotations.begin(), rotations.end()) << "us" << endl;
+	}
+	cout << "files\t" << count_files(dir) << " kept" << endl;
+	delete_file(dir, true);
+}
@@ -0,0 +1,80 @@
+
+#include "EventLoop.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+#include "threading/Thread.h"
+#include "synchronization/CountDownLatch.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <iostream>
+
+using namespace annety;
+using namespace std;
+
+// Microbenchmark of the cross-thread post (EventLoop::queue_in_own_loop).
+// |producers| threads post kTasks tasks each to one loop thread, reports 
+// the posts per second until all the tasks have run.
+namespace {
+const int kTasks = 1000000;
+
+void run(int producers)
+{
+	EventLoop* loop = nullptr;
+	CountDownLatch started(1);
+	Thread looper([&]() {
+		EventLoop l;
+		loop = &l;
+		started.count_down();
+		l.loop();
+	}, "loop");
+	looper.start();
+	started.wait();
+
+	int64_t total = static_cast<int64_t>(producers) * kTasks;
+	std::atomic<int64_t> done{0};
+	CountDownLatch finished(1);
+
+	std::vector<std::unique_ptr<Thread>> threads;
+	TimeStamp start = TimeStamp::now();
+	for (int i = 0; i < producers; ++i) {
+		threads.emplace_back(new Thread([&]() {
+			for (int j = 0; j < kTasks; ++j) {
+				loop->queue_in_own_loop([&]() {
+					// only the loop thread writes it.
+					int64_t n = done.load(std::memory_order_relaxed) + 1;
+					done.store(n, std::memory_order_relaxed);
+					if (n == total) {
+						finished.count_down();
+					}
+				});
+			}
+		}, "producer"));
+		threads.back()->start();
+	}
+	for (auto& td : threads) {
+		td->join();
+	}
+	finished.wait();
+	TimeDelta elapsed = TimeStamp::now() - start;
+
+	cout << producers << " producers\t" 
+		<< static_cast<int64_t>(total / elapsed.in_seconds_f()) << " posts/s\t"
+		<< elapsed.in_microseconds_f() * 1000 / total << "ns/post" << endl;
+
+	loop->quit();
+	looper.join();
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_WARNING);
+
+	const int producers[] = {1, 4, 16};
+	for (int n : producers) {
+		run(n);
+	}
+}
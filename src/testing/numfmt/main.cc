@@ -0,0 +1,81 @@
+#include "LogStream.h"
+#include "TimeStamp.h"
+
+#include <random>
+#include <vector>
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+
+using namespace annety;
+using namespace std;
+
+// The cost of formatting a number into LogStream, per call.
+// 1. int64: the random integers of all the lengths.
+// 2. metric: the latencies in milliseconds (such as 12.345).
+// 3. double: the random doubles of all the magnitudes.
+// snprintf("%.17g") is the reference of the double.
+namespace {
+const int kCalls = 10 * 1000 * 1000;
+const int kValues = 4096;
+
+int64_t g_bytes = 0;
+
+template <typename T>
+void bench_stream(const char* name, const vector<T>& values)
+{
+	LogStream stream;
+	TimeStamp start = TimeStamp::now();
+	for (int i = 0; i < kCalls; ++i) {
+		if (stream.buffer().readable_bytes() > LogStream::kMaxBufferSize - 64) {
+			g_bytes += stream.buffer().readable_bytes();
+			stream.reset();
+		}
+		stream << values[i % kValues] << ' ';
+	}
+	double ns = (TimeStamp::now() - start).in_microseconds_f() * 1000 / kCalls;
+	g_bytes += stream.buffer().readable_bytes();
+	cout << "  " << name << "\t" << ns << " ns/call" << endl;
+}
+
+void bench_snprintf(const char* name, const vector<double>& values)
+{
+	char buff[32];
+	TimeStamp start = TimeStamp::now();
+	for (int i = 0; i < kCalls; ++i) {
+		g_bytes += ::snprintf(buff, sizeof(buff), "%.17g", values[i % kValues]);
+	}
+	double ns = (TimeStamp::now() - start).in_microseconds_f() * 1000 / kCalls;
+	cout << "  " << name << "\t" << ns << " ns/call" << endl;
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	std::mt19937_64 rand(20261017);
+
+	vector<int64_t> ints;
+	vector<double> metrics;
+	vector<double> doubles;
+	for (int i = 0; i < kValues; ++i) {
+		ints.push_back(static_cast<int64_t>(rand() >> (rand() % 64)) * (i % 2? 1: -1));
+		metrics.push_back(static_cast<double>(rand() % 1000000) / 1000);
+
+		uint64_t bits = (rand() & 0x800FFFFFFFFFFFFF) | ((rand() % 2046 + 1) << 52);
+		double v;
+		::memcpy(&v, &bits, sizeof(v));
+		doubles.push_back(v);
+	}
+
+	cout << "LogStream" << endl;
+	bench_stream("int64", ints);
+	bench_stream("metric", metrics);
+	bench_stream("double", doubles);
+
+	cout << "snprintf(%.17g)" << endl;
+	bench_snprintf("metric", metrics);
+	bench_snprintf("double", doubles);
+
+	return g_bytes == 0;
+}
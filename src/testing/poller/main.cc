@@ -0,0 +1,143 @@
+
+#include "EventLoop.h"
+#include "Channel.h"
+#include "SelectableFD.h"
+#include "SocketsUtil.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+
+#include <memory>
+#include <vector>
+#include <iostream>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+
+using namespace annety;
+using namespace std;
+
+// Benchmark of the poll(2), epoll(4) level-triggered and epoll(4) edge-triggered
+// pollers. There are `connections` registered channels, most of them are idle,
+// a token is passed among `kActives` of them, every hop costs one loop wakeup.
+namespace {
+const int kActives = 100;
+const int kHops = 20000;
+
+struct PairFD
+{
+	std::unique_ptr<SelectableFD> rfd;
+	std::unique_ptr<SelectableFD> wfd;
+	std::unique_ptr<Channel> channel;
+};
+
+bool raise_fd_limit(rlim_t n)
+{
+	struct rlimit rl;
+	if (::getrlimit(RLIMIT_NOFILE, &rl) != 0) {
+		return false;
+	}
+	if (rl.rlim_cur >= n) {
+		return true;
+	}
+	rl.rlim_cur = std::min(n, rl.rlim_max);
+	return ::setrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur >= n;
+}
+
+const char* poller_name(EventLoop::PollerType type)
+{
+	switch (type) {
+	case EventLoop::kPollerPoll:
+		return "poll";
+	case EventLoop::kPollerEPoll:
+		return "epoll";
+	case EventLoop::kPollerEPollET:
+		return "epoll-et";
+	default:
+		return "default";
+	}
+}
+
+void run(EventLoop::PollerType type, int connections)
+{
+	EventLoop loop(type);
+
+	std::vector<PairFD> pairs(connections);
+	for (PairFD& p : pairs) {
+		int fds[2];
+		PCHECK(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) == 0);
+		p.rfd.reset(new SelectableFD(fds[0]));
+		p.wfd.reset(new SelectableFD(fds[1]));
+	}
+
+	const int actives = std::min(kActives, connections);
+	const int stride = connections / actives;
+
+	int hops = 0;
+	for (int i = 0; i < connections; ++i) {
+		PairFD& p = pairs[i];
+		p.channel.reset(new Channel(&loop, p.rfd.get()));
+		p.channel->set_edge_triggered(loop.is_edge_triggered());
+
+		int next = ((i / stride + 1) % actives) * stride;
+		SelectableFD* rfd = p.rfd.get();
+		SelectableFD* wfd = pairs[next].wfd.get();
+		bool et = loop.is_edge_triggered();
+		p.channel->set_read_callback([&loop, &hops, rfd, wfd, et](TimeStamp) {
+			char buf[64];
+			ssize_t n = 0;
+			do {
+				n = rfd->read(buf, sizeof buf);
+			} while (n > 0 && et);
+
+			if (++hops < kHops) {
+				char c = 'x';
+				PCHECK(wfd->write(&c, 1) == 1);
+			} else {
+				loop.quit();
+			}
+		});
+		p.channel->enable_read_event();
+	}
+
+	char c = 'x';
+	PCHECK(pairs[0].wfd->write(&c, 1) == 1);
+
+	TimeStamp start = TimeStamp::now();
+	loop.loop();
+	TimeDelta elapsed = TimeStamp::now() - start;
+
+	cout << poller_name(type) << "\t" << connections << "\t" << hops << "\t"
+		<< elapsed.in_milliseconds_f() << "ms\t"
+		<< elapsed.in_microseconds_f() / hops << "us/wakeup" << endl;
+
+	for (PairFD& p : pairs) {
+		p.channel->disable_all_event();
+		p.channel->remove();
+	}
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_WARNING);
+
+	const int connections[] = {1000, 10000, 50000};
+	const EventLoop::PollerType types[] = {
+		EventLoop::kPollerPoll,
+		EventLoop::kPollerEPoll,
+		EventLoop::kPollerEPollET
+	};
+
+	cout << "poller\tconns\thops\telapsed\tcost" << endl;
+	for (int conns : connections) {
+		if (!raise_fd_limit(2 * conns + 64)) {
+			cout << "skip " << conns << " connections, RLIMIT_NOFILE is too small" << endl;
+			continue;
+		}
+		for (EventLoop::PollerType type : types) {
+			run(type, conns);
+		}
+	}
+}
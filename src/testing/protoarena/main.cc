@@ -0,0 +1,155 @@
+
+#include "EventLoop.h"
+#include "NetBuffer.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+#include "strings/StringPrintf.h"
+#include "protobuf/ProtobufCodec.h"
+#include "protobuf/ProtobufDispatch.h"
+
+#include "Market.pb.h"
+
+#include <atomic>
+#include <string>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+
+using namespace annety;
+using namespace std;
+
+// The cost of ProtobufCodec::recv() per frame of a Snapshot message of 1000
+// repeated Quote, 16 frames per received batch. Reports the time and the 
+// heap allocations per frame.
+// 1. heap: the messages are New() (or reused), dispatched as MessagePtr.
+// 2. heap-held: as heap, but the callback holds the last message, so it is 
+//    not reused (New() per frame).
+// 3. arena: the messages are parsed on the arena of codec, dispatched as the
+//    borrowed ProtobufArenaMessage.
+namespace {
+std::atomic<int64_t> g_allocs{0};
+
+const int kQuotes = 1000;
+const int kBatch = 16;
+const int kRounds = 500;
+
+using namespace testing::market;
+
+int64_t g_sum = 0;
+
+void sum(const Snapshot& snapshot)
+{
+	for (const Quote& quote : snapshot.quotes()) {
+		g_sum += quote.volume() + quote.symbol().size();
+	}
+}
+
+void on_snapshot(const TcpConnectionPtr&, const std::shared_ptr<Snapshot>& mesg, TimeStamp)
+{
+	sum(*mesg);
+}
+
+std::shared_ptr<Snapshot> g_held;
+void on_held_snapshot(const TcpConnectionPtr&, const std::shared_ptr<Snapshot>& mesg, TimeStamp)
+{
+	sum(*mesg);
+	g_held = mesg;
+}
+
+void on_arena_snapshot(const TcpConnectionPtr&, Snapshot* mesg, TimeStamp)
+{
+	sum(*mesg);
+}
+
+void run(EventLoop* loop, const char* name, int mode, const NetBuffer& frames)
+{
+	using std::placeholders::_1;
+	using std::placeholders::_2;
+	using std::placeholders::_3;
+
+	ProtobufDispatch dispatch;
+	ProtobufCodec codec(loop, std::bind(&ProtobufDispatch::dispatch, &dispatch, _1, _2, _3));
+	if (mode == 0) {
+		dispatch.add<Snapshot>(on_snapshot);
+	} else if (mode == 1) {
+		dispatch.add<Snapshot>(on_held_snapshot);
+	} else {
+		dispatch.add_arena<Snapshot>(on_arena_snapshot);
+		codec.enable_arena(std::bind(&ProtobufDispatch::dispatch_arena, &dispatch, _1, _2, _3));
+	}
+
+	int64_t start_allocs = 0;
+	TimeStamp start;
+	for (int r = 0; r <= kRounds; ++r) {
+		if (r == 1) {
+			// Warm up the first round.
+			start_allocs = g_allocs.load(std::memory_order_relaxed);
+			start = TimeStamp::now();
+		}
+		NetBuffer buff;
+		buff.append(frames.begin_read(), frames.readable_bytes());
+		codec.recv(TcpConnectionPtr(), &buff, TimeStamp::now());
+		CHECK(buff.readable_bytes() == 0);
+	}
+	TimeDelta elapsed = TimeStamp::now() - start;
+	int64_t allocs = g_allocs.load(std::memory_order_relaxed) - start_allocs;
+
+	const int64_t total = static_cast<int64_t>(kBatch) * kRounds;
+	cout << name << "\t" << elapsed.in_microseconds_f() / total << "us/frame\t"
+		<< static_cast<double>(allocs) / total << " allocs/frame\t(" << g_sum << ")" << endl;
+}
+
+}	// namespace anonymous
+
+void* operator new(size_t size)
+{
+	g_allocs.fetch_add(1, std::memory_order_relaxed);
+	void* ptr = ::malloc(size == 0? 1: size);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	::free(ptr);
+}
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_WARNING);
+
+	Snapshot snapshot;
+	snapshot.set_seq(1);
+	for (int i = 0; i < kQuotes; ++i) {
+		Quote* quote = snapshot.add_quotes();
+		quote->set_id(i);
+		quote->set_symbol(string_printf("SYM%05d", i));
+		quote->set_bid(100.0 + i);
+		quote->set_ask(100.5 + i);
+		quote->set_volume(1000 + i);
+	}
+
+	EventLoop loop;
+	ProtobufCodec codec(&loop, nullptr);
+
+	NetBuffer frames;
+	for (int i = 0; i < kBatch; ++i) {
+		NetBuffer frame;
+		CHECK(codec.serialize_frame(snapshot, &frame));
+		frames.append(frame.begin_read(), frame.readable_bytes());
+	}
+
+	run(&loop, "heap", 0, frames);
+	run(&loop, "heap-held", 1, frames);
+	g_held.reset();
+	run(&loop, "arena", 2, frames);
+
+	google::protobuf::ShutdownProtobufLibrary();
+}
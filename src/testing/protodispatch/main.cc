@@ -0,0 +1,129 @@
+
+#include "EventLoop.h"
+#include "NetBuffer.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+#include "protobuf/ProtobufCodec.h"
+#include "protobuf/ProtobufDispatch.h"
+
+#include "Gateway.pb.h"
+
+#include <atomic>
+#include <string>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+
+using namespace annety;
+using namespace std;
+
+// The cost of ProtobufCodec::recv() per frame (decode, type lookup, parse and
+// dispatch), on a buffer of 1000 frames of 3 message types. Reports the time
+// and the heap allocations per frame.
+namespace {
+std::atomic<int64_t> g_allocs{0};
+
+const int kFrames = 1000;
+const int kRounds = 1000;
+
+using namespace testing::gateway;
+
+int64_t g_sum = 0;
+
+void on_login(const TcpConnectionPtr&, const std::shared_ptr<Login>& mesg, TimeStamp)
+{
+	g_sum += mesg->uid();
+}
+void on_heartbeat(const TcpConnectionPtr&, const std::shared_ptr<Heartbeat>& mesg, TimeStamp)
+{
+	g_sum += mesg->time();
+}
+void on_publish(const TcpConnectionPtr&, const std::shared_ptr<Publish>& mesg, TimeStamp)
+{
+	g_sum += mesg->payload().size();
+}
+
+}	// namespace anonymous
+
+void* operator new(size_t size)
+{
+	g_allocs.fetch_add(1, std::memory_order_relaxed);
+	void* ptr = ::malloc(size == 0? 1: size);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	::free(ptr);
+}
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_WARNING);
+
+	using std::placeholders::_1;
+	using std::placeholders::_2;
+	using std::placeholders::_3;
+
+	EventLoop loop;
+	ProtobufDispatch dispatch;
+	ProtobufCodec codec(&loop, std::bind(&ProtobufDispatch::dispatch, &dispatch, _1, _2, _3));
+	codec.set_message_reuse(true);
+	dispatch.add<Login>(on_login);
+	dispatch.add<Heartbeat>(on_heartbeat);
+	dispatch.add<Publish>(on_publish);
+
+	Login login;
+	login.set_uid(10001);
+	login.set_token(std::string(32, 't'));
+	Heartbeat heartbeat;
+	heartbeat.set_uid(10001);
+	heartbeat.set_time(1700000000);
+	Publish publish;
+	publish.set_uid(10001);
+	publish.set_topic("market.quote.top");
+	publish.set_payload(std::string(128, 'p'));
+	for (int i = 0; i < 8; ++i) {
+		publish.add_tags(i);
+	}
+
+	NetBuffer frames;
+	for (int i = 0; i < kFrames; ++i) {
+		const google::protobuf::Message* mesg = i % 4 == 0? 
+			static_cast<const google::protobuf::Message*>(&login): i % 4 == 1? 
+			static_cast<const google::protobuf::Message*>(&heartbeat): &publish;
+		NetBuffer frame;
+		CHECK(codec.serialize_frame(*mesg, &frame));
+		frames.append(frame.begin_read(), frame.readable_bytes());
+	}
+
+	int64_t start_allocs = 0;
+	TimeStamp start;
+	for (int r = 0; r <= kRounds; ++r) {
+		if (r == 1) {
+			// Warm up the first round.
+			start_allocs = g_allocs.load(std::memory_order_relaxed);
+			start = TimeStamp::now();
+		}
+		NetBuffer buff;
+		buff.append(frames.begin_read(), frames.readable_bytes());
+		codec.recv(TcpConnectionPtr(), &buff, TimeStamp::now());
+		CHECK(buff.readable_bytes() == 0);
+	}
+	TimeDelta elapsed = TimeStamp::now() - start;
+	int64_t allocs = g_allocs.load(std::memory_order_relaxed) - start_allocs;
+
+	const int64_t total = static_cast<int64_t>(kFrames) * kRounds;
+	cout << "recv\t" << elapsed.in_microseconds_f() * 1000 / total << "ns/frame\t"
+		<< static_cast<double>(allocs) / total << " allocs/frame\t(" << g_sum << ")" << endl;
+
+	google::protobuf::ShutdownProtobufLibrary();
+}
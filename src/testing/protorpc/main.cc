@@ -0,0 +1,181 @@
+
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "TcpClient.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+#include "synchronization/CountDownLatch.h"
+#include "protorpc/ProtorpcServer.h"
+#include "protorpc/ProtorpcChannel.h"
+
+#include "Echo.pb.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <iostream>
+
+using namespace annety;
+using namespace std;
+
+// Throughput and latency of protorpc on one connection, with 1, 64 and 
+// 1024 calls in flight. The server runs in another loop thread.
+namespace {
+const uint16_t kPort = 1673;
+const int kCalls = 100000;
+const int kPayload = 64;
+
+class EchoServiceImpl : public testing::EchoService
+{
+public:
+	virtual void Echo(::google::protobuf::RpcController* controller,
+					const testing::EchoRequest* request,
+					testing::EchoResponse* response,
+					::google::protobuf::Closure* done) override
+	{
+		response->set_id(request->id());
+		response->set_payload(request->payload());
+		done->Run();
+	}
+};
+
+class Bench
+{
+public:
+	Bench(EventLoop* loop, const EndPoint& addr)
+		: loop_(loop)
+		, channel_(new ProtorpcChannel(loop))
+		, stub_(channel_.get())
+		, payload_(kPayload, 'x')
+	{
+		using std::placeholders::_1;
+		using std::placeholders::_2;
+		using std::placeholders::_3;
+
+		client_ = make_tcp_client(loop, addr, "ProtorpcBench");
+		client_->set_connect_callback(
+			std::bind(&Bench::new_connection, this, _1));
+		client_->set_message_callback(
+			std::bind(&ProtorpcChannel::recv, channel_.get(), _1, _2, _3));
+	}
+
+	void connect()
+	{
+		client_->connect();
+	}
+
+private:
+	void new_connection(const TcpConnectionPtr& conn)
+	{
+		conn->set_tcp_nodelay(true);
+		channel_->attach_connection(conn);
+
+		start(windows_[0]);
+	}
+
+	void start(int window)
+	{
+		window_ = window;
+		issued_ = 0;
+		finished_ = 0;
+		latencies_.clear();
+		latencies_.reserve(kCalls);
+
+		start_ = TimeStamp::now();
+		for (int i = 0; i < window_; ++i) {
+			call();
+		}
+	}
+
+	void call()
+	{
+		testing::EchoRequest req;
+		req.set_id(++issued_);
+		req.set_payload(payload_);
+
+		// Delete in ProtorpcChannel::response().
+		testing::EchoResponse* resp = new testing::EchoResponse();
+		stub_.Echo(nullptr, &req, resp, 
+			::google::protobuf::NewCallback(this, &Bench::done, resp, TimeStamp::now()));
+	}
+
+	void done(testing::EchoResponse* resp, TimeStamp issued)
+	{
+		CHECK(resp->payload().size() == static_cast<size_t>(kPayload));
+		latencies_.push_back((TimeStamp::now() - issued).in_microseconds_f());
+
+		if (++finished_ == kCalls) {
+			report();
+			if (++round_ < 3) {
+				loop_->queue_in_own_loop(std::bind(&Bench::start, this, windows_[round_]));
+			} else {
+				client_->disconnect();
+				loop_->run_after(0.1, [this]() { loop_->quit();});
+			}
+		} else if (issued_ < kCalls) {
+			call();
+		}
+	}
+
+	void report()
+	{
+		TimeDelta elapsed = TimeStamp::now() - start_;
+		std::sort(latencies_.begin(), latencies_.end());
+		cout << "inflight " << window_ << "\t"
+			<< static_cast<int64_t>(kCalls / elapsed.in_seconds_f()) << " calls/s\t"
+			<< "p50 " << latencies_[latencies_.size() / 2] << "us\t"
+			<< "p99 " << latencies_[latencies_.size() * 99 / 100] << "us" << endl;
+	}
+
+private:
+	EventLoop* loop_;
+	TcpClientPtr client_;
+	ProtorpcChannelPtr channel_;
+	testing::EchoService::Stub stub_;
+
+	const int windows_[3] = {1, 64, 1024};
+	int round_{0};
+	int window_{0};
+	int issued_{0};
+	int finished_{0};
+	TimeStamp start_;
+	std::string payload_;
+	std::vector<double> latencies_;
+};
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_WARNING);
+
+	EchoServiceImpl impl;
+	EventLoopThread server_thread;
+	EventLoop* server_loop = server_thread.start_loop();
+
+	ProtorpcServer* server = nullptr;
+	CountDownLatch listened(1);
+	server_loop->run_in_own_loop([&]() {
+		server = new ProtorpcServer(server_loop, EndPoint(kPort));
+		server->add(&impl);
+		server->listen();
+		listened.count_down();
+	});
+	listened.wait();
+
+	{
+		EventLoop loop;
+		Bench bench(&loop, EndPoint("127.0.0.1", kPort));
+		bench.connect();
+		loop.loop();
+	}
+
+	CountDownLatch destroyed(1);
+	server_loop->run_in_own_loop([&]() {
+		delete server;
+		destroyed.count_down();
+	});
+	destroyed.wait();
+
+	google::protobuf::ShutdownProtobufLibrary();
+}
@@ -0,0 +1,133 @@
+
+#include "EventLoop.h"
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <malloc.h>
+
+using namespace annety;
+using namespace std;
+
+// Memory of the input buffers of idle connections.
+// kConnections clients (in the same process) connect to server, then each 
+// sends one kMessageSize message, and then be idle. Reports the resident memory 
+// heap in use after connected, after the messages, and after the idle 
+// input buffers are released.
+// 
+// Large-block throughput: one client sends kBlocks blocks of kBlockSize.
+namespace {
+const uint16_t kPort = 1671;
+const int kConnections = 5000;
+const int kMessageSize = 16 * 1024;
+
+const int kBlockSize = 1024 * 1024;
+const int kBlocks = 1000;
+
+double heap_mb()
+{
+	struct mallinfo2 mi = ::mallinfo2();
+	return static_cast<double>(mi.uordblks + mi.hblkhd) / (1024 * 1024);
+}
+
+void run_idle()
+{
+	EventLoop loop;
+
+	int connected = 0;
+	int received = 0;
+	int closed = 0;
+	double base_mb = heap_mb();
+	std::vector<TcpClientPtr> clients;
+	std::string message(kMessageSize, 'x');
+	
+	TcpServerPtr server = make_tcp_server(&loop, EndPoint(kPort), "ReadBufferServer");
+	server->set_connect_callback([&](const TcpConnectionPtr& conn) {
+		conn->set_input_shrink_delay(1.0);
+		if (++connected == kConnections) {
+			cout << "connected\t" << heap_mb() - base_mb << " MiB" << endl;
+			for (auto& client : clients) {
+				client->connection()->send(message);
+			}
+		}
+	});
+	server->set_close_callback([&](const TcpConnectionPtr&) {
+		if (++closed == kConnections) {
+			loop.run_after(0.5, [&]() { loop.quit();});
+		}
+	});
+	server->set_message_callback([&](const TcpConnectionPtr& conn, NetBuffer* buf, TimeStamp) {
+		buf->has_read_all();
+		if (++received == kConnections) {
+			cout << "received\t" << heap_mb() - base_mb << " MiB" << endl;
+			loop.run_after(2.0, [&]() {
+				cout << "idle\t\t" << heap_mb() - base_mb << " MiB" << endl;
+				for (auto& client : clients) {
+					client->disconnect();
+				}
+			});
+		}
+	});
+	server->listen();
+
+	for (int i = 0; i < kConnections; ++i) {
+		TcpClientPtr client = make_tcp_client(&loop, EndPoint("127.0.0.1", kPort), "ReadBufferClient");
+		client->connect();
+		clients.push_back(client);
+	}
+
+	loop.loop();
+}
+
+void run_throughput()
+{
+	EventLoop loop;
+
+	int64_t received = 0;
+	TimeStamp start;
+	TcpClientPtr client;
+	
+	TcpServerPtr server = make_tcp_server(&loop, EndPoint(kPort + 1), "ReadBufferServer");
+	server->set_message_callback([&](const TcpConnectionPtr& conn, NetBuffer* buf, TimeStamp) {
+		received += buf->readable_bytes();
+		buf->has_read_all();
+		if (received == int64_t{kBlockSize} * kBlocks) {
+			TimeDelta elapsed = TimeStamp::now() - start;
+			cout << "throughput\t" << kBlocks / elapsed.in_seconds_f() << " MiB/s" << endl;
+			client->disconnect();
+			loop.run_after(0.1, [&]() { loop.quit();});
+		}
+	});
+	server->listen();
+
+	int sent = 0;
+	std::string block(kBlockSize, 'x');
+	client = make_tcp_client(&loop, EndPoint("127.0.0.1", kPort + 1), "ReadBufferClient");
+	client->set_connect_callback([&](const TcpConnectionPtr& conn) {
+		start = TimeStamp::now();
+		sent++;
+		conn->send(block);
+	});
+	client->set_write_complete_callback([&](const TcpConnectionPtr& conn) {
+		if (sent++ < kBlocks) {
+			conn->send(block);
+		}
+	});
+	client->connect();
+
+	loop.loop();
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_WARNING);
+
+	run_idle();
+	run_throughput();
+}
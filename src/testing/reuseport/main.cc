@@ -0,0 +1,104 @@
+
+#include "EventLoop.h"
+#include "TcpServer.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+#include "threading/Thread.h"
+#include "synchronization/CountDownLatch.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <iostream>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+using namespace annety;
+using namespace std;
+
+// Benchmark of a short-lived connection storm.
+// The server (kWorkers worker loops) closes every connection once it is
+// established, kClients blocking client threads connect, wait for EOF and
+// reconnect for kSeconds, reports the connections per second of the 
+// single acceptor and the multi-acceptor (SO_REUSEPORT) mode.
+namespace {
+const uint16_t kPort = 1671;
+const int kWorkers = 4;
+const int kClients = 8;
+const double kSeconds = 3.0;
+
+void run(bool multi_acceptor)
+{
+	EventLoop* loop = nullptr;
+	CountDownLatch started(1);
+	std::atomic<int64_t> accepted{0};
+	Thread looper([&]() {
+		EventLoop l;
+		TcpServerPtr server = make_tcp_server(&l, EndPoint(kPort), "StormServer", true, true);
+		server->set_connect_callback([&](const TcpConnectionPtr& conn) {
+			accepted.fetch_add(1, std::memory_order_relaxed);
+			conn->shutdown();
+		});
+		server->set_close_callback([](const TcpConnectionPtr&) {});
+		server->set_thread_num(kWorkers);
+		server->set_multi_acceptor(multi_acceptor);
+		server->listen();
+
+		loop = &l;
+		started.count_down();
+		l.loop();
+	}, "server");
+	looper.start();
+	started.wait();
+
+	std::atomic<bool> stop{false};
+	std::atomic<int64_t> connections{0};
+	std::vector<std::unique_ptr<Thread>> clients;
+	for (int i = 0; i < kClients; ++i) {
+		clients.emplace_back(new Thread([&]() {
+			struct sockaddr_in addr;
+			::memset(&addr, 0, sizeof addr);
+			addr.sin_family = AF_INET;
+			addr.sin_port = htons(kPort);
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			while (!stop.load(std::memory_order_relaxed)) {
+				int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+				if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof addr) == 0) {
+					char buf[16];
+					while (::read(fd, buf, sizeof buf) > 0) {}
+					connections.fetch_add(1, std::memory_order_relaxed);
+				}
+				::close(fd);
+			}
+		}, "client"));
+		clients.back()->start();
+	}
+
+	TimeStamp start = TimeStamp::now();
+	::usleep(static_cast<useconds_t>(kSeconds * 1000 * 1000));
+	stop = true;
+	for (auto& client : clients) {
+		client->join();
+	}
+	TimeDelta elapsed = TimeStamp::now() - start;
+
+	cout << (multi_acceptor? "multi-acceptor": "single-acceptor") << "\t"
+		<< static_cast<int64_t>(connections.load() / elapsed.in_seconds_f()) << " conns/s\t"
+		<< "accepted " << accepted.load() << endl;
+
+	loop->quit();
+	looper.join();
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_WARNING);
+
+	run(false);
+	run(true);
+}
@@ -0,0 +1,215 @@
+
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "TcpClient.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+#include "threading/ThreadPool.h"
+#include "synchronization/CountDownLatch.h"
+#include "protorpc/ProtorpcServer.h"
+#include "protorpc/ProtorpcChannel.h"
+
+#include "Pool.pb.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include <unistd.h>
+
+using namespace annety;
+using namespace std;
+
+// Latency of a fast method, while a slow method (1ms) is flooded by another
+// connection of the same server loop, 64 slow calls in flight.
+// 1. inline: all methods run in the loop of connection.
+// 2. pool: the slow service runs in a ThreadPool of 4 threads, and 16 queued
+//    tasks at most, the slow connection stops reading when it is full.
+namespace {
+const int kSlowWindow = 64;
+const int kSlowUs = 1000;
+const double kSeconds = 2.0;
+
+class SlowServiceImpl : public testing::SlowService
+{
+public:
+	virtual void Sleep(::google::protobuf::RpcController* controller,
+					const testing::PoolRequest* request,
+					testing::PoolResponse* response,
+					::google::protobuf::Closure* done) override
+	{
+		::usleep(static_cast<useconds_t>(request->sleep_us()));
+		response->set_id(request->id());
+		done->Run();
+	}
+};
+
+class FastServiceImpl : public testing::FastService
+{
+public:
+	virtual void Echo(::google::protobuf::RpcController* controller,
+					const testing::PoolRequest* request,
+					testing::PoolResponse* response,
+					::google::protobuf::Closure* done) override
+	{
+		response->set_id(request->id());
+		done->Run();
+	}
+};
+
+// Keeps |window| calls of |method| in flight on one connection.
+class Caller
+{
+public:
+	Caller(EventLoop* loop, const EndPoint& addr,
+		const ::google::protobuf::MethodDescriptor* method, int window, int sleep_us)
+		: channel_(new ProtorpcChannel(loop))
+		, method_(method)
+		, window_(window)
+		, sleep_us_(sleep_us)
+	{
+		using std::placeholders::_1;
+		using std::placeholders::_2;
+		using std::placeholders::_3;
+
+		client_ = make_tcp_client(loop, addr, "PoolCaller");
+		client_->set_connect_callback(
+			std::bind(&Caller::new_connection, this, _1));
+		client_->set_message_callback(
+			std::bind(&ProtorpcChannel::recv, channel_.get(), _1, _2, _3));
+	}
+
+	void connect()
+	{
+		client_->connect();
+	}
+
+	void stop()
+	{
+		stopped_ = true;
+		client_->disconnect();
+	}
+
+	void report(const char* name)
+	{
+		std::sort(latencies_.begin(), latencies_.end());
+		cout << "  " << name << "\t"
+			<< static_cast<int64_t>(latencies_.size() / kSeconds) << " calls/s";
+		if (!latencies_.empty()) {
+			cout << "\tp50 " << latencies_[latencies_.size() / 2] << "us"
+				<< "\tp99 " << latencies_[latencies_.size() * 99 / 100] << "us";
+		}
+		cout << endl;
+	}
+
+private:
+	void new_connection(const TcpConnectionPtr& conn)
+	{
+		conn->set_tcp_nodelay(true);
+		channel_->attach_connection(conn);
+
+		for (int i = 0; i < window_; ++i) {
+			call();
+		}
+	}
+
+	void call()
+	{
+		testing::PoolRequest req;
+		req.set_id(++issued_);
+		req.set_sleep_us(sleep_us_);
+
+		// Delete in ProtorpcChannel::response().
+		testing::PoolResponse* resp = new testing::PoolResponse();
+		channel_->CallMethod(method_, nullptr, &req, resp,
+			::google::protobuf::NewCallback(this, &Caller::done, TimeStamp::now()));
+	}
+
+	void done(TimeStamp issued)
+	{
+		if (stopped_) {
+			return;
+		}
+		latencies_.push_back((TimeStamp::now() - issued).in_microseconds_f());
+		call();
+	}
+
+private:
+	TcpClientPtr client_;
+	ProtorpcChannelPtr channel_;
+	const ::google::protobuf::MethodDescriptor* method_;
+	const int window_;
+	const int sleep_us_;
+
+	bool stopped_{false};
+	int64_t issued_{0};
+	std::vector<double> latencies_;
+};
+
+void run(const char* name, uint16_t port, bool offload)
+{
+	SlowServiceImpl slow;
+	FastServiceImpl fast;
+
+	ThreadPool pool(4, "rpcpool");
+	pool.set_max_task_size(16);
+	pool.start();
+
+	EventLoopThread server_thread;
+	EventLoop* server_loop = server_thread.start_loop();
+
+	ProtorpcServer* server = nullptr;
+	CountDownLatch listened(1);
+	server_loop->run_in_own_loop([&]() {
+		server = new ProtorpcServer(server_loop, EndPoint(port));
+		server->add(&slow, offload? &pool: nullptr);
+		server->add(&fast);
+		server->listen();
+		listened.count_down();
+	});
+	listened.wait();
+
+	{
+		EventLoop loop;
+		EndPoint addr("127.0.0.1", port);
+		Caller slow_caller(&loop, addr,
+			testing::SlowService::descriptor()->FindMethodByName("Sleep"), kSlowWindow, kSlowUs);
+		Caller fast_caller(&loop, addr,
+			testing::FastService::descriptor()->FindMethodByName("Echo"), 1, 0);
+		slow_caller.connect();
+		fast_caller.connect();
+
+		loop.run_after(kSeconds, [&]() {
+			slow_caller.stop();
+			fast_caller.stop();
+			loop.run_after(0.1, [&]() { loop.quit();});
+		});
+		loop.loop();
+
+		cout << name << endl;
+		slow_caller.report("slow");
+		fast_caller.report("fast");
+	}
+
+	CountDownLatch destroyed(1);
+	server_loop->run_in_own_loop([&]() {
+		cout << server->stats_string();
+		delete server;
+		destroyed.count_down();
+	});
+	destroyed.wait();
+
+	pool.joinall();
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_ERROR);
+
+	run("inline", 1675, false);
+	run("pool", 1676, true);
+
+	google::protobuf::ShutdownProtobufLibrary();
+}
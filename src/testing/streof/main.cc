@@ -0,0 +1,76 @@
+#include "EventLoop.h"
+#include "NetBuffer.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+#include "codec/StringEofCodec.h"
+
+#include <string>
+#include <algorithm>
+#include <iostream>
+
+using namespace annety;
+using namespace std;
+
+// The throughput of StringEofCodec ("\r\n") on a stream of 16 bytes lines
+// and 4KB lines, the stream is received by the chunks of 64KB and 1KB (the
+// frames are split by the reads).
+// Reports the throughput, and the frames decoded (must be equal to the lines).
+namespace {
+const size_t kStreamSize = 1024 * 1024;
+const int kRounds = 200;
+
+int64_t g_frames = 0;
+int64_t g_sum = 0;
+
+void on_message(const TcpConnectionPtr&, const StringPiece& payload, TimeStamp)
+{
+	g_frames++;
+	g_sum += payload.size();
+}
+
+void run(EventLoop* loop, size_t line, size_t chunk)
+{
+	StringEofCodec codec(loop, "\r\n");
+	codec.set_message_callback(on_message);
+
+	// The payload has no '\r' nor '\n'.
+	std::string stream;
+	int64_t lines = 0;
+	while (stream.size() + line + 2 <= kStreamSize) {
+		for (size_t i = 0; i < line; ++i) {
+			stream.push_back(static_cast<char>('a' + (i * 7 + lines) % 26));
+		}
+		stream.append("\r\n");
+		lines++;
+	}
+
+	g_frames = 0;
+	NetBuffer buff;
+	TimeStamp start = TimeStamp::now();
+	for (int r = 0; r < kRounds; ++r) {
+		for (size_t off = 0; off < stream.size(); off += chunk) {
+			buff.append(stream.data() + off, std::min(chunk, stream.size() - off));
+			codec.recv(TcpConnectionPtr(), &buff, TimeStamp::now());
+		}
+	}
+	TimeDelta elapsed = TimeStamp::now() - start;
+
+	const double bytes = static_cast<double>(stream.size()) * kRounds;
+	cout << "line " << line << "B\tchunk " << chunk << "B\t"
+		<< bytes / elapsed.in_microseconds_f() / 1000 << " GB/s\t"
+		<< elapsed.in_microseconds_f() * 1000 / (lines * kRounds) << " ns/frame\t"
+		<< "frames " << g_frames << "/" << lines * kRounds << endl;
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_WARNING);
+
+	EventLoop loop;
+	run(&loop, 16, 64 * 1024);
+	run(&loop, 16, 1024);
+	run(&loop, 4096, 64 * 1024);
+	run(&loop, 4096, 1024);
+}
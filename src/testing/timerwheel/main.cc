@@ -0,0 +1,83 @@
+
+#include "EventLoop.h"
+#include "TimeStamp.h"
+#include "Logging.h"
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <stdlib.h>
+
+using namespace annety;
+using namespace std;
+
+// Benchmark of the tree and timing wheel timer pools.
+// 1. kConnections idle timers (30s) are reset kRounds times, as if every
+//    connection has received a message.
+// 2. kShortTimers timers expire in 1~500ms, reports the lateness.
+namespace {
+const int kConnections = 100000;
+const int kRounds = 10;
+const int kShortTimers = 10000;
+
+const char* timer_name(EventLoop::TimerType type)
+{
+	return type == EventLoop::kTimerWheel? "wheel": "tree";
+}
+
+void run(EventLoop::TimerType type)
+{
+	EventLoop loop(EventLoop::kPollerDefault, type);
+
+	std::vector<TimerId> idles(kConnections);
+	for (int i = 0; i < kConnections; ++i) {
+		idles[i] = loop.run_after(30.0, []() {});
+	}
+
+	TimeStamp start = TimeStamp::now();
+	for (int r = 0; r < kRounds; ++r) {
+		for (int i = 0; i < kConnections; ++i) {
+			loop.cancel(idles[i]);
+			idles[i] = loop.run_after(30.0, []() {});
+		}
+	}
+	TimeDelta elapsed = TimeStamp::now() - start;
+
+	// The short timers.
+	int fired = 0;
+	std::vector<double> lateness;
+	lateness.reserve(kShortTimers);
+	::srand(1);
+	for (int i = 0; i < kShortTimers; ++i) {
+		TimeStamp expired = TimeStamp::now() + TimeDelta::from_milliseconds(1 + ::rand() % 500);
+		loop.run_at(expired, [&, expired]() {
+			double late = (TimeStamp::now() - expired).in_microseconds_f();
+			CHECK_GE(late, 0.0) << "timer expired early";
+			lateness.push_back(late);
+			if (++fired == kShortTimers) {
+				loop.quit();
+			}
+		});
+	}
+	loop.loop();
+
+	std::sort(lateness.begin(), lateness.end());
+	cout << timer_name(type) << "\t"
+		<< elapsed.in_microseconds_f() * 1000 / (kConnections * kRounds) << "ns/reset\t"
+		<< "late p50 " << lateness[lateness.size() / 2] << "us\t"
+		<< "p99 " << lateness[lateness.size() * 99 / 100] << "us" << endl;
+
+	for (int i = 0; i < kConnections; ++i) {
+		loop.cancel(idles[i]);
+	}
+}
+
+}	// namespace anonymous
+
+int main(int argc, char* argv[])
+{
+	set_min_log_severity(LOG_WARNING);
+
+	run(EventLoop::kTimerTree);
+	run(EventLoop::kTimerWheel);
+}
@@ -0,0 +1,110 @@
+#include "Crc32c.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace annety;
+using namespace std;
+
+namespace {
+// The bitwise reflected crc32 of |polynomial|, the reference of the tables
+// and the SSE4.2 instruction.
+uint32_t crc32_bitwise(uint32_t polynomial, const char* buff, size_t len)
+{
+	uint32_t crc = 0xffffffff;
+	for (size_t i = 0; i < len; ++i) {
+		crc ^= static_cast<unsigned char>(buff[i]);
+		for (int k = 0; k < 8; ++k) {
+			crc = (crc >> 1) ^ (polynomial & (0 - (crc & 1)));
+		}
+	}
+	return crc ^ 0xffffffff;
+}
+
+uint32_t crc32c_bitwise(const char* buff, size_t len)
+{
+	return crc32_bitwise(0x82F63B78, buff, len);
+}
+
+uint32_t crc32_ieee_bitwise(const char* buff, size_t len)
+{
+	return crc32_bitwise(0xEDB88320, buff, len);
+}
+
+std::vector<char> random_bytes(std::mt19937_64& rand, size_t len)
+{
+	std::vector<char> bytes(len);
+	for (char& c : bytes) {
+		c = static_cast<char>(rand());
+	}
+	return bytes;
+}
+
+}	// namespace anonymous
+
+TEST (Crc32c_unittest, check_values)
+{
+	const string digits = "123456789";
+	ASSERT_EQ(Crc32c::crc32c(digits.data(), digits.size()), 0xE3069283u);
+	ASSERT_EQ(Crc32c::crc32_ieee(digits.data(), digits.size()), 0xCBF43926u);
+	ASSERT_EQ(Crc32c::crc32_long(digits), 0xCBF43926u);
+	ASSERT_EQ(Crc32c::crc32_short(digits), 0xCBF43926u);
+
+	ASSERT_EQ(Crc32c::crc32c(nullptr, 0), 0u);
+	ASSERT_EQ(Crc32c::crc32_ieee(nullptr, 0), 0u);
+
+	// RFC 3720 (iSCSI) B.4, 32 bytes of zeros and of ones.
+	const string zeros(32, '\x00');
+	const string ones(32, '\xff');
+	ASSERT_EQ(Crc32c::crc32c(zeros.data(), zeros.size()), 0x8A9136AAu);
+	ASSERT_EQ(Crc32c::crc32c(ones.data(), ones.size()), 0x62A8AB43u);
+}
+
+TEST (Crc32c_unittest, lengths_and_alignments)
+{
+	std::mt19937_64 rand(20261017);
+
+	// The lengths around the blocks of slicing-by-8 and the interleaved
+	// streams of SSE4.2, at all the alignments of a 64 bytes line.
+	std::vector<size_t> lengths;
+	for (size_t len = 0; len <= 1100; ++len) {
+		lengths.push_back(len);
+	}
+	for (size_t len : {2047, 2048, 2049, 4095, 4096, 4097, 8192 + 7, 65536 + 13, 262144 + 3}) {
+		lengths.push_back(len);
+	}
+
+	for (size_t len : lengths) {
+		const std::vector<char> bytes = random_bytes(rand, len + 64);
+		for (size_t align = 0; align < 64; align += (len > 1100? 7: 1)) {
+			const char* buff = bytes.data() + align;
+			const uint32_t expect = crc32c_bitwise(buff, len);
+			ASSERT_EQ(Crc32c::crc32c(buff, len), expect) << "len=" << len << " align=" << align;
+			ASSERT_EQ(Crc32c::checksum(Crc32c::kCrc32Castagnoli, buff, len), expect);
+
+			const uint32_t ieee = crc32_ieee_bitwise(buff, len);
+			ASSERT_EQ(Crc32c::crc32_ieee(buff, len), ieee) << "len=" << len << " align=" << align;
+			ASSERT_EQ(Crc32c::checksum(Crc32c::kCrc32Ieee, buff, len), ieee);
+			ASSERT_EQ(Crc32c::crc32_long(buff, len), ieee);
+		}
+	}
+}
+
+TEST (Crc32c_unittest, extend)
+{
+	std::mt19937_64 rand(20261017);
+
+	for (int i = 0; i < 2000; ++i) {
+		const size_t len = rand() % 5000;
+		const std::vector<char> bytes = random_bytes(rand, len);
+		const size_t split = len? rand() % (len + 1): 0;
+
+		uint32_t crc = Crc32c::crc32c(bytes.data(), split);
+		crc = Crc32c::crc32c_extend(crc, bytes.data() + split, len - split);
+		ASSERT_EQ(crc, crc32c_bitwise(bytes.data(), len)) << "len=" << len << " split=" << split;
+	}
+}
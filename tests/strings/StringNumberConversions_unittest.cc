@@ -0,0 +1,323 @@
+#include "strings/StringNumberConversions.h"
+#include "LogStream.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+using namespace annety;
+using namespace std;
+
+namespace {
+string format_i(int64_t v)
+{
+	char buff[kMaxIntegerFormatSize];
+	return string(buff, format_int64(buff, v));
+}
+
+string format_u(uint64_t v)
+{
+	char buff[kMaxIntegerFormatSize];
+	return string(buff, format_uint64(buff, v));
+}
+
+string format_d(double v)
+{
+	char buff[kMaxDoubleFormatSize];
+	return string(buff, format_double(buff, v));
+}
+
+string format_f(float v)
+{
+	char buff[kMaxFloatFormatSize];
+	return string(buff, format_float(buff, v));
+}
+
+string printf_i(int64_t v)
+{
+	char buff[32];
+	return string(buff, ::snprintf(buff, sizeof(buff), "%" PRId64, v));
+}
+
+string printf_u(uint64_t v)
+{
+	char buff[32];
+	return string(buff, ::snprintf(buff, sizeof(buff), "%" PRIu64, v));
+}
+
+double from_bits(uint64_t bits)
+{
+	double v;
+	::memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+// The expected text of format_double(): the shortest digits of printf
+// ("%.*e") that round trip, in the notation of "%.17g".
+string printf_d(double v)
+{
+	char buff[64];
+	int precision = 1;
+	for (; precision < 17; ++precision) {
+		::snprintf(buff, sizeof(buff), "%.*e", precision - 1, v);
+		if (::strtod(buff, nullptr) == v) {
+			break;
+		}
+	}
+	::snprintf(buff, sizeof(buff), "%.*e", precision - 1, v);
+
+	string sign, digits;
+	const char* p = buff;
+	if (*p == '-') {
+		sign = "-";
+		p++;
+	}
+	for (; *p != 'e'; ++p) {
+		if (*p != '.') {
+			digits += *p;
+		}
+	}
+	int e = ::atoi(p + 1);
+	while (digits.size() > 1 && digits.back() == '0') {
+		digits.pop_back();
+	}
+
+	const int len = static_cast<int>(digits.size());
+	if (e < -4 || e >= 17) {
+		string mant = digits.substr(0, 1);
+		if (len > 1) {
+			mant += "." + digits.substr(1);
+		}
+		::snprintf(buff, sizeof(buff), "e%c%02d", e < 0? '-': '+', e < 0? -e: e);
+		return sign + mant + buff;
+	} else if (e >= len - 1) {
+		return sign + digits + string(e - (len - 1), '0');
+	} else if (e >= 0) {
+		return sign + digits.substr(0, e + 1) + "." + digits.substr(e + 1);
+	} else {
+		return sign + "0." + string(-e - 1, '0') + digits;
+	}
+}
+
+float from_bits32(uint32_t bits)
+{
+	float v;
+	::memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+// The fewest significant digits of printf("%.*e") that round trip as a
+// float by strtof().
+size_t printf_f_digits(float v)
+{
+	char buff[64];
+	int precision = 1;
+	for (; precision < 9; ++precision) {
+		::snprintf(buff, sizeof(buff), "%.*e", precision - 1, static_cast<double>(v));
+		if (::strtof(buff, nullptr) == v) {
+			break;
+		}
+	}
+	return precision;
+}
+
+// The number of significant digits of the text of format_double(), the
+// trailing zeros of "ddd000" are not counted.
+size_t significant_digits(const string& text)
+{
+	size_t n = 0, zeros = 0;
+	bool leading = true;
+	for (char c : text) {
+		if (c == 'e') {
+			break;
+		}
+		if (c >= '1' && c <= '9') {
+			leading = false;
+		}
+		if (!leading && c >= '0' && c <= '9') {
+			n++;
+			zeros = c == '0'? zeros + 1: 0;
+		}
+	}
+	return n - zeros;
+}
+
+}	// namespace anonymous
+
+TEST (StringNumberConversions_unittest, format_integer)
+{
+	ASSERT_EQ(format_i(0), "0");
+	ASSERT_EQ(format_i(-1), "-1");
+	ASSERT_EQ(format_i(std::numeric_limits<int64_t>::max()), "9223372036854775807");
+	ASSERT_EQ(format_i(std::numeric_limits<int64_t>::min()), "-9223372036854775808");
+	ASSERT_EQ(format_u(std::numeric_limits<uint64_t>::max()), "18446744073709551615");
+
+	char buff[kMaxIntegerFormatSize];
+	ASSERT_EQ(string(buff, format_integer(buff, std::numeric_limits<int>::min())), "-2147483648");
+	ASSERT_EQ(string(buff, format_integer(buff, std::numeric_limits<unsigned>::max())), "4294967295");
+	ASSERT_EQ(string(buff, format_integer(buff, static_cast<short>(-123))), "-123");
+
+	// All the powers of ten, and their neighbours.
+	uint64_t p = 1;
+	for (int i = 0; i < 20; ++i, p *= 10) {
+		ASSERT_EQ(format_u(p), printf_u(p));
+		ASSERT_EQ(format_u(p - 1), printf_u(p - 1));
+		ASSERT_EQ(format_u(p + 1), printf_u(p + 1));
+		ASSERT_EQ(format_i(-static_cast<int64_t>(p / 10)), printf_i(-static_cast<int64_t>(p / 10)));
+	}
+
+	// Exhaustive on small numbers.
+	for (int64_t v = -100000; v <= 100000; ++v) {
+		ASSERT_EQ(format_i(v), printf_i(v));
+	}
+
+	// Random numbers of all the lengths.
+	std::mt19937_64 rand(20261017);
+	for (int i = 0; i < 1000000; ++i) {
+		const uint64_t v = rand() >> (rand() % 64);
+		ASSERT_EQ(format_u(v), printf_u(v));
+		ASSERT_EQ(format_i(static_cast<int64_t>(v)), printf_i(static_cast<int64_t>(v)));
+	}
+}
+
+TEST (StringNumberConversions_unittest, format_hex)
+{
+	char buff[kMaxHexFormatSize];
+	ASSERT_EQ(string(buff, format_hex(buff, 0)), "0");
+	ASSERT_EQ(string(buff, format_hex(buff, 0xABCDEF)), "ABCDEF");
+	ASSERT_EQ(string(buff, format_hex(buff, std::numeric_limits<uint64_t>::max())), "FFFFFFFFFFFFFFFF");
+
+	std::mt19937_64 rand(20261017);
+	for (int i = 0; i < 100000; ++i) {
+		const uint64_t v = rand() >> (rand() % 64);
+		char expect[32];
+		const int len = ::snprintf(expect, sizeof(expect), "%" PRIX64, v);
+		ASSERT_EQ(string(buff, format_hex(buff, v)), string(expect, len));
+	}
+}
+
+TEST (StringNumberConversions_unittest, format_double)
+{
+	ASSERT_EQ(format_d(0.0), "0");
+	ASSERT_EQ(format_d(-0.0), "-0");
+	ASSERT_EQ(format_d(1.0), "1");
+	ASSERT_EQ(format_d(-1.5), "-1.5");
+	ASSERT_EQ(format_d(100.0), "100");
+	ASSERT_EQ(format_d(0.1), "0.1");
+	ASSERT_EQ(format_d(0.1 + 0.2), "0.30000000000000004");
+	ASSERT_EQ(format_d(123.456), "123.456");
+	ASSERT_EQ(format_d(0.0001), "0.0001");
+	ASSERT_EQ(format_d(0.00001), "1e-05");
+	ASSERT_EQ(format_d(1e16), "10000000000000000");
+	ASSERT_EQ(format_d(1e17), "1e+17");
+	ASSERT_EQ(format_d(1.5e300), "1.5e+300");
+	ASSERT_EQ(format_d(std::numeric_limits<double>::max()), "1.7976931348623157e+308");
+	ASSERT_EQ(format_d(std::numeric_limits<double>::min()), "2.2250738585072014e-308");
+	ASSERT_EQ(format_d(std::numeric_limits<double>::denorm_min()), "5e-324");
+	ASSERT_EQ(format_d(std::numeric_limits<double>::infinity()), "inf");
+	ASSERT_EQ(format_d(-std::numeric_limits<double>::infinity()), "-inf");
+	ASSERT_EQ(format_d(std::numeric_limits<double>::quiet_NaN()), "nan");
+
+	// The powers of two and their neighbours. The lower boundary of a power
+	// of two is closer, so the shortest digits may be not the rounded ones
+	// of printf, but they are not longer.
+	for (uint64_t e = 1; e < 0x7FF; ++e) {
+		const uint64_t bits = e << 52;
+		const string text = format_d(from_bits(bits));
+		ASSERT_EQ(::strtod(text.c_str(), nullptr), from_bits(bits)) << text;
+		ASSERT_LE(significant_digits(text), significant_digits(printf_d(from_bits(bits)))) << text;
+
+		ASSERT_EQ(format_d(from_bits(bits - 1)), printf_d(from_bits(bits - 1)));
+		ASSERT_EQ(format_d(from_bits(bits + 1)), printf_d(from_bits(bits + 1)));
+	}
+
+	// The consecutive doubles around 1 and the subnormals.
+	for (uint64_t i = 0; i < 100000; ++i) {
+		const double v = from_bits(0x3FF0000000000000 + i);
+		ASSERT_EQ(format_d(v), printf_d(v));
+		ASSERT_EQ(format_d(from_bits(i)), printf_d(from_bits(i)));
+	}
+
+	// Random bit patterns, and the short decimals.
+	std::mt19937_64 rand(20261017);
+	for (int i = 0; i < 300000; ++i) {
+		double v = from_bits(rand());
+		if (v != v || v == std::numeric_limits<double>::infinity() ||
+			v == -std::numeric_limits<double>::infinity()) {
+			continue;
+		}
+		string text = format_d(v);
+		ASSERT_EQ(::strtod(text.c_str(), nullptr), v) << text;
+		ASSERT_EQ(text, printf_d(v));
+
+		v = static_cast<double>(static_cast<int64_t>(rand() % 100000000) - 50000000) / 1000;
+		ASSERT_EQ(format_d(v), printf_d(v));
+	}
+}
+
+TEST (StringNumberConversions_unittest, format_float)
+{
+	ASSERT_EQ(format_f(0.0f), "0");
+	ASSERT_EQ(format_f(-0.0f), "-0");
+	ASSERT_EQ(format_f(1.0f), "1");
+	ASSERT_EQ(format_f(-1.5f), "-1.5");
+	ASSERT_EQ(format_f(0.1f), "0.1");
+	ASSERT_EQ(format_f(0.1f + 0.2f), "0.3");
+	ASSERT_EQ(format_f(123.456f), "123.456");
+	ASSERT_EQ(format_f(0.0001f), "0.0001");
+	ASSERT_EQ(format_f(0.00001f), "1e-05");
+	ASSERT_EQ(format_f(16777216.0f), "16777216");
+	ASSERT_EQ(format_f(1e9f), "1e+09");
+	ASSERT_EQ(format_f(std::numeric_limits<float>::max()), "3.4028235e+38");
+	ASSERT_EQ(format_f(std::numeric_limits<float>::min()), "1.1754944e-38");
+	ASSERT_EQ(format_f(-std::numeric_limits<float>::min()), "-1.1754944e-38");
+	ASSERT_EQ(format_f(std::numeric_limits<float>::denorm_min()), "1e-45");
+	ASSERT_EQ(format_f(std::numeric_limits<float>::infinity()), "inf");
+	ASSERT_EQ(format_f(-std::numeric_limits<float>::infinity()), "-inf");
+	ASSERT_EQ(format_f(std::numeric_limits<float>::quiet_NaN()), "nan");
+
+	// All the floats of some exponents, and random bit patterns. They round 
+	// trip by strtof(), with no more digits than the shortest of printf.
+	std::mt19937_64 rand(20261017);
+	for (uint32_t i = 0; i < 2000000; ++i) {
+		uint32_t bits = i < 1000000? 0x3F800000 + i: static_cast<uint32_t>(rand());
+		if (i % 2 == 1 && i < 1000000) {
+			bits = i;	// the subnormals
+		}
+		const float v = from_bits32(bits);
+		if (v != v || v == std::numeric_limits<float>::infinity() ||
+			v == -std::numeric_limits<float>::infinity()) {
+			continue;
+		}
+		const string text = format_f(v);
+		ASSERT_EQ(::strtof(text.c_str(), nullptr), v) << text;
+		ASSERT_LE(significant_digits(text), printf_f_digits(v)) << text;
+	}
+}
+
+TEST (StringNumberConversions_unittest, number_to_string)
+{
+	ASSERT_EQ(number_to_string(-12345), "-12345");
+	ASSERT_EQ(number_to_string(12345u), "12345");
+	ASSERT_EQ(number_to_string(-12345l), "-12345");
+	ASSERT_EQ(number_to_string(12345ul), "12345");
+	ASSERT_EQ(number_to_string(-12345.345), "-12345.345");
+}
+
+TEST (StringNumberConversions_unittest, log_stream)
+{
+	LogStream stream;
+	stream << -12345.345 << "#" << 0.1 << "#" << static_cast<size_t>(1024)
+		<< "#" << static_cast<short>(-7) << "#" << reinterpret_cast<const void*>(0x1F);
+	ASSERT_EQ(stream.buffer().to_string(), "-12345.345#0.1#1024#-7#0x1F");
+
+	LogStream floats;
+	floats << 0.1f << "#" << -2.5e-10f << "#" << 3.14159f;
+	ASSERT_EQ(floats.buffer().to_string(), "0.1#-2.5e-10#3.14159");
+}
@@ -0,0 +1,86 @@
+#include "strings/StringUtil.h"
+#include "strings/StringPiece.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace annety;
+using namespace std;
+
+namespace {
+// ASSERT_EQ() binds the reference, copy the value of StringPiece::npos.
+const size_t kNpos = StringPiece::npos;
+
+size_t expect_find(const string& str, const string& needle, size_t pos)
+{
+	size_t n = str.find(needle, pos);
+	return n == string::npos? kNpos: n;
+}
+
+}	// namespace anonymous
+
+TEST (StringUtil_unittest, find_substring)
+{
+	ASSERT_EQ(find_substring("hello\r\nworld", "\r\n"), 5u);
+	ASSERT_EQ(find_substring("hello\r\nworld", "\r\n", 6), kNpos);
+	ASSERT_EQ(find_substring("hello", ""), 0u);
+	ASSERT_EQ(find_substring("hello", "", 5), 5u);
+	ASSERT_EQ(find_substring("hello", "", 6), kNpos);
+	ASSERT_EQ(find_substring("", "a"), kNpos);
+	ASSERT_EQ(find_substring("abc", "abcd"), kNpos);
+	ASSERT_EQ(find_substring("abc", "abc"), 0u);
+	ASSERT_EQ(find_substring(StringPiece("a\0b\0c", 5), StringPiece("\0c", 2)), 3u);
+
+	// The match at the last position of a block, and across the blocks.
+	for (size_t len = 2; len < 200; ++len) {
+		string str(len, 'x');
+		str[len - 2] = '\r';
+		str[len - 1] = '\n';
+		ASSERT_EQ(find_substring(str, "\r\n"), len - 2) << "len=" << len;
+		ASSERT_EQ(find_substring(str, "x\r\n"), len > 2? len - 3: kNpos);
+	}
+}
+
+TEST (StringUtil_unittest, find_substring_random)
+{
+	std::mt19937_64 rand(20261017);
+
+	// Small alphabets, so there are many candidates of the first and the
+	// last bytes. The string is at the end of its buffer, so the tails of
+	// the blocks are not read past it.
+	const string alphabets[] = {"ab", "abc", "\r\n", "abcdefghijklmnopqrstuvwxyz", string("\0\xff\x80", 3)};
+	for (int i = 0; i < 200000; ++i) {
+		const string& alphabet = alphabets[rand() % 5];
+		const size_t len = rand() % (i % 10 == 0? 1024: 96);
+
+		string str;
+		for (size_t j = 0; j < len; ++j) {
+			str.push_back(alphabet[rand() % alphabet.size()]);
+		}
+
+		string needle;
+		const size_t k = rand() % 9;
+		if (len > 0 && rand() % 2 == 0) {
+			// The substring of |str|, it is found.
+			const size_t from = rand() % len;
+			needle = str.substr(from, k);
+		} else {
+			for (size_t j = 0; j < k; ++j) {
+				needle.push_back(alphabet[rand() % alphabet.size()]);
+			}
+		}
+
+		const size_t pos = rand() % (len + 3);
+		const size_t align = rand() % 64;
+
+		std::vector<char> buff(align + len);
+		std::copy(str.begin(), str.end(), buff.begin() + align);
+		StringPiece piece(buff.data() + align, len);
+
+		ASSERT_EQ(find_substring(piece, needle, pos), expect_find(str, needle, pos))
+			<< "str=" << str << " needle=" << needle << " pos=" << pos;
+	}
+}
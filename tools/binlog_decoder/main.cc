@@ -0,0 +1,56 @@
+// By: wlmwang
+// Date: Oct 17 2026
+
+#include "BinaryLogging.h"
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+using namespace annety;
+
+// Renders the binary logs of BinaryLogging to text (stdout).
+// The files are decoded in order, so the format sites that were written in
+// the previous (rotated) files are known.
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: binlog_decoder <file> [<file> ...]\n");
+		return 1;
+	}
+
+	BinaryLogDecoder decoder;
+	std::vector<char> data;
+	std::string text;
+	char buf[64 * 1024];
+
+	for (int i = 1; i < argc; ++i) {
+		FILE* fp = ::fopen(argv[i], "rb");
+		if (!fp) {
+			::perror(argv[i]);
+			return 1;
+		}
+
+		data.clear();
+		size_t n = 0;
+		while ((n = ::fread(buf, 1, sizeof buf, fp)) > 0) {
+			data.insert(data.end(), buf, buf + n);
+
+			text.clear();
+			ssize_t decoded = decoder.decode(data.data(), data.size(), &text);
+			if (decoded < 0) {
+				fprintf(stderr, "binlog_decoder: %s is corrupted\n", argv[i]);
+				::fclose(fp);
+				return 1;
+			}
+			::fwrite(text.data(), 1, text.size(), stdout);
+			data.erase(data.begin(), data.begin() + decoded);
+		}
+		::fclose(fp);
+
+		if (!data.empty()) {
+			fprintf(stderr, "binlog_decoder: %s is truncated (%zu bytes)\n", argv[i], data.size());
+		}
+	}
+	return 0;
+}